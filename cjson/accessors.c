@@ -30,6 +30,7 @@
 #include "accessors.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "bool.h"
 #include "bytes.h"
@@ -39,6 +40,47 @@
 
 #define JSON_TAB "    "
 
+// Returns a pointer to the characters of a `JSON_String` instance.
+//
+// The characters are only guaranteed to be `NULL` terminated if the string is
+// not a view (see `JSON_FLAG_STRING_VIEW`), use `JSON_StringLength()` to know
+// how many there are.  Inline strings (see `JSON_FLAG_STRING_INLINE`) live in
+// `json` itself so the returned pointer is only valid as long as `json` is.
+const char* JSON_StringData(const JSON* const json) {
+  if (json->flags & JSON_FLAG_STRING_VIEW)
+    return json->value.view.data;
+  if (json->flags & JSON_FLAG_STRING_INLINE)
+    return json->value.shortstr;
+  return json->value.string;
+}
+
+// Returns the number of characters in a `JSON_String` instance.
+size_t JSON_StringLength(const JSON* const json) {
+  if (json->flags & JSON_FLAG_STRING_VIEW)
+    return json->value.view.length;
+  if (json->flags & JSON_FLAG_STRING_INLINE)
+    return json->length;
+  return json->value.string ? strlen(json->value.string) : 0;
+}
+
+// Returns the number of elements of a `JSON_List` instance, whether they are
+// stored by value (see `JSON_FLAG_LIST_VALUES`) or as pointers.
+size_t JSON_ListSize(const JSON* const list) {
+  if (list->flags & JSON_FLAG_LIST_VALUES)
+    return list->value.values.size;
+  return list->value.list.size;
+}
+
+// Returns the element at `index` of a `JSON_List` instance, or `NULL` if there
+// is none.
+JSON* JSON_ListGet(const JSON* const list, const size_t index) {
+  if (index >= JSON_ListSize(list))
+    return NULL;
+  if (list->flags & JSON_FLAG_LIST_VALUES)
+    return list->value.values.data + index;
+  return (JSON*)list->value.list.data[index];
+}
+
 StringStream JSON_Stringify(JSON* const json, const bool_t prettify,
                             const size_t init_tab_pos,
                             const bool_t is_dict_valid) {
@@ -59,7 +101,8 @@ StringStream JSON_Stringify(JSON* const json, const bool_t prettify,
       StringStreamConcat(&stringified, JSON_NULL);
       break;
     case JSON_String:
-      StringStreamConcat(&stringified, "\"%s\"", json->value.string);
+      StringStreamConcat(&stringified, "\"%.*s\"", (int)JSON_StringLength(json),
+                         JSON_StringData(json));
       break;
     case JSON_Number:
       StringStreamConcat(&stringified, "%lld", json->value.number);
@@ -72,17 +115,16 @@ StringStream JSON_Stringify(JSON* const json, const bool_t prettify,
                          json->value.boolean ? JSON_TRUE : JSON_FALSE);
       break;
     case JSON_List: {
-      if (!json->value.list.size) {
+      const size_t size = JSON_ListSize(json);
+      if (!size) {
         StringStreamConcat(&stringified, "[]%s", __place_endl_if_prettify);
         break;
       }
 
       StringStreamConcat(&stringified, "[%s", __place_endl_if_prettify);
-      void* current = NULL;
-      VectorIterator vectorit = VectorIteratorNew(&json->value.list);
-      while ((current = VectorIteratorNext(&vectorit))) {
-        StringStream sstream =
-            JSON_Stringify((JSON*)current, prettify, init_tab_pos + 1, FALSE);
+      for (size_t i = 0; i < size; ++i) {
+        StringStream sstream = JSON_Stringify(JSON_ListGet(json, i), prettify,
+                                              init_tab_pos + 1, FALSE);
         StringStreamConcat(&stringified, "%s,%s", sstream.data,
                            __place_endl_if_prettify);
         StringStreamDealloc(&sstream);
@@ -113,12 +155,16 @@ StringStream JSON_Stringify(JSON* const json, const bool_t prettify,
           for (size_t i = 0; i < init_tab_pos; ++i)
             StringStreamConcat(&stringified, JSON_TAB);
         }
-        StringStreamConcat(&stringified, "\"%s\":%s", (char*)current->key,
-                           prettify ? " " : "");
+        // Keys put with `JSON_ObjectPutN()` are not terminated and may hold
+        // `NUL` bytes, so copy exactly `keylen` of them.
+        StringStreamConcat(&stringified, "\"");
+        StringStreamRead(&stringified, current->key, current->keylen);
+        StringStreamConcat(&stringified, "\":%s", prettify ? " " : "");
         StringStream sstream = JSON_Stringify((JSON*)current->value, prettify,
                                               init_tab_pos + 1, TRUE);
         StringStreamConcat(&stringified, "%s,%s", sstream.data,
                            __place_endl_if_prettify);
+        StringStreamDealloc(&sstream);
       }
 
       StringStreamRetreat(&stringified, prettify ? 2 : 1);
@@ -0,0 +1,292 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "allocator.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "bool.h"
+
+static void* LibcMalloc(void* ctx, size_t size) {
+  (void)ctx;
+  return malloc(size);
+}
+
+static void* LibcRealloc(void* ctx, void* ptr, size_t size) {
+  (void)ctx;
+  return realloc(ptr, size);
+}
+
+static void LibcFree(void* ctx, void* ptr) {
+  (void)ctx;
+  free(ptr);
+}
+
+static const Allocator kLibcAllocator = {.malloc = LibcMalloc,
+                                         .realloc = LibcRealloc,
+                                         .free = LibcFree,
+                                         .ctx = NULL};
+
+static const Allocator* default_allocator = &kLibcAllocator;
+
+// Returns the process-wide allocator, libc's unless `AllocatorSetDefault()`
+// replaced it.
+const Allocator* AllocatorGetDefault() { return default_allocator; }
+
+// Replaces the process-wide allocator, `NULL` restores libc's.
+//
+// Memory must be released by the allocator that allocated it, so the
+// process-wide allocator must only be replaced while no container or `JSON`
+// node allocated with it is alive, typically once at start-up.  The given
+// `allocator` must outlive its use.
+void AllocatorSetDefault(const Allocator* const allocator) {
+  default_allocator = allocator ? allocator : &kLibcAllocator;
+}
+
+void* AllocatorMalloc(const Allocator* const allocator, const size_t size) {
+  const Allocator* allocator_ = allocator ? allocator : default_allocator;
+  return allocator_->malloc(allocator_->ctx, size);
+}
+
+void* AllocatorCalloc(const Allocator* const allocator, const size_t count,
+                      const size_t size) {
+  if (size && count > SIZE_MAX / size)
+    return NULL;
+  void* ptr = AllocatorMalloc(allocator, count * size);
+  if (ptr)
+    memset(ptr, 0, count * size);
+  return ptr;
+}
+
+void* AllocatorRealloc(const Allocator* const allocator, void* const ptr,
+                       const size_t size) {
+  const Allocator* allocator_ = allocator ? allocator : default_allocator;
+  return allocator_->realloc(allocator_->ctx, ptr, size);
+}
+
+void AllocatorFree(const Allocator* const allocator, void* const ptr) {
+  if (ptr == NULL)
+    return;
+  const Allocator* allocator_ = allocator ? allocator : default_allocator;
+  allocator_->free(allocator_->ctx, ptr);
+}
+
+// Every block served through `AllocatorCounting()` is prefixed with its size
+// so that it can be taken off the counter when it is released.  The prefix
+// takes this many bytes to keep the block itself aligned.
+#define ALLOCATOR_COUNTER_PREFIX (1 << 4)
+
+static void* CountingMalloc(void* ctx, size_t size) {
+  AllocatorCounter* const counter = (AllocatorCounter*)ctx;
+  if (size > SIZE_MAX - ALLOCATOR_COUNTER_PREFIX)
+    return NULL;
+  u_int8_t* const ptr = (u_int8_t*)AllocatorMalloc(
+      counter->allocator, ALLOCATOR_COUNTER_PREFIX + size);
+  if (ptr == NULL)
+    return NULL;
+  *(size_t*)ptr = size;
+  __atomic_add_fetch(&counter->bytes, size, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&counter->blocks, 1, __ATOMIC_RELAXED);
+  return ptr + ALLOCATOR_COUNTER_PREFIX;
+}
+
+static void* CountingRealloc(void* ctx, void* ptr, size_t size) {
+  AllocatorCounter* const counter = (AllocatorCounter*)ctx;
+  if (ptr == NULL)
+    return CountingMalloc(ctx, size);
+  if (size > SIZE_MAX - ALLOCATOR_COUNTER_PREFIX)
+    return NULL;
+  u_int8_t* const block = (u_int8_t*)ptr - ALLOCATOR_COUNTER_PREFIX;
+  const size_t oldsize = *(size_t*)block;
+  u_int8_t* const block_ = (u_int8_t*)AllocatorRealloc(
+      counter->allocator, block, ALLOCATOR_COUNTER_PREFIX + size);
+  if (block_ == NULL)
+    return NULL;
+  *(size_t*)block_ = size;
+  __atomic_add_fetch(&counter->bytes, size, __ATOMIC_RELAXED);
+  __atomic_sub_fetch(&counter->bytes, oldsize, __ATOMIC_RELAXED);
+  return block_ + ALLOCATOR_COUNTER_PREFIX;
+}
+
+static void CountingFree(void* ctx, void* ptr) {
+  AllocatorCounter* const counter = (AllocatorCounter*)ctx;
+  if (ptr == NULL)
+    return;
+  u_int8_t* const block = (u_int8_t*)ptr - ALLOCATOR_COUNTER_PREFIX;
+  __atomic_sub_fetch(&counter->bytes, *(size_t*)block, __ATOMIC_RELAXED);
+  __atomic_sub_fetch(&counter->blocks, 1, __ATOMIC_RELAXED);
+  AllocatorFree(counter->allocator, block);
+}
+
+// Returns an `Allocator` that serves every request from `allocator`, or from
+// the process-wide allocator if `allocator` is `NULL`, while keeping `counter`
+// up to date with the bytes and blocks currently allocated through it.
+//
+// Installed with `AllocatorSetDefault()` once at start-up, before any container
+// or `JSON` node is allocated, it gives an O(1) running total of what every
+// `JSON` tree of the process holds, kept up to date by every constructor and
+// modifier.  `JSON` nodes, strings and keys always come from the process-wide
+// allocator, so the total covers the whole process and not a single document;
+// handed to a container instead, it only counts the buffers of that container.
+// Every block carries a small size prefix and the thread-local caches are
+// bypassed, so it costs a little more than the allocator it wraps and its
+// blocks must never be released once another allocator replaced it.
+// `counter` must outlive the `Allocator`.
+Allocator AllocatorCounting(AllocatorCounter* const counter,
+                            const Allocator* const allocator) {
+  counter->allocator = allocator ? allocator : default_allocator;
+  counter->bytes = 0;
+  counter->blocks = 0;
+  Allocator counting = {.malloc = CountingMalloc,
+                        .realloc = CountingRealloc,
+                        .free = CountingFree,
+                        .ctx = (void*)counter};
+  return counting;
+}
+
+// Returns the number of bytes currently allocated through `counter`.
+size_t AllocatorCounterBytes(const AllocatorCounter* const counter) {
+  return __atomic_load_n(&counter->bytes, __ATOMIC_RELAXED);
+}
+
+// Returns the number of blocks currently allocated through `counter`.
+size_t AllocatorCounterBlocks(const AllocatorCounter* const counter) {
+  return __atomic_load_n(&counter->blocks, __ATOMIC_RELAXED);
+}
+
+#define ALLOCATOR_CACHE_CLASSES (ALLOCATOR_CACHE_MAX_BLOCK_SIZE >> 3)
+
+// A released block waiting in a free-list, its first bytes link the next one.
+typedef struct AllocatorCacheBlock {
+  struct AllocatorCacheBlock* next;
+} AllocatorCacheBlock;
+
+// The free-lists of a thread, `blocks[i]` holds blocks of at least `(i + 1) *
+// 8` bytes.
+typedef struct AllocatorCache {
+  AllocatorCacheBlock* blocks[ALLOCATOR_CACHE_CLASSES];
+  size_t size;
+  bool_t registered;
+} AllocatorCache;
+
+static _Thread_local AllocatorCache cache;
+static pthread_key_t cache_key;
+static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+
+// Releases the blocks of `cache_` to libc.
+static void AllocatorCacheRelease(void* cache_) {
+  AllocatorCache* const cache__ = (AllocatorCache*)cache_;
+  for (size_t i = 0; i < ALLOCATOR_CACHE_CLASSES; ++i) {
+    while (cache__->blocks[i]) {
+      AllocatorCacheBlock* const next = cache__->blocks[i]->next;
+      free(cache__->blocks[i]);
+      cache__->blocks[i] = next;
+    }
+  }
+  cache__->size = 0;
+}
+
+static void AllocatorCacheCreateKey() {
+  pthread_key_create(&cache_key, AllocatorCacheRelease);
+}
+
+// Returns the calling thread's cache if blocks of `allocator` are cached,
+// `NULL` otherwise.
+//
+// The cache is registered to be released when the thread exits the first time
+// it is handed out.
+static AllocatorCache* AllocatorCacheOf(const Allocator* const allocator) {
+  if ((allocator ? allocator : default_allocator) != &kLibcAllocator)
+    return NULL;
+  if (cache.registered == FALSE) {
+    pthread_once(&cache_key_once, AllocatorCacheCreateKey);
+    if (pthread_setspecific(cache_key, &cache))
+      return NULL;
+    cache.registered = TRUE;
+  }
+  return &cache;
+}
+
+// Returns a block of at least `size` bytes of `allocator`, reusing one from the
+// calling thread's cache when there is one.
+void* AllocatorCacheMalloc(const Allocator* const allocator,
+                           const size_t size) {
+  AllocatorCache* const cache_ = AllocatorCacheOf(allocator);
+  if (cache_ == NULL || size == 0 || size > ALLOCATOR_CACHE_MAX_BLOCK_SIZE)
+    return AllocatorMalloc(allocator, size);
+  // Round up so that the block can later be cached under its own size.
+  const size_t index = (size - 1) >> 3;
+  AllocatorCacheBlock* const block = cache_->blocks[index];
+  if (block == NULL)
+    return AllocatorMalloc(allocator, (index + 1) << 3);
+  cache_->blocks[index] = block->next;
+  cache_->size -= (index + 1) << 3;
+  return block;
+}
+
+void* AllocatorCacheCalloc(const Allocator* const allocator, const size_t count,
+                           const size_t size) {
+  if (size && count > SIZE_MAX / size)
+    return NULL;
+  void* ptr = AllocatorCacheMalloc(allocator, count * size);
+  if (ptr)
+    memset(ptr, 0, count * size);
+  return ptr;
+}
+
+// Keeps the block `ptr` of at least `size` bytes in the calling thread's cache,
+// or releases it with `allocator` when it is not cached or the cache is full.
+void AllocatorCacheFree(const Allocator* const allocator, void* const ptr,
+                        const size_t size) {
+  if (ptr == NULL)
+    return;
+  AllocatorCache* const cache_ = AllocatorCacheOf(allocator);
+  // Round down, the block must hold whatever its class is asked for.
+  if (cache_ == NULL || size < sizeof(AllocatorCacheBlock) ||
+      size > ALLOCATOR_CACHE_MAX_BLOCK_SIZE ||
+      cache_->size + size > ALLOCATOR_CACHE_MAX_BYTES) {
+    AllocatorFree(allocator, ptr);
+    return;
+  }
+  const size_t index = (size >> 3) - 1;
+  AllocatorCacheBlock* const block = (AllocatorCacheBlock*)ptr;
+  block->next = cache_->blocks[index];
+  cache_->blocks[index] = block;
+  cache_->size += (index + 1) << 3;
+}
+
+// Releases every block cached by the calling thread to libc.
+void AllocatorCacheFlush() { AllocatorCacheRelease(&cache); }
+
+// Returns the number of bytes cached by the calling thread.
+size_t AllocatorCacheSize() { return cache.size; }
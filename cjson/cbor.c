@@ -0,0 +1,425 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "cbor.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "accessors.h"
+#include "allocator.h"
+#include "bool.h"
+#include "cjson.h"
+#include "data/map/map.h"
+#include "data/sstream/sstream.h"
+#include "data/vector/vector.h"
+#include "internal/endian.h"
+
+// clang-format off
+#define CBOR_MAJOR_UNSIGNED   0x00
+#define CBOR_MAJOR_NEGATIVE   0x01
+#define CBOR_MAJOR_BYTES      0x02
+#define CBOR_MAJOR_TEXT       0x03
+#define CBOR_MAJOR_ARRAY      0x04
+#define CBOR_MAJOR_MAP        0x05
+#define CBOR_MAJOR_TAG        0x06
+#define CBOR_MAJOR_SIMPLE     0x07
+
+#define CBOR_INFO_UINT8       24
+#define CBOR_INFO_UINT16      25
+#define CBOR_INFO_UINT32      26
+#define CBOR_INFO_UINT64      27
+#define CBOR_INFO_INDEFINITE  31
+
+#define CBOR_SIMPLE_FALSE     20
+#define CBOR_SIMPLE_TRUE      21
+#define CBOR_SIMPLE_NULL      22
+#define CBOR_SIMPLE_UNDEFINED 23
+#define CBOR_SIMPLE_FLOAT16   CBOR_INFO_UINT16
+#define CBOR_SIMPLE_FLOAT32   CBOR_INFO_UINT32
+#define CBOR_SIMPLE_FLOAT64   CBOR_INFO_UINT64
+// clang-format on
+
+// Writes the head of a data item i.e., its major type and its argument encoded
+// in the smallest width that can hold it.
+static bool_t CBORWriteHead(StringStream* const cbor, const u_int8_t major,
+                          const u_int64_t argument) {
+  u_int8_t head[9];
+  size_t width;
+  if (argument < CBOR_INFO_UINT8) {
+    head[0] = (u_int8_t)((major << 5) | argument);
+    width = 0;
+  } else if (argument <= UINT8_MAX) {
+    head[0] = (u_int8_t)((major << 5) | CBOR_INFO_UINT8);
+    width = 1;
+  } else if (argument <= UINT16_MAX) {
+    head[0] = (u_int8_t)((major << 5) | CBOR_INFO_UINT16);
+    width = 2;
+  } else if (argument <= UINT32_MAX) {
+    head[0] = (u_int8_t)((major << 5) | CBOR_INFO_UINT32);
+    width = 4;
+  } else {
+    head[0] = (u_int8_t)((major << 5) | CBOR_INFO_UINT64);
+    width = 8;
+  }
+  StoreBigEndian(head + 1, argument, width);
+  return StringStreamRead(cbor, head, width + 1) == SSTREAM_READ_SUCCESS;
+}
+
+// Writes a floating-point value in single precision if that loses nothing and
+// in double precision otherwise.
+static bool_t CBORWriteDecimal(StringStream* const cbor,
+                               const json_decimal_t decimal) {
+  u_int8_t item[9];
+  const float single = (float)decimal;
+  if ((json_decimal_t)single == decimal) {
+    u_int32_t bits;
+    memcpy(&bits, &single, sizeof(bits));
+    item[0] = (CBOR_MAJOR_SIMPLE << 5) | CBOR_SIMPLE_FLOAT32;
+    StoreBigEndian(item + 1, bits, 4);
+    return StringStreamRead(cbor, item, 5) == SSTREAM_READ_SUCCESS;
+  }
+  u_int64_t bits;
+  memcpy(&bits, &decimal, sizeof(bits));
+  item[0] = (CBOR_MAJOR_SIMPLE << 5) | CBOR_SIMPLE_FLOAT64;
+  StoreBigEndian(item + 1, bits, 8);
+  return StringStreamRead(cbor, item, 9) == SSTREAM_READ_SUCCESS;
+}
+
+static bool_t CBORWriteText(StringStream* const cbor, const char* const text,
+                            const size_t length) {
+  return CBORWriteHead(cbor, CBOR_MAJOR_TEXT, length) &&
+         StringStreamRead(cbor, text, length) == SSTREAM_READ_SUCCESS;
+}
+
+// Appends the CBOR (RFC 8949) encoding of `json` onto `cbor`.
+//
+// `JSON_type`s map onto the CBOR major types as follows:
+//
+//      JSON_Null     simple value 22 (null)
+//      JSON_Boolean  simple values 20 (false) and 21 (true)
+//      JSON_Number   major type 0 or 1 in the smallest width that fits
+//      JSON_Decimal  single precision float if lossless, double otherwise
+//      JSON_String   major type 3, text string
+//      JSON_List     major type 4 with a definite length of `Vector.size`
+//      JSON_Object   major type 5 with a definite length of `Map.entrieslen`
+//
+// Returns `FALSE` if an argument is `NULL` or if `cbor` could not grow to hold
+// the encoding, in which case it holds a truncated prefix of it.
+bool_t JSON_ToCBOR(StringStream* const cbor, const JSON* const json) {
+  if (cbor == NULL || json == NULL)
+    return FALSE;
+  switch (json->type) {
+    case JSON_Null:
+      return CBORWriteHead(cbor, CBOR_MAJOR_SIMPLE, CBOR_SIMPLE_NULL);
+    case JSON_Boolean:
+      return CBORWriteHead(
+          cbor, CBOR_MAJOR_SIMPLE,
+          json->value.boolean ? CBOR_SIMPLE_TRUE : CBOR_SIMPLE_FALSE);
+    case JSON_Number:
+      // A negative integer `n` is encoded as the argument `-1 - n` which
+      // always fits in an unsigned 64-bit integer.
+      if (json->value.number < 0)
+        return CBORWriteHead(cbor, CBOR_MAJOR_NEGATIVE,
+                             ~(u_int64_t)json->value.number);
+      return CBORWriteHead(cbor, CBOR_MAJOR_UNSIGNED,
+                           (u_int64_t)json->value.number);
+    case JSON_Decimal:
+      return CBORWriteDecimal(cbor, json->value.decimal);
+    case JSON_String:
+      return CBORWriteText(cbor, JSON_StringData(json),
+                           JSON_StringLength(json));
+    case JSON_List: {
+      const size_t size = JSON_ListSize(json);
+      if (!CBORWriteHead(cbor, CBOR_MAJOR_ARRAY, size))
+        return FALSE;
+      for (size_t i = 0; i < size; ++i) {
+        if (!JSON_ToCBOR(cbor, JSON_ListGet(json, i)))
+          return FALSE;
+      }
+      return TRUE;
+    }
+    case JSON_Object: {
+      Map* const object = (Map*)&json->value.object;
+      if (!CBORWriteHead(cbor, CBOR_MAJOR_MAP, object->entrieslen))
+        return FALSE;
+      MapEntry* current = NULL;
+      MapIterator object_it = MapIteratorNew(object);
+      while ((current = MapIteratorNext(&object_it))) {
+        if (!CBORWriteText(cbor, (const char*)current->key, current->keylen) ||
+            !JSON_ToCBOR(cbor, (JSON*)current->value))
+          return FALSE;
+      }
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+// Cursor over the bytes of the CBOR data item being decoded.
+typedef struct CBORReader {
+  const u_int8_t* cur;
+  const u_int8_t* end;
+} CBORReader;
+
+// Reads the head of the next data item into `major`, `info` and `argument`.
+//
+// For major type 7 the `argument` holds the raw bits of the floating-point
+// value or the simple value.
+static bool_t CBORReadHead(CBORReader* const reader, u_int8_t* const major,
+                           u_int8_t* const info, u_int64_t* const argument) {
+  if (reader->cur >= reader->end)
+    return FALSE;
+  *major = *reader->cur >> 5;
+  *info = *reader->cur & 0x1F;
+  ++(reader->cur);
+
+  size_t width;
+  switch (*info) {
+    case CBOR_INFO_UINT8:
+      width = 1;
+      break;
+    case CBOR_INFO_UINT16:
+      width = 2;
+      break;
+    case CBOR_INFO_UINT32:
+      width = 4;
+      break;
+    case CBOR_INFO_UINT64:
+      width = 8;
+      break;
+    default:
+      // Reserved values and indefinite lengths.
+      if (*info > CBOR_INFO_UINT64)
+        return FALSE;
+      *argument = *info;
+      return TRUE;
+  }
+  if ((size_t)(reader->end - reader->cur) < width)
+    return FALSE;
+  *argument = LoadBigEndian(reader->cur, width);
+  reader->cur += width;
+  return TRUE;
+}
+
+// Converts the bits of a IEEE 754 half precision value to a `double`.
+static json_decimal_t CBORHalfToDecimal(const u_int16_t half) {
+  const int exponent = (half >> 10) & 0x1F;
+  const int mantissa = half & 0x3FF;
+  json_decimal_t value;
+  if (exponent == 0)
+    value = ldexp(mantissa, -24);
+  else if (exponent != 0x1F)
+    value = ldexp(mantissa + 0x400, exponent - 25);
+  else
+    value = mantissa == 0 ? INFINITY : NAN;
+  return half & 0x8000 ? -value : value;
+}
+
+// Copies the `length` bytes of a text string into a `NUL` terminated string in
+// the free-store.
+static char* CBORCopyText(CBORReader* const reader, const u_int64_t length) {
+  if (length > (u_int64_t)(reader->end - reader->cur))
+    return NULL;
+  char* const text = (char*)AllocatorMalloc(NULL, (size_t)length + 1);
+  if (text == NULL)
+    return NULL;
+  memcpy(text, reader->cur, (size_t)length);
+  text[length] = '\0';
+  reader->cur += length;
+  return text;
+}
+
+// Reads an object key, which must be a definite length text string, and stores
+// its length in `keylen`.
+static char* CBORReadKey(CBORReader* const reader, size_t* const keylen) {
+  u_int8_t major, info;
+  u_int64_t length;
+  if (CBORReadHead(reader, &major, &info, &length) == FALSE ||
+      major != CBOR_MAJOR_TEXT)
+    return NULL;
+  *keylen = (size_t)length;
+  return CBORCopyText(reader, length);
+}
+
+// Releases a child that failed to decode along with whatever it holds.
+static void CBORFreeChild(JSON* const child) {
+  if (child == NULL)
+    return;
+  JSON_FreeDeep(child);
+  AllocatorCacheFree(NULL, child, sizeof(JSON));
+}
+
+static bool_t CBORReadItem(CBORReader* const reader, JSON* const json,
+                           const size_t depth);
+
+static bool_t CBORReadList(CBORReader* const reader, JSON* const json,
+                           const u_int64_t count, const size_t depth) {
+  // Every item takes at least a byte, so anything larger is malformed and
+  // must not make us pre-allocate a huge list.
+  if (count > (u_int64_t)(reader->end - reader->cur))
+    return FALSE;
+  *json = JSON_INIT_TYPE_SIZE(List, (size_t)count);
+  for (u_int64_t i = 0; i < count; ++i) {
+    JSON* const item = (JSON*)AllocatorCacheMalloc(NULL, sizeof(JSON));
+    if (item == NULL || CBORReadItem(reader, item, depth + 1) == FALSE) {
+      CBORFreeChild(item);
+      return FALSE;
+    }
+    JSON_ListAdd(json, item);
+  }
+  return TRUE;
+}
+
+static bool_t CBORReadObject(CBORReader* const reader, JSON* const json,
+                             const u_int64_t count, const size_t depth) {
+  if (count > (u_int64_t)(reader->end - reader->cur) / 2)
+    return FALSE;
+  *json = JSON_INIT_TYPE_SIZE(Object, (size_t)count);
+  for (u_int64_t i = 0; i < count; ++i) {
+    size_t keylen;
+    char* const key = CBORReadKey(reader, &keylen);
+    if (key == NULL || MapGetN(&json->value.object, key, keylen) != NULL) {
+      AllocatorFree(NULL, key);
+      return FALSE;
+    }
+    JSON* const value = (JSON*)AllocatorCacheMalloc(NULL, sizeof(JSON));
+    if (value == NULL || CBORReadItem(reader, value, depth + 1) == FALSE) {
+      CBORFreeChild(value);
+      AllocatorFree(NULL, key);
+      return FALSE;
+    }
+    JSON_ObjectPutN(json, key, keylen, value);
+  }
+  return TRUE;
+}
+
+// Decodes the next data item into `json`.  On failure `json` is left holding
+// whatever was decoded so far, ready to be released with `JSON_FreeDeep()`.
+static bool_t CBORReadItem(CBORReader* const reader, JSON* const json,
+                           const size_t depth) {
+  *json = JSON_INIT_TYPE(Null);
+  if (depth > JSON_CBOR_MAX_DEPTH)
+    return FALSE;
+
+  u_int8_t major, info;
+  u_int64_t argument;
+  if (CBORReadHead(reader, &major, &info, &argument) == FALSE)
+    return FALSE;
+
+  switch (major) {
+    case CBOR_MAJOR_UNSIGNED:
+      if (argument <= INT64_MAX)
+        *json = JSON_INIT_VAL(Number, (json_number_t)argument);
+      else
+        *json = JSON_INIT_VAL(Decimal, (json_decimal_t)argument);
+      return TRUE;
+    case CBOR_MAJOR_NEGATIVE:
+      if (argument <= INT64_MAX)
+        *json = JSON_INIT_VAL(Number, -1 - (json_number_t)argument);
+      else
+        *json = JSON_INIT_VAL(Decimal, -1.0 - (json_decimal_t)argument);
+      return TRUE;
+    case CBOR_MAJOR_TEXT:
+      if (argument > (u_int64_t)(reader->end - reader->cur))
+        return FALSE;
+      *json =
+          JSON_InitStringNImpl((json_string_t)reader->cur, (size_t)argument);
+      if (JSON_StringData(json) == NULL)
+        return FALSE;
+      reader->cur += argument;
+      return TRUE;
+    case CBOR_MAJOR_ARRAY:
+      return CBORReadList(reader, json, argument, depth);
+    case CBOR_MAJOR_MAP:
+      return CBORReadObject(reader, json, argument, depth);
+    case CBOR_MAJOR_TAG:
+      // Tags only add semantics `JSON` has no way to represent.
+      return CBORReadItem(reader, json, depth + 1);
+    case CBOR_MAJOR_SIMPLE:
+      switch (info) {
+        case CBOR_SIMPLE_FALSE:
+        case CBOR_SIMPLE_TRUE:
+          *json = JSON_INIT_VAL(Bool, info == CBOR_SIMPLE_TRUE);
+          return TRUE;
+        case CBOR_SIMPLE_NULL:
+        case CBOR_SIMPLE_UNDEFINED:
+          return TRUE;
+        case CBOR_SIMPLE_FLOAT16:
+          *json =
+              JSON_INIT_VAL(Decimal, CBORHalfToDecimal((u_int16_t)argument));
+          return TRUE;
+        case CBOR_SIMPLE_FLOAT32: {
+          const u_int32_t bits = (u_int32_t)argument;
+          float single;
+          memcpy(&single, &bits, sizeof(single));
+          *json = JSON_INIT_VAL(Decimal, single);
+          return TRUE;
+        }
+        case CBOR_SIMPLE_FLOAT64: {
+          json_decimal_t decimal;
+          memcpy(&decimal, &argument, sizeof(decimal));
+          *json = JSON_INIT_VAL(Decimal, decimal);
+          return TRUE;
+        }
+        default:
+          return FALSE;
+      }
+    default:
+      // Byte strings have no `JSON` counterpart.
+      return FALSE;
+  }
+}
+
+// Decodes the single CBOR data item held in `cbor` into `json`.
+//
+// Returns `TRUE` on success in which case the decoded tree lives in the
+// free-store and must be released with `JSON_FreeDeep()`.  Returns `FALSE` and
+// leaves a `JSON_Null` in `json` if `cbor` is not well-formed, holds trailing
+// bytes, or uses something that has no `JSON` counterpart such as byte
+// strings, indefinite lengths, non-string or duplicate object keys.  Tags are
+// skipped and `undefined` is decoded as `null`.
+bool_t JSON_FromCBOR(JSON* const json, const StringStream* const cbor) {
+  if (json == NULL)
+    return FALSE;
+  *json = JSON_INIT_TYPE(Null);
+  if (cbor == NULL || cbor->data == NULL)
+    return FALSE;
+  CBORReader reader = {.cur = (const u_int8_t*)cbor->data,
+                       .end = (const u_int8_t*)cbor->data + cbor->length};
+  if (CBORReadItem(&reader, json, 0) == FALSE || reader.cur != reader.end) {
+    JSON_FreeDeep(json);
+    *json = JSON_INIT_TYPE(Null);
+    return FALSE;
+  }
+  return TRUE;
+}
@@ -33,9 +33,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "allocator.h"
 #include "bool.h"
 #include "data/sstream/sstream.h"
 #include "data/vector/vector.h"
+#include "ref.h"
 
 // Returns a `JSON` instance of the given `type`.
 //
@@ -56,7 +58,10 @@ JSON JSON_InitTypeSize(const JSON_type type, const size_t size) {
       json.value.null = NULL;
       break;
     case JSON_String:
-      json.value.string = "";
+      // An empty inline string, which owns nothing to release.
+      json.flags = JSON_FLAG_STRING_INLINE;
+      json.length = 0;
+      json.value.shortstr[0] = '\0';
       break;
     case JSON_Decimal:
       json.value.decimal = 0.0;
@@ -87,15 +92,45 @@ JSON JSON_InitNullImpl() { return JSON_INIT_TYPE(Null); }
 
 // Creates a `JSON` instance from a `json_string_t` type.
 //
-// Allocates free-store memory to store the comming `string` instance. Assigns
-// `NULL` to the `json.value.string` instance if dynamic-memory allocation
-// failed.
+// Strings no longer than `JSON_SHORT_STRING_CAPACITY` are copied inline into
+// the `JSON` instance, longer ones into the free-store.  Assigns `NULL` to the
+// `json.value.string` instance if dynamic-memory allocation failed.  Use
+// `JSON_StringData()` and `JSON_StringLength()` to read the string back.
 JSON JSON_InitStringImpl(const json_string_t string) {
+  return JSON_InitStringNImpl(string, strlen(string));
+}
+
+// Same as `JSON_InitStringImpl()` but copies exactly `length` bytes of
+// `string`, which does not need to be `NULL` terminated.
+JSON JSON_InitStringNImpl(const json_string_t string, const size_t length) {
   JSON json = JSON_INIT_TYPE(String);
-  size_t strlen_ = strlen(string);
-  if ((json.value.string = (char*)malloc((strlen_ + 1) * sizeof(char))) == NULL)
+  if (length <= JSON_SHORT_STRING_CAPACITY) {
+    json.flags |= JSON_FLAG_STRING_INLINE;
+    json.length = (u_int8_t)length;
+    memcpy(json.value.shortstr, string, length);
+    json.value.shortstr[length] = '\0';
+    return json;
+  }
+  json.flags &= ~JSON_FLAG_STRING_INLINE;
+  if ((json.value.string = (char*)AllocatorMalloc(
+           NULL, (length + 1) * sizeof(char))) == NULL)
     return json;
-  strcpy(json.value.string, string);
+  memcpy(json.value.string, string, length);
+  json.value.string[length] = '\0';
+  return json;
+}
+
+// Creates a `JSON` instance viewing `length` bytes of `string` without copying
+// them.
+//
+// The returned `JSON` instance does not own `string`, which must outlive it and
+// does not need to be `NULL` terminated.  Use `JSON_StringData()` and
+// `JSON_StringLength()` to read strings that might be views.
+JSON JSON_InitStringViewImpl(const json_string_t string, const size_t length) {
+  JSON json = JSON_INIT_TYPE(String);
+  json.flags = JSON_FLAG_STRING_VIEW;
+  json.value.view.data = string;
+  json.value.view.length = length;
   return json;
 }
 
@@ -154,6 +189,21 @@ JSON JSON_InitListImpl(json_list_t* list) {
   return json;
 }
 
+// Returns an empty `JSON_List` instance storing its elements by value (see
+// `JSON_FLAG_LIST_VALUES`) with room for `capacity` elements before it grows.
+//
+// Elements added with `JSON_ListAdd()` are moved into the list and their
+// free-store container released, `JSON_ListAppend()` copies them without any
+// allocation of its own.
+JSON JSON_InitValueListImpl(const size_t capacity) {
+  JSON json = {.type = JSON_List, .flags = JSON_FLAG_LIST_VALUES};
+  json.value.values.data =
+      capacity ? (JSON*)AllocatorMalloc(NULL, capacity * sizeof(JSON)) : NULL;
+  json.value.values.size = 0;
+  json.value.values.capacity = json.value.values.data ? capacity : 0;
+  return json;
+}
+
 // Creates a `JSON` instance from a `json_object_t*` pointer type.
 //
 // Saves a `json_object_t*` value by going over the `buckets` attribute of
@@ -177,13 +227,15 @@ JSON* JSON_AllocType(JSON_type type) {
 }
 
 JSON* JSON_AllocTypeSize(JSON_type type, size_t size) {
-  JSON* json = (JSON*)(malloc(size));
+  JSON* json = (JSON*)(AllocatorCacheMalloc(NULL, size));
+  json->type = type;
+  json->flags = 0;
   switch (type) {
     case JSON_Null:
       json->value.null = NULL;
       break;
     case JSON_String:
-      json->value.string = (char*)(malloc(size * sizeof(char)));
+      json->value.string = (char*)(AllocatorMalloc(NULL, size * sizeof(char)));
       break;
     case JSON_Decimal:
       json->value.decimal = 0.0;
@@ -204,67 +256,120 @@ JSON* JSON_AllocTypeSize(JSON_type type, size_t size) {
   return json;
 }
 
-void JSON_Free(JSON* const json) {
-  switch (json->type) {
-    case JSON_String: {
-      free(json->value.string);
-      break;
-    }
-    case JSON_List: {
-      void* current = NULL;
-      VectorIterator vector_it = VectorIteratorNew(&json->value.list);
-      while ((current = VectorIteratorNext(&vector_it)))
-        JSON_Free((JSON*)current);
-      VectorFree(&json->value.list);
-      break;
-    }
-    case JSON_Object: {
-      MapEntry* current = NULL;
-      MapIterator object_it = MapIteratorNew(&json->value.object);
-      while ((current = MapIteratorNext(&object_it)))
-        JSON_Free((JSON*)current);
-      MapFree(&json->value.object);
-      break;
-    }
-    case JSON_Number: {
-      json->value.number = 0;
-      break;
-    }
-    case JSON_Decimal: {
-      json->value.decimal = 0.0;
-      break;
-    }
-    case JSON_Boolean: {
-      json->value.boolean = FALSE;
-      break;
-    }
-    case JSON_Null: {
-      json->value.null = NULL;
-      break;
+// A pending step of `JSON_Free()` or `JSON_FreeDeep()`.
+typedef struct FreeTask {
+  void* ptr;
+  u_int8_t kind;
+} FreeTask;
+
+// clang-format off
+// `FREE_TASK_VALUE`:  release what the node `ptr` holds.
+// `FREE_TASK_NODE`:   release what the node `ptr` holds, then the node.
+// `FREE_TASK_VALUES`: release the element array `ptr` of a list storing its
+//                     elements by value, once its elements are done with.
+#define FREE_TASK_VALUE   0
+#define FREE_TASK_NODE    1
+#define FREE_TASK_VALUES  2
+// clang-format on
+
+// Tasks kept on the call stack before the work stack moves to the free-store.
+#define FREE_STACK_INLINE_SIZE (1 << 6)
+
+// The explicit work stack trees are torn down with, so that releasing a tree
+// takes constant call stack space whatever its depth.
+typedef struct FreeStack {
+  FreeTask* tasks;
+  size_t size;
+  size_t capacity;
+  FreeTask inline_tasks[FREE_STACK_INLINE_SIZE];
+} FreeStack;
+
+static void FreeTree(void* const ptr, const u_int8_t kind, const bool_t deep);
+
+// Pushes a task onto `stack`, returns `FALSE` if the stack cannot grow.
+static bool_t FreeStackPush(FreeStack* const stack, void* const ptr,
+                            const u_int8_t kind) {
+  if (stack->size == stack->capacity) {
+    const size_t capacity = stack->capacity * 2;
+    FreeTask* tasks;
+    if (stack->tasks == stack->inline_tasks) {
+      tasks = (FreeTask*)AllocatorMalloc(NULL, capacity * sizeof(FreeTask));
+      if (tasks)
+        memcpy(tasks, stack->tasks, stack->size * sizeof(FreeTask));
+    } else {
+      tasks = (FreeTask*)AllocatorRealloc(NULL, stack->tasks,
+                                          capacity * sizeof(FreeTask));
     }
+    if (tasks == NULL)
+      return FALSE;
+    stack->tasks = tasks;
+    stack->capacity = capacity;
   }
+  stack->tasks[stack->size].ptr = ptr;
+  stack->tasks[stack->size].kind = kind;
+  ++stack->size;
+  return TRUE;
 }
 
-void JSON_FreeDeep(JSON* const json) {
+// Pushes the task releasing the child `json`, or carries it out right away
+// with a stack of its own if `stack` cannot grow.
+static void FreeStackPushChild(FreeStack* const stack, JSON* const json,
+                               const u_int8_t kind, const bool_t deep) {
+  if (FreeStackPush(stack, json, kind) == FALSE)
+    FreeTree(json, kind, deep);
+}
+
+// Releases what `json` holds, pushing its children onto `stack` rather than
+// descending into them.  With `deep` the child nodes and the object keys are
+// released too.
+static void FreeValue(FreeStack* const stack, JSON* const json,
+                      const bool_t deep) {
+  if (json->flags & JSON_FLAG_SHARED) {
+    JSON_RefDetach(json);
+    return;
+  }
   switch (json->type) {
     case JSON_String: {
-      free(json->value.string);
+      if (!(json->flags & (JSON_FLAG_STRING_VIEW | JSON_FLAG_STRING_INLINE)))
+        AllocatorFree(NULL, json->value.string);
       break;
     }
     case JSON_List: {
-      void* current = NULL;
-      VectorIterator vector_it = VectorIteratorNew(&json->value.list);
-      while ((current = VectorIteratorNext(&vector_it)))
-        JSON_FreeDeep((JSON*)current);
-      VectorFreeDeep(&json->value.list);
+      if (json->flags & JSON_FLAG_LIST_VALUES) {
+        // Elements stored by value are not free-store containers of their own,
+        // only what they hold is released, before the array they live in.
+        json_values_t* const values = &json->value.values;
+        if (values->data &&
+            FreeStackPush(stack, values->data, FREE_TASK_VALUES) == FALSE) {
+          for (size_t i = 0; i < values->size; ++i)
+            FreeTree(values->data + i, FREE_TASK_VALUE, deep);
+          AllocatorFree(NULL, values->data);
+        } else {
+          for (size_t i = 0; i < values->size; ++i)
+            FreeStackPushChild(stack, values->data + i, FREE_TASK_VALUE, deep);
+        }
+        values->data = NULL;
+        values->size = values->capacity = 0;
+        break;
+      }
+      Vector* const list = &json->value.list;
+      for (size_t i = 0; i < list->size; ++i)
+        FreeStackPushChild(stack, (JSON*)list->data[i],
+                           deep ? FREE_TASK_NODE : FREE_TASK_VALUE, deep);
+      VectorFree(list);
       break;
     }
     case JSON_Object: {
+      Map* const object = &json->value.object;
       MapEntry* current = NULL;
-      MapIterator object_it = MapIteratorNew(&json->value.object);
-      while ((current = MapIteratorNext(&object_it)))
-        JSON_FreeDeep((JSON*)current);
-      MapFreeDeep(&json->value.object);
+      MapIterator object_it = MapIteratorNew(object);
+      while ((current = MapIteratorNext(&object_it))) {
+        FreeStackPushChild(stack, (JSON*)current->value,
+                           deep ? FREE_TASK_NODE : FREE_TASK_VALUE, deep);
+        if (deep)
+          AllocatorFree(object->allocator, current->key);
+      }
+      MapFree(object);
       break;
     }
     case JSON_Number: {
@@ -285,3 +390,43 @@ void JSON_FreeDeep(JSON* const json) {
     }
   }
 }
+
+// Carries out the task `kind` on `ptr` and everything it leads to.
+static void FreeTree(void* const ptr, const u_int8_t kind, const bool_t deep) {
+  FreeStack stack;
+  stack.tasks = stack.inline_tasks;
+  stack.size = 0;
+  stack.capacity = FREE_STACK_INLINE_SIZE;
+  FreeStackPush(&stack, ptr, kind);
+  while (stack.size) {
+    const FreeTask task = stack.tasks[--stack.size];
+    if (task.kind == FREE_TASK_VALUES) {
+      AllocatorFree(NULL, task.ptr);
+      continue;
+    }
+    JSON* const json = (JSON*)task.ptr;
+    // Attached shared trees are not ours to release, only our reference.
+    const bool_t shared = json->flags & JSON_FLAG_SHARED;
+    FreeValue(&stack, json, deep);
+    if (task.kind == FREE_TASK_NODE && !shared)
+      AllocatorCacheFree(NULL, json, sizeof(JSON));
+  }
+  if (stack.tasks != stack.inline_tasks)
+    AllocatorFree(NULL, stack.tasks);
+}
+
+// Releases what `json` holds and what its children hold, but not the child
+// nodes themselves nor the object keys.
+//
+// The tree is walked with an explicit work stack, so its depth is bounded by
+// the free-store rather than by the call stack.
+void JSON_Free(JSON* const json) { FreeTree(json, FREE_TASK_VALUE, FALSE); }
+
+// Releases what `json` holds along with every child node and object key below
+// it, the node `json` itself is left to the caller.
+//
+// The tree is walked with an explicit work stack, so its depth is bounded by
+// the free-store rather than by the call stack.
+void JSON_FreeDeep(JSON* const json) {
+  FreeTree(json, FREE_TASK_VALUE, TRUE);
+}
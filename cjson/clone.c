@@ -0,0 +1,210 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "clone.h"
+
+#include <string.h>
+#include <sys/types.h>
+
+#include "accessors.h"
+#include "allocator.h"
+#include "cjson.h"
+#include "data/map/iterators.h"
+#include "data/map/map.h"
+#include "data/map/ops.h"
+#include "data/vector/vector.h"
+
+// What a clone is made of, counted by `CloneMeasure()`.  Every region of the
+// block is a multiple of pointer alignment in size except for the characters,
+// which come last.
+typedef struct CloneSize {
+  size_t nodes;
+  // The bytes of the buckets of the maps.
+  size_t tables;
+  size_t slots;
+  size_t chars;
+} CloneSize;
+
+// The next free item of each region of the block while it is being filled.
+typedef struct CloneWriter {
+  JSON* nodes;
+  char* tables;
+  void** slots;
+  char* chars;
+} CloneWriter;
+
+// Returns the characters of the string `json` has to copy into the block, or
+// `NULL` if there are none, i.e. it is stored inline.
+static const char* CloneStringData(const JSON* const json) {
+  if (json->flags & JSON_FLAG_STRING_INLINE)
+    return NULL;
+  return JSON_StringData(json);
+}
+
+// Adds what the value of `json` needs, not counting the node itself, to `size`.
+static void CloneMeasure(const JSON* const json, CloneSize* const size) {
+  switch (json->type) {
+    case JSON_String:
+      if (CloneStringData(json))
+        size->chars += JSON_StringLength(json) + 1;
+      break;
+    case JSON_List: {
+      const size_t listsize = JSON_ListSize(json);
+      size->nodes += listsize;
+      if (!(json->flags & JSON_FLAG_LIST_VALUES))
+        size->slots += listsize;
+      for (size_t i = 0; i < listsize; ++i)
+        CloneMeasure(JSON_ListGet(json, i), size);
+      break;
+    }
+    case JSON_Object: {
+      const Map* const object = &json->value.object;
+      size->nodes += object->entrieslen;
+      size->tables +=
+          MapBucketsSize(MapComputeBucketsLen(object->entrieslen));
+      MapEntry* current = NULL;
+      MapIterator object_it = MapIteratorNew((Map*)object);
+      while ((current = MapIteratorNext(&object_it))) {
+        size->chars += current->keylen + 1;
+        CloneMeasure((const JSON*)current->value, size);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Returns a copy of the `length` characters of `data` taken from the block.
+static char* CloneChars(CloneWriter* const writer, const char* const data,
+                        const size_t length) {
+  char* const chars = writer->chars;
+  memcpy(chars, data, length);
+  chars[length] = '\0';
+  writer->chars += length + 1;
+  return chars;
+}
+
+// Copies the value of `src` into the node `dest` of the block, taking whatever
+// else it needs from `writer`.
+static void CloneCopy(CloneWriter* const writer, JSON* const dest,
+                      const JSON* const src) {
+  memcpy(dest, src, sizeof(JSON));
+  dest->flags &= ~(JSON_FLAG_SHARED | JSON_FLAG_STRING_VIEW);
+  switch (src->type) {
+    case JSON_String: {
+      const char* const data = CloneStringData(src);
+      if (data)
+        dest->value.string = CloneChars(writer, data, JSON_StringLength(src));
+      break;
+    }
+    case JSON_List: {
+      const size_t size = JSON_ListSize(src);
+      JSON* const elements = writer->nodes;
+      writer->nodes += size;
+      if (src->flags & JSON_FLAG_LIST_VALUES) {
+        dest->value.values.data = size ? elements : NULL;
+        dest->value.values.size = dest->value.values.capacity = size;
+      } else {
+        Vector list = {.data = writer->slots, .size = size, .capacity = size};
+        writer->slots += size;
+        for (size_t i = 0; i < size; ++i)
+          list.data[i] = elements + i;
+        dest->value.list = list;
+      }
+      for (size_t i = 0; i < size; ++i)
+        CloneCopy(writer, elements + i, JSON_ListGet(src, i));
+      break;
+    }
+    case JSON_Object: {
+      const Map* const object = &src->value.object;
+      const size_t bucketslen = MapComputeBucketsLen(object->entrieslen);
+      // clang-format off
+      Map map = {.hash = object->hash, .keycmp = object->keycmp,
+                 .buckets = (MapEntry*)writer->tables,
+                 .bucketslen = bucketslen, .entrieslen = 0};
+      // clang-format on
+      writer->tables += MapBucketsSize(bucketslen);
+      memset(map.buckets, 0, MapBucketsSize(bucketslen));
+      MapEntry* current = NULL;
+      MapIterator object_it = MapIteratorNew((Map*)object);
+      while ((current = MapIteratorNext(&object_it))) {
+        JSON* const value = writer->nodes++;
+        MapEntry entry = {
+            .key = CloneChars(writer, (const char*)current->key,
+                              current->keylen),
+            .value = value,
+            .hash = current->hash,
+            .keylen = current->keylen};
+        MapPutEntry(&map, &entry);
+        CloneCopy(writer, value, (const JSON*)current->value);
+      }
+      dest->value.object = map;
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Returns a deep copy of the tree under `json` whose nodes, map entries,
+// bucket arrays, list buffers and strings all live in a single free-store
+// block, or `NULL` if the free-store is exhausted.
+//
+// The tree is measured first so that the block is allocated once and every map
+// is built with the buckets its final size needs.  Shared trees (see
+// `JSON_Ref`) and string views are copied too, the clone depends on nothing
+// but its own block.
+//
+// Like the nodes of a `JSON_Document`, the nodes of a clone can be read with
+// every accessor but must never be modified or passed to `JSON_Free()` or
+// `JSON_FreeDeep()`; the whole clone is released at once by
+// `JSON_CloneFree()`.
+JSON* JSON_Clone(const JSON* const json) {
+  if (json == NULL)
+    return NULL;
+  CloneSize size = {.nodes = 1, .tables = 0, .slots = 0, .chars = 0};
+  CloneMeasure(json, &size);
+  const size_t nodes = size.nodes * sizeof(JSON);
+  const size_t slots = size.slots * sizeof(void*);
+  char* const block =
+      (char*)AllocatorMalloc(NULL, nodes + size.tables + slots + size.chars);
+  if (block == NULL)
+    return NULL;
+  CloneWriter writer = {.nodes = (JSON*)block,
+                        .tables = block + nodes,
+                        .slots = (void**)(block + nodes + size.tables),
+                        .chars = block + nodes + size.tables + slots};
+  JSON* const root = writer.nodes++;
+  CloneCopy(&writer, root, json);
+  return root;
+}
+
+// Releases a clone returned by `JSON_Clone()`.
+void JSON_CloneFree(JSON* const clone) { AllocatorFree(NULL, clone); }
@@ -0,0 +1,394 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "columns.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "accessors.h"
+#include "allocator.h"
+#include "bool.h"
+#include "cjson.h"
+#include "data/map/map.h"
+#include "data/vector/vector.h"
+#include "modifiers.h"
+
+#define COLUMNS_DEFAULT_SIZE (1 << 3)
+
+#define COLUMN_BIT_TEST(bitmap, row) ((bitmap)[(row) >> 3] & (1 << ((row)&7)))
+#define COLUMN_BIT_CLEAR(bitmap, row) \
+  ((bitmap)[(row) >> 3] &= (u_int8_t)~(1 << ((row)&7)))
+
+// Returns whether the key of `column` is the `keylen` bytes at `key`.
+static inline bool_t ColumnHasKey(const JSON_Column* const column,
+                                  const char* const key, const size_t keylen) {
+  return column->keylen == keylen && memcmp(column->key, key, keylen) == 0;
+}
+
+// Returns the index of the column of the `keylen` bytes at `key`, or
+// `ncolumns` if there is none.
+//
+// Records of the same shape iterate their keys in the same order, so the column
+// at `hint` i.e., the position of `key` in its object is tried first.
+static size_t ColumnsLookup(const JSON_Column* const columns,
+                            const size_t ncolumns, const char* const key,
+                            const size_t keylen, const size_t hint) {
+  if (hint < ncolumns && ColumnHasKey(columns + hint, key, keylen))
+    return hint;
+  for (size_t i = 0; i < ncolumns; ++i)
+    if (ColumnHasKey(columns + i, key, keylen))
+      return i;
+  return ncolumns;
+}
+
+// Returns the type of a column holding values of both `column` and `value`
+// types, or `JSON_List` if they cannot share a column.
+static JSON_type ColumnsMergeType(const JSON_type column,
+                                  const JSON_type value) {
+  if (value == JSON_List || value == JSON_Object)
+    return JSON_List;
+  if (column == JSON_Null || value == JSON_Null || column == value)
+    return column == JSON_Null ? value : column;
+  if ((column == JSON_Number && value == JSON_Decimal) ||
+      (column == JSON_Decimal && value == JSON_Number))
+    return JSON_Decimal;
+  return JSON_List;
+}
+
+// Appends a column for the `keylen` bytes at `key` growing `columns` and
+// `charlens` as needed.
+static bool_t ColumnsAppend(JSON_Columns* const columns,
+                            size_t* const capacity, size_t** const charlens,
+                            const char* const key, const size_t keylen) {
+  if (columns->ncolumns == *capacity) {
+    const size_t capacity_ = *capacity ? *capacity * 2 : COLUMNS_DEFAULT_SIZE;
+    JSON_Column* const columns_ = (JSON_Column*)AllocatorRealloc(
+        NULL, columns->columns, capacity_ * sizeof(JSON_Column));
+    if (columns_ == NULL)
+      return FALSE;
+    columns->columns = columns_;
+    size_t* const charlens_ =
+        (size_t*)AllocatorRealloc(NULL, *charlens, capacity_ * sizeof(size_t));
+    if (charlens_ == NULL)
+      return FALSE;
+    *charlens = charlens_;
+    *capacity = capacity_;
+  }
+  JSON_Column* const column = columns->columns + columns->ncolumns;
+  memset(column, 0, sizeof(JSON_Column));
+  column->type = JSON_Null;
+  if ((column->key = (char*)AllocatorMalloc(NULL, keylen + 1)) == NULL)
+    return FALSE;
+  memcpy(column->key, key, keylen);
+  column->key[keylen] = '\0';
+  column->keylen = keylen;
+  (*charlens)[columns->ncolumns++] = 0;
+  return TRUE;
+}
+
+// Discovers the columns of `list` and their types, and sums the length of the
+// strings of every `JSON_String` column into `charlens`.
+static bool_t ColumnsDiscover(JSON_Columns* const columns,
+                              const JSON* const list,
+                              size_t** const charlens) {
+  size_t capacity = 0;
+  const size_t rows = JSON_ListSize(list);
+  for (size_t row = 0; row < rows; ++row) {
+    const JSON* const record = JSON_ListGet(list, row);
+    if (record->type != JSON_Object)
+      return FALSE;
+    size_t position = 0;
+    MapEntry* current = NULL;
+    MapIterator object_it = MapIteratorNew((Map*)&record->value.object);
+    while ((current = MapIteratorNext(&object_it))) {
+      const char* const key = (const char*)current->key;
+      const JSON* const value = (const JSON*)current->value;
+      size_t i = ColumnsLookup(columns->columns, columns->ncolumns, key,
+                               current->keylen, position++);
+      if (i == columns->ncolumns &&
+          ColumnsAppend(columns, &capacity, charlens, key, current->keylen) ==
+              FALSE)
+        return FALSE;
+      JSON_Column* const column = columns->columns + i;
+      if ((column->type = ColumnsMergeType(column->type, value->type)) ==
+          JSON_List)
+        return FALSE;
+      if (value->type == JSON_String)
+        (*charlens)[i] += JSON_StringLength(value);
+    }
+  }
+  return TRUE;
+}
+
+// Allocates the bitmaps and the values of `column`, every row starts out as
+// absent.
+static bool_t ColumnsAllocate(JSON_Column* const column, const size_t rows,
+                              const size_t charlen) {
+  const size_t bitmaplen = (rows + 7) / 8;
+  const size_t bitmapsize = bitmaplen ? bitmaplen : 1;
+  if ((column->nulls = (u_int8_t*)AllocatorMalloc(NULL, bitmapsize)) == NULL ||
+      (column->absent = (u_int8_t*)AllocatorMalloc(NULL, bitmapsize)) == NULL)
+    return FALSE;
+  memset(column->nulls, 0xFF, bitmaplen);
+  memset(column->absent, 0xFF, bitmaplen);
+  switch (column->type) {
+    case JSON_Number:
+      column->values.numbers = (json_number_t*)AllocatorCalloc(
+          NULL, rows ? rows : 1, sizeof(json_number_t));
+      return column->values.numbers != NULL;
+    case JSON_Decimal:
+      column->values.decimals = (json_decimal_t*)AllocatorCalloc(
+          NULL, rows ? rows : 1, sizeof(json_decimal_t));
+      return column->values.decimals != NULL;
+    case JSON_Boolean:
+      column->values.booleans =
+          (u_int8_t*)AllocatorCalloc(NULL, rows ? rows : 1, 1);
+      return column->values.booleans != NULL;
+    case JSON_String:
+      column->values.strings.offsets =
+          (u_int64_t*)AllocatorCalloc(NULL, rows + 1, sizeof(u_int64_t));
+      column->values.strings.chars =
+          (char*)AllocatorMalloc(NULL, charlen ? charlen : 1);
+      return column->values.strings.offsets != NULL &&
+             column->values.strings.chars != NULL;
+    default:
+      return TRUE;
+  }
+}
+
+// Stores `value` at `row` of `column`.  The length of a string is stored at
+// `offsets[row + 1]` for the offsets to be accumulated once every row is
+// stored, `cursor` is where the characters of the next string go.
+static void ColumnsStore(JSON_Column* const column, const size_t row,
+                         const JSON* const value, size_t* const cursor) {
+  COLUMN_BIT_CLEAR(column->absent, row);
+  if (value->type == JSON_Null)
+    return;
+  COLUMN_BIT_CLEAR(column->nulls, row);
+  switch (column->type) {
+    case JSON_Number:
+      column->values.numbers[row] = value->value.number;
+      break;
+    case JSON_Decimal:
+      column->values.decimals[row] = value->type == JSON_Number
+                                         ? (json_decimal_t)value->value.number
+                                         : value->value.decimal;
+      break;
+    case JSON_Boolean:
+      column->values.booleans[row] = value->value.boolean ? 1 : 0;
+      break;
+    case JSON_String: {
+      const size_t length = JSON_StringLength(value);
+      memcpy(column->values.strings.chars + *cursor, JSON_StringData(value),
+             length);
+      column->values.strings.offsets[row + 1] = length;
+      *cursor += length;
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Shreds the `JSON_Object`s of `list` into `columns`.
+//
+// `JSON_Number` and `JSON_Decimal` values of the same key are widened into a
+// `JSON_Decimal` column.  Returns `FALSE` and leaves `columns` empty if `list`
+// is not a list of objects, if a key holds a list, an object or otherwise
+// mixed types, or if the free-store is exhausted.  Release `columns` with
+// `JSON_ColumnsFree()`.
+bool_t JSON_ColumnsFromList(JSON_Columns* const columns,
+                            const JSON* const list) {
+  if (columns == NULL)
+    return FALSE;
+  memset(columns, 0, sizeof(JSON_Columns));
+  if (list == NULL || list->type != JSON_List)
+    return FALSE;
+  const size_t rows = JSON_ListSize(list);
+  size_t* charlens = NULL;
+  if (ColumnsDiscover(columns, list, &charlens) == FALSE)
+    goto fail;
+  columns->rows = rows;
+  for (size_t i = 0; i < columns->ncolumns; ++i) {
+    if (ColumnsAllocate(columns->columns + i, rows, charlens[i]) == FALSE)
+      goto fail;
+    charlens[i] = 0;
+  }
+
+  for (size_t row = 0; row < rows; ++row) {
+    const JSON* const record = JSON_ListGet(list, row);
+    size_t position = 0;
+    MapEntry* current = NULL;
+    MapIterator object_it = MapIteratorNew((Map*)&record->value.object);
+    while ((current = MapIteratorNext(&object_it))) {
+      const size_t i =
+          ColumnsLookup(columns->columns, columns->ncolumns,
+                        (const char*)current->key, current->keylen, position++);
+      ColumnsStore(columns->columns + i, row, (const JSON*)current->value,
+                   charlens + i);
+    }
+  }
+  for (size_t i = 0; i < columns->ncolumns; ++i) {
+    JSON_Column* const column = columns->columns + i;
+    if (column->type != JSON_String)
+      continue;
+    for (size_t row = 0; row < rows; ++row)
+      column->values.strings.offsets[row + 1] +=
+          column->values.strings.offsets[row];
+  }
+  AllocatorFree(NULL, charlens);
+  return TRUE;
+
+fail:
+  AllocatorFree(NULL, charlens);
+  JSON_ColumnsFree(columns);
+  return FALSE;
+}
+
+// Returns a free-store `JSON` instance holding `row` of `column`.
+static JSON* ColumnsLoad(const JSON_Column* const column, const size_t row) {
+  JSON* const value = (JSON*)AllocatorCacheMalloc(NULL, sizeof(JSON));
+  if (value == NULL)
+    return NULL;
+  if (COLUMN_BIT_TEST(column->nulls, row)) {
+    *value = JSON_INIT_TYPE(Null);
+    return value;
+  }
+  switch (column->type) {
+    case JSON_Number:
+      *value = JSON_INIT_VAL(Number, column->values.numbers[row]);
+      break;
+    case JSON_Decimal:
+      *value = JSON_INIT_VAL(Decimal, column->values.decimals[row]);
+      break;
+    case JSON_Boolean:
+      *value = JSON_INIT_VAL(Bool, column->values.booleans[row]);
+      break;
+    case JSON_String: {
+      const u_int64_t* const offsets = column->values.strings.offsets;
+      *value = JSON_InitStringNImpl(
+          column->values.strings.chars + offsets[row],
+          offsets[row + 1] - offsets[row]);
+      if (JSON_StringData(value) == NULL) {
+        AllocatorFree(NULL, value);
+        return NULL;
+      }
+      break;
+    }
+    default:
+      *value = JSON_INIT_TYPE(Null);
+      break;
+  }
+  return value;
+}
+
+// Rebuilds the `JSON_List` of `JSON_Object`s shredded into `columns`.
+//
+// Absent rows are left out of their objects while the other null rows become
+// `JSON_Null` values.  The list lives in the free-store and must be released
+// with `JSON_FreeDeep()`.  Returns `FALSE` and leaves a `JSON_Null` in `list`
+// if the free-store is exhausted.
+bool_t JSON_ColumnsToList(JSON* const list, const JSON_Columns* const columns) {
+  if (list == NULL)
+    return FALSE;
+  *list = JSON_INIT_TYPE(Null);
+  if (columns == NULL)
+    return FALSE;
+  *list = JSON_INIT_TYPE_SIZE(List, columns->rows);
+  for (size_t row = 0; row < columns->rows; ++row) {
+    JSON* const record = (JSON*)AllocatorCacheMalloc(NULL, sizeof(JSON));
+    if (record == NULL)
+      goto fail;
+    *record = JSON_INIT_TYPE_SIZE(Object, columns->ncolumns);
+    JSON_ListAdd(list, record);
+    for (size_t i = 0; i < columns->ncolumns; ++i) {
+      const JSON_Column* const column = columns->columns + i;
+      if (COLUMN_BIT_TEST(column->absent, row))
+        continue;
+      char* const key = (char*)AllocatorMalloc(NULL, column->keylen + 1);
+      JSON* const value = ColumnsLoad(column, row);
+      if (key == NULL || value == NULL) {
+        AllocatorFree(NULL, key);
+        if (value != NULL) {
+          JSON_FreeDeep(value);
+          AllocatorCacheFree(NULL, value, sizeof(JSON));
+        }
+        goto fail;
+      }
+      memcpy(key, column->key, column->keylen + 1);
+      JSON_ObjectPutN(record, key, column->keylen, value);
+    }
+  }
+  return TRUE;
+
+fail:
+  JSON_FreeDeep(list);
+  *list = JSON_INIT_TYPE(Null);
+  return FALSE;
+}
+
+// Returns the column of `key`, or `NULL` if none of the objects had `key`.
+const JSON_Column* JSON_ColumnsFind(const JSON_Columns* const columns,
+                                    const char* const key) {
+  if (columns == NULL || key == NULL)
+    return NULL;
+  const size_t i =
+      ColumnsLookup(columns->columns, columns->ncolumns, key, strlen(key), 0);
+  return i < columns->ncolumns ? columns->columns + i : NULL;
+}
+
+// Returns `TRUE` if `row` of `column` is null or absent.
+bool_t JSON_ColumnIsNull(const JSON_Column* const column, const size_t row) {
+  if (column == NULL || column->nulls == NULL)
+    return TRUE;
+  return COLUMN_BIT_TEST(column->nulls, row) ? TRUE : FALSE;
+}
+
+// Releases every column of `columns`.
+void JSON_ColumnsFree(JSON_Columns* const columns) {
+  if (columns == NULL)
+    return;
+  for (size_t i = 0; i < columns->ncolumns; ++i) {
+    JSON_Column* const column = columns->columns + i;
+    AllocatorFree(NULL, column->key);
+    AllocatorFree(NULL, column->nulls);
+    AllocatorFree(NULL, column->absent);
+    if (column->type == JSON_String) {
+      AllocatorFree(NULL, column->values.strings.offsets);
+      AllocatorFree(NULL, column->values.strings.chars);
+    } else if (column->type != JSON_Null) {
+      // Every other member of the union is a single pointer.
+      AllocatorFree(NULL, column->values.numbers);
+    }
+  }
+  AllocatorFree(NULL, columns->columns);
+  memset(columns, 0, sizeof(JSON_Columns));
+}
@@ -0,0 +1,129 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "compact.h"
+
+#include <sys/types.h>
+
+#include "accessors.h"
+#include "allocator.h"
+#include "bool.h"
+#include "cjson.h"
+#include "clone.h"
+#include "data/map/iterators.h"
+#include "data/map/map.h"
+#include "data/vector/modifiers.h"
+#include "data/vector/vector.h"
+
+// Re-allocates the array of a list storing its elements by value down to its
+// size, the array is left as it is if that fails.
+static void CompactValues(json_values_t* const values) {
+  if (values->size == values->capacity)
+    return;
+  if (values->size == 0) {
+    AllocatorFree(NULL, values->data);
+    values->data = NULL;
+    values->capacity = 0;
+    return;
+  }
+  JSON* const data = (JSON*)AllocatorRealloc(NULL, values->data,
+                                             values->size * sizeof(JSON));
+  if (data == NULL)
+    return;
+  values->data = data;
+  values->capacity = values->size;
+}
+
+// Trims what `json` holds itself and pushes its children onto `pending`.
+static void CompactVisit(JSON* const json, Vector* const pending) {
+  switch (json->type) {
+    case JSON_List:
+      if (json->flags & JSON_FLAG_LIST_VALUES)
+        CompactValues(&json->value.values);
+      else
+        VectorShrink(&json->value.list);
+      for (size_t i = 0; i < JSON_ListSize(json); ++i)
+        VectorPush(pending, JSON_ListGet(json, i));
+      break;
+    case JSON_Object: {
+      MapShrink(&json->value.object);
+      MapEntry* current = NULL;
+      MapIterator object_it = MapIteratorNew(&json->value.object);
+      while ((current = MapIteratorNext(&object_it)))
+        VectorPush(pending, current->value);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Trims the tree under `json` to the memory its current contents need: list
+// buffers lose their growth slack and objects their surplus buckets, e.g. the
+// ones left behind by removals.
+//
+// Shared trees attached below `json` (see `JSON_Ref`) are immutable and left
+// as they are.  Trimming is best-effort, a buffer that cannot be re-allocated
+// is kept.  The tree stays mutable; the next insertion grows it again.
+void JSON_Compact(JSON* const json) {
+  if (json == NULL || (json->flags & JSON_FLAG_SHARED))
+    return;
+  // The tree is walked with an explicit stack of the nodes left to trim.
+  Vector pending = VectorAlloc(0);
+  VectorPush(&pending, json);
+  JSON* current = NULL;
+  while ((current = (JSON*)VectorRemove(&pending)))
+    if (!(current->flags & JSON_FLAG_SHARED))
+      CompactVisit(current, &pending);
+  VectorFree(&pending);
+}
+
+// Relocates the tree under `json` into a single contiguous block and returns
+// it, or returns `NULL` and leaves `json` untouched if the free-store is
+// exhausted.
+//
+// The nodes are laid out in depth-first order, the elements of a list or the
+// values of an object next to each other and followed by their own subtrees,
+// so a traversal walks the block forward.  Shared trees are copied in.
+//
+// On success the memory held by `json` is released and `json` is left as a
+// `JSON_Null` instance, the node itself stays with the caller.  The returned
+// tree is a clone (see `JSON_Clone()`): it can be read with every accessor but
+// never modified, and is released with `JSON_CloneFree()`.  This suits
+// long-lived documents that are read far more often than they are built.
+JSON* JSON_CompactRelocate(JSON* const json) {
+  if (json == NULL)
+    return NULL;
+  JSON* const clone = JSON_Clone(json);
+  if (clone == NULL)
+    return NULL;
+  JSON_FreeDeep(json);
+  *json = JSON_InitNullImpl();
+  return clone;
+}
@@ -0,0 +1,178 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data/arena/arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "allocator.h"
+
+// Size of the `ArenaBlock` header rounded up so that the first allocation of a
+// block is aligned.
+#define ARENA_BLOCK_HEADER_SIZE                                         \
+  ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+#define ARENA_ALIGN(size) \
+  (((size) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+// Returns an `Arena` instance that allocates blocks of
+// `ARENA_DEFAULT_BLOCK_SIZE` bytes.  No block is allocated until the first
+// allocation.
+Arena ArenaAlloc() { return ArenaNAlloc(ARENA_DEFAULT_BLOCK_SIZE); }
+
+// Returns an `Arena` instance that allocates blocks of `blocksize` bytes.
+Arena ArenaNAlloc(const size_t blocksize) {
+  Arena arena = {.blocks = NULL,
+                 .blocksize = blocksize ? ARENA_ALIGN(blocksize)
+                                        : ARENA_DEFAULT_BLOCK_SIZE,
+                 .allocator = AllocatorGetDefault()};
+  return arena;
+}
+
+// Allocates a block with room for `size` bytes.
+static ArenaBlock* ArenaAllocBlock(const Arena* const arena,
+                                   const size_t size) {
+  ArenaBlock* block = (ArenaBlock*)AllocatorMalloc(
+      arena->allocator, ARENA_BLOCK_HEADER_SIZE + size);
+  if (block == NULL)
+    return NULL;
+  block->next = NULL;
+  block->size = size;
+  block->used = 0;
+  return block;
+}
+
+// Returns `size` bytes aligned to `ARENA_ALIGNMENT` that live until the
+// `arena` is freed, or `NULL` if the free-store is exhausted.
+//
+// Allocations larger than a quarter of the block size get a block of their
+// own so they never waste the rest of the current block.
+void* ArenaMalloc(Arena* const arena, const size_t size) {
+  if (arena == NULL)
+    return NULL;
+  const size_t size_ = ARENA_ALIGN(size ? size : 1);
+  if (size_ < size)
+    return NULL;
+  ArenaBlock* block = arena->blocks;
+
+  if (size_ > arena->blocksize / 4) {
+    // Link the dedicated block behind the current one so that the current one
+    // keeps being bumped.
+    ArenaBlock* dedicated = ArenaAllocBlock(arena, size_);
+    if (dedicated == NULL)
+      return NULL;
+    dedicated->used = size_;
+    if (block) {
+      dedicated->next = block->next;
+      block->next = dedicated;
+    } else {
+      arena->blocks = dedicated;
+    }
+    return (u_int8_t*)dedicated + ARENA_BLOCK_HEADER_SIZE;
+  }
+
+  if (block == NULL || block->size - block->used < size_) {
+    if ((block = ArenaAllocBlock(arena, arena->blocksize)) == NULL)
+      return NULL;
+    block->next = arena->blocks;
+    arena->blocks = block;
+  }
+  void* ptr = (u_int8_t*)block + ARENA_BLOCK_HEADER_SIZE + block->used;
+  block->used += size_;
+  return ptr;
+}
+
+// Same as `ArenaMalloc()` but the returned bytes are zeroed.
+void* ArenaCalloc(Arena* const arena, const size_t size) {
+  void* ptr = ArenaMalloc(arena, size);
+  if (ptr)
+    memset(ptr, 0, size);
+  return ptr;
+}
+
+// Frees every block of the `arena` and with them every allocation made from
+// it.  The `arena` can be reused afterwards.
+void ArenaFree(Arena* const arena) {
+  if (arena == NULL)
+    return;
+  ArenaBlock* block = arena->blocks;
+  while (block) {
+    ArenaBlock* next = block->next;
+    AllocatorFree(arena->allocator, block);
+    block = next;
+  }
+  arena->blocks = NULL;
+}
+
+// Every allocation made through `ArenaAllocator()` is prefixed with its size
+// so that `ArenaAllocatorRealloc()` knows how many bytes to copy.  The prefix
+// takes `ARENA_ALIGNMENT` bytes to keep the allocation itself aligned.
+static void* ArenaAllocatorMalloc(void* ctx, size_t size) {
+  if (size > (size_t)-1 - ARENA_ALIGNMENT)
+    return NULL;
+  u_int8_t* ptr = (u_int8_t*)ArenaMalloc((Arena*)ctx, ARENA_ALIGNMENT + size);
+  if (ptr == NULL)
+    return NULL;
+  *(size_t*)ptr = size;
+  return ptr + ARENA_ALIGNMENT;
+}
+
+static void* ArenaAllocatorRealloc(void* ctx, void* ptr, size_t size) {
+  if (ptr == NULL)
+    return ArenaAllocatorMalloc(ctx, size);
+  const size_t oldsize = *(size_t*)((u_int8_t*)ptr - ARENA_ALIGNMENT);
+  if (size <= oldsize)
+    return ptr;
+  void* ptr_ = ArenaAllocatorMalloc(ctx, size);
+  if (ptr_)
+    memcpy(ptr_, ptr, oldsize);
+  return ptr_;
+}
+
+static void ArenaAllocatorFree(void* ctx, void* ptr) {
+  (void)ctx;
+  (void)ptr;
+}
+
+// Returns an `Allocator` that serves every request out of the given `arena`,
+// so that containers created with it are released all at once by
+// `ArenaFree()`.
+//
+// Freeing through the returned `Allocator` is a no-op and growing an
+// allocation copies it to a new one; the `arena` must outlive every container
+// using the returned `Allocator`.
+Allocator ArenaAllocator(Arena* const arena) {
+  Allocator allocator = {.malloc = ArenaAllocatorMalloc,
+                         .realloc = ArenaAllocatorRealloc,
+                         .free = ArenaAllocatorFree,
+                         .ctx = (void*)arena};
+  return allocator;
+}
@@ -0,0 +1,191 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "data/map/map.h"
+#include "internal/arch.h"
+
+#if defined(CJSON_OS_LINUX) || defined(CJSON_OS_MAC)
+#include <sys/random.h>
+#endif
+
+// The constants the inputs are mixed with, those of wyhash.
+static const u_int64_t kHashSecret[4] = {
+    0xA0761D6478BD642FULL, 0xE7037ED1A0B428DBULL, 0x8EBC6AF09C88C6E3ULL,
+    0x589965CC75374CC3ULL};
+
+// The seed of every hash of the process, never zero once initialized.
+static u_int64_t hash_seed = 0;
+static pthread_once_t hash_seed_once = PTHREAD_ONCE_INIT;
+
+// Multiplies `*a` by `*b` into 128 bits and stores the low half in `*a` and
+// the high half in `*b`.
+static inline void HashMultiply(u_int64_t* const a, u_int64_t* const b) {
+#ifdef __SIZEOF_INT128__
+  const __uint128_t product = (__uint128_t)*a * *b;
+  *a = (u_int64_t)product;
+  *b = (u_int64_t)(product >> 64);
+#else
+  const u_int64_t ha = *a >> 32, hb = *b >> 32;
+  const u_int64_t la = (u_int32_t)*a, lb = (u_int32_t)*b;
+  const u_int64_t hl = ha * lb, lh = la * hb, ll = la * lb;
+  const u_int64_t cross = (ll >> 32) + (u_int32_t)hl + lh;
+  *a = (cross << 32) | (u_int32_t)ll;
+  *b = ha * hb + (hl >> 32) + (cross >> 32);
+#endif
+}
+
+// Returns the two halves of the 128-bit product of `a` and `b` folded into
+// one.
+static inline u_int64_t HashMix(u_int64_t a, u_int64_t b) {
+  HashMultiply(&a, &b);
+  return a ^ b;
+}
+
+static inline u_int64_t HashRead8(const u_int8_t* const p) {
+  u_int64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline u_int64_t HashRead4(const u_int8_t* const p) {
+  u_int32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+// Reads the 1 to 3 bytes at `p` into one word.
+static inline u_int64_t HashRead3(const u_int8_t* const p, const size_t len) {
+  return ((u_int64_t)p[0] << 16) | ((u_int64_t)p[len >> 1] << 8) | p[len - 1];
+}
+
+// Draws the seed of the process, see `HashN()`.
+static void HashSeedInit() {
+  u_int64_t seed = 0;
+  const char* const env = getenv("CJSON_HASH_SEED");
+  if (env && *env) {
+    seed = strtoull(env, NULL, 0);
+  } else {
+#if defined(CJSON_OS_LINUX) || defined(CJSON_OS_MAC)
+    if (getentropy(&seed, sizeof(seed)) != 0)
+      seed = 0;
+#endif
+    if (seed == 0) {
+      struct timespec now;
+      clock_gettime(CLOCK_REALTIME, &now);
+      // The address of a local tells apart processes started at once under
+      // address space layout randomization.
+      seed = HashMix((u_int64_t)now.tv_sec ^ kHashSecret[0],
+                     (u_int64_t)now.tv_nsec ^ (u_int64_t)getpid()) ^
+             (u_int64_t)(size_t)&seed;
+    }
+  }
+  seed = HashMix(seed ^ kHashSecret[0], kHashSecret[1]);
+  __atomic_store_n(&hash_seed, seed ? seed : kHashSecret[2], __ATOMIC_RELEASE);
+}
+
+// Returns the seed of the process, drawing it on first use.
+static inline u_int64_t HashSeed() {
+  const u_int64_t seed = __atomic_load_n(&hash_seed, __ATOMIC_ACQUIRE);
+  if (seed)
+    return seed;
+  pthread_once(&hash_seed_once, HashSeedInit);
+  return __atomic_load_n(&hash_seed, __ATOMIC_ACQUIRE);
+}
+
+// Creates a hash from a `key` of `string` data type.
+//
+// This functionality allow us to place a `key` inside our `Map` provided that
+// the given `key` is a `string` data type.  Same as `HashN()` over the
+// `strlen(key)` bytes of `key`.
+hash_t Hash(const void* const key) {
+  if (key == NULL)
+    return 0;
+  return HashN(key, strlen((const char*)key));
+}
+
+// Creates a hash from the `keylen` bytes of `key`, which may hold `NULL`
+// characters.
+//
+// The bytes are consumed up to 48 at a time and mixed with 64-bit multiplies
+// in the style of wyhash.  The hash is seeded once per process, from the
+// `CJSON_HASH_SEED` environment variable if it is set or from the system's
+// entropy otherwise, so colliding keys cannot be crafted ahead of time.
+// Hashes must therefore never be persisted.
+hash_t HashN(const void* const key, const size_t keylen) {
+  const u_int8_t* p = (const u_int8_t*)key;
+  u_int64_t seed = HashSeed();
+  u_int64_t a, b;
+  if (keylen <= 16) {
+    if (keylen >= 4) {
+      // Two overlapping reads of four bytes from each end cover every byte.
+      const size_t shift = (keylen >> 3) << 2;
+      a = (HashRead4(p) << 32) | HashRead4(p + shift);
+      b = (HashRead4(p + keylen - 4) << 32) | HashRead4(p + keylen - 4 - shift);
+    } else if (keylen > 0) {
+      a = HashRead3(p, keylen);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = keylen;
+    if (i > 48) {
+      u_int64_t seed1 = seed, seed2 = seed;
+      do {
+        seed = HashMix(HashRead8(p) ^ kHashSecret[1], HashRead8(p + 8) ^ seed);
+        seed1 = HashMix(HashRead8(p + 16) ^ kHashSecret[2],
+                        HashRead8(p + 24) ^ seed1);
+        seed2 = HashMix(HashRead8(p + 32) ^ kHashSecret[3],
+                        HashRead8(p + 40) ^ seed2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    while (i > 16) {
+      seed = HashMix(HashRead8(p) ^ kHashSecret[1], HashRead8(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    // The last sixteen bytes, overlapping the ones already consumed.
+    a = HashRead8(p + i - 16);
+    b = HashRead8(p + i - 8);
+  }
+  a ^= kHashSecret[1];
+  b ^= seed;
+  HashMultiply(&a, &b);
+  return (hash_t)HashMix(a ^ kHashSecret[0] ^ keylen, b ^ kHashSecret[1]);
+}
@@ -0,0 +1,153 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "data/map/intern.h"
+
+#include <string.h>
+#include <sys/types.h>
+
+#include "allocator.h"
+#include "bool.h"
+#include "data/arena/arena.h"
+#include "data/map/map.h"
+
+#define KEYPOOL_HEADER(key) \
+  ((const KeyPoolKey*)((const char*)(key) - sizeof(KeyPoolKey)))
+
+// Returns the slot holding the canonical copy of `key`, or the empty slot where
+// it belongs.  The table must have at least one empty slot.
+static const char** KeyPoolSlot(const KeyPool* const pool,
+                                const char* const key, const size_t length,
+                                const hash_t hash) {
+  size_t idx = hash & (pool->capacity - 1);
+  while (pool->slots[idx]) {
+    const KeyPoolKey* header = KEYPOOL_HEADER(pool->slots[idx]);
+    if (header->hash == hash && header->length == length &&
+        memcmp(pool->slots[idx], key, length) == 0)
+      break;
+    idx = (idx + 1) & (pool->capacity - 1);
+  }
+  return pool->slots + idx;
+}
+
+// Doubles the capacity of the table, re-inserting every canonical pointer.
+static bool_t KeyPoolGrow(KeyPool* const pool) {
+  const size_t capacity =
+      pool->capacity ? pool->capacity * 2 : KEYPOOL_DEFAULT_CAPACITY;
+  const char** slots =
+      (const char**)AllocatorCalloc(NULL, capacity, sizeof(const char*));
+  if (slots == NULL)
+    return FALSE;
+  const char** old_slots = pool->slots;
+  const size_t old_capacity = pool->capacity;
+  pool->slots = slots;
+  pool->capacity = capacity;
+  for (size_t i = 0; i < old_capacity; ++i) {
+    if (old_slots[i] == NULL)
+      continue;
+    const KeyPoolKey* header = KEYPOOL_HEADER(old_slots[i]);
+    *KeyPoolSlot(pool, old_slots[i], header->length, header->hash) =
+        old_slots[i];
+  }
+  AllocatorFree(NULL, old_slots);
+  return TRUE;
+}
+
+// Returns an empty `KeyPool` instance, nothing is allocated until the first key
+// is interned.
+KeyPool KeyPoolAlloc() {
+  KeyPool pool = {
+      .arena = ArenaAlloc(), .slots = NULL, .capacity = 0, .length = 0};
+  return pool;
+}
+
+// Returns the canonical copy of the `NULL` terminated `key`, interning it first
+// if it is not in the `pool` yet, or `NULL` if the free-store is exhausted.
+const char* KeyPoolIntern(KeyPool* const pool, const char* const key) {
+  if (key == NULL)
+    return NULL;
+  return KeyPoolInternN(pool, key, strlen(key));
+}
+
+// Same as `KeyPoolIntern()` but interns the `length` bytes at `key`, which do
+// not need to be `NULL` terminated.
+const char* KeyPoolInternN(KeyPool* const pool, const char* const key,
+                           const size_t length) {
+  if (pool == NULL || key == NULL)
+    return NULL;
+  // Keep the load factor below 3/4 so probe sequences stay short.
+  if ((pool->length + 1) * 4 > pool->capacity * 3 &&
+      KeyPoolGrow(pool) == FALSE)
+    return NULL;
+  const hash_t hash = HashN(key, length);
+  const char** slot = KeyPoolSlot(pool, key, length, hash);
+  if (*slot)
+    return *slot;
+  KeyPoolKey* header = (KeyPoolKey*)ArenaMalloc(
+      &pool->arena, sizeof(KeyPoolKey) + length + 1);
+  if (header == NULL)
+    return NULL;
+  header->hash = hash;
+  header->length = length;
+  char* canonical = (char*)(header + 1);
+  memcpy(canonical, key, length);
+  canonical[length] = '\0';
+  ++(pool->length);
+  return (*slot = canonical);
+}
+
+// Returns the canonical copy of `key` if it is interned in the `pool`, `NULL`
+// otherwise.  Never allocates.
+const char* KeyPoolFind(const KeyPool* const pool, const char* const key) {
+  if (pool == NULL || key == NULL || pool->capacity == 0)
+    return NULL;
+  const size_t length = strlen(key);
+  return *KeyPoolSlot(pool, key, length, HashN(key, length));
+}
+
+// Return the precomputed `Hash()` and length of a key returned by the
+// functions above.  Calling them with any other pointer is undefined.
+hash_t KeyPoolKeyHash(const char* const key) {
+  return KEYPOOL_HEADER(key)->hash;
+}
+
+size_t KeyPoolKeyLength(const char* const key) {
+  return KEYPOOL_HEADER(key)->length;
+}
+
+// Releases every interned key and the table of the `pool`, which can be
+// reused afterwards.
+void KeyPoolFree(KeyPool* const pool) {
+  if (pool == NULL)
+    return;
+  ArenaFree(&pool->arena);
+  AllocatorFree(NULL, pool->slots);
+  pool->slots = NULL;
+  pool->capacity = 0;
+  pool->length = 0;
+}
@@ -30,7 +30,9 @@
 #include "data/map/iterators.h"
 
 #include <stdio.h>
+#include <sys/types.h>
 
+#include "data/map/group.h"
 #include "data/map/map.h"
 
 // Traverses through the `Map` instance and executes the given `predicate` on
@@ -39,13 +41,10 @@
 // The given predicate must conform to the signature of the
 // `TraversePredicate` type and must not try to update its pointers.
 void MapTraverse(Map *const map, TraversePredicate predicate) {
-  for (size_t i = 0; i < map->bucketslen; ++i) {
-    MapEntry *current = *(map->buckets + i);
-    while (current) {
-      predicate(current->key, current->value);
-      current = current->next;
-    }
-  }
+  MapEntry *current = NULL;
+  MapIterator map_it = MapIteratorNew(map);
+  while ((current = MapIteratorNext(&map_it)))
+    predicate(current->key, current->value);
 }
 
 // Traverses through the `Map` instance and executes the given `predicate` on
@@ -56,36 +55,49 @@ void MapTraverse(Map *const map, TraversePredicate predicate) {
 // this `predicate` also takes in a `Map` instance as its first parameter.
 void MapTraverseWithMapInstance(Map *const map,
                                 TraverseWithMapInstancePredicate predicate) {
-  for (size_t i = 0; i < map->bucketslen; ++i) {
-    MapEntry *current = *(map->buckets + i);
-    while (current) {
-      predicate(map, current->key, current->value);
-      current = current->next;
-    }
-  }
+  MapEntry *current = NULL;
+  MapIterator map_it = MapIteratorNew(map);
+  while ((current = MapIteratorNext(&map_it)))
+    predicate(map, current->key, current->value);
 }
 
+// Returns an iterator over the entries of the `Map` instance, in the order of
+// their insertion.
 MapIterator MapIteratorNew(Map *const map) {
-  MapIterator it = {.map = map, .cur_bucket_idx = 0, .cur_entry = NULL};
-  while (it.cur_bucket_idx < map->bucketslen) {
-    if (map->buckets[it.cur_bucket_idx]) {
-      it.cur_entry = map->buckets[it.cur_bucket_idx];
-      break;
-    }
-    ++(it.cur_bucket_idx);
-  }
+  MapIterator it = {.map = map, .cur_entry_idx = 0};
   return it;
 }
 
+// Returns the next entry of the iterator, or `NULL` once every entry was
+// returned.  The `Map` instance must not be modified meanwhile.
 MapEntry *MapIteratorNext(MapIterator *const it) {
-  if (it->cur_bucket_idx >= it->map->bucketslen)
+  const Map *const map = it->map;
+  if (map->buckets == NULL)
     return NULL;
-  MapEntry *mapentry = it->cur_entry;
-  MapEntry *current = mapentry->next;
-  while (current == NULL && it->cur_bucket_idx < it->map->bucketslen) {
-    ++(it->cur_bucket_idx);
-    current = it->map->buckets[it->cur_bucket_idx];
+  const size_t used = *MapEntriesUsed(map);
+  const MapMigration *const migration = *MapMigrationOf(map);
+  // A growing `Map` instance holds, in order, the entries moved so far, those
+  // of its previous buckets still to move and the ones inserted meanwhile.
+  size_t moved = used, pending = 0, reserved = used;
+  if (migration) {
+    Map source = *map;
+    source.buckets = migration->buckets;
+    source.bucketslen = migration->bucketslen;
+    moved = migration->moved;
+    pending = *MapEntriesUsed(&source) - migration->next;
+    reserved = migration->reserved;
+  }
+  while (it->cur_entry_idx < moved + pending + (used - reserved)) {
+    const size_t idx = it->cur_entry_idx++;
+    MapEntry *mapentry;
+    if (idx < moved)
+      mapentry = map->buckets + idx;
+    else if (idx < moved + pending)
+      mapentry = migration->buckets + migration->next + (idx - moved);
+    else
+      mapentry = map->buckets + reserved + (idx - moved - pending);
+    if (!MapEntryRemoved(mapentry))
+      return mapentry;
   }
-  it->cur_entry = current;
-  return mapentry;
+  return NULL;
 }
@@ -34,19 +34,25 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include "allocator.h"
+#include "bool.h"
+#include "data/map/group.h"
+#include "data/map/iterators.h"
 #include "data/map/ops.h"
 
 // Creates a `MapEntry` instance with the given key-value pairs and a hash.
 //
 // Allocates a `MapEntry` instance in the free-store and fills that memory
-// with the given values.  Remember to free the returned `MapEntry` instance
-// when not needed.
+// with the given values, its `keylen` is left `0`.  Remember to free the
+// returned `MapEntry` instance when not needed.
 MapEntry* MapAllocEntryWithHash(void* key, void* value, const hash_t hash) {
-  MapEntry* mapentry = (MapEntry*)malloc(sizeof(MapEntry));
+  MapEntry* mapentry = (MapEntry*)AllocatorCacheMalloc(NULL, sizeof(MapEntry));
+  if (mapentry == NULL)
+    return NULL;
   mapentry->key = key;
   mapentry->value = value;
   mapentry->hash = hash;
-  mapentry->next = NULL;
+  mapentry->keylen = 0;
   return mapentry;
 }
 
@@ -65,28 +71,41 @@ Map MapAlloc(hash_f hash, keycmp_f keycmp) {
 
 // Allocates a `Map` instance of the given `bucketslen` provided the `hash`
 // function to generate a hash and a `keycmp` function to compare two distinct
-// keys inside a `Map` instance.
+// keys inside a `Map` instance.  The `bucketslen` is rounded up to a power of
+// two no smaller than `MAP_DEFAULT_BUCKET_LEN`.
 //
 // While allocating a `Map` instance you can also use the built-in hash
 // generator function `Hash()` to generate a hash value from a `key` regardless
 // of its data type and also the built-in key compare function `KeyCmp()` to
 // compare two distinct keys.
 Map MapAllocNBuckets(size_t bucketslen, hash_f hash, keycmp_f keycmp) {
-  if (bucketslen == 0)
-    bucketslen = MAP_DEFAULT_BUCKET_LEN;
+  return MapAllocNBucketsWithAllocator(bucketslen, hash, keycmp, NULL);
+}
+
+// Allocates a `Map` instance of the given `bucketslen` whose buckets come from
+// the given `allocator`, or from the process-wide allocator if `allocator` is
+// `NULL`.
+//
+// The `Map` instance keeps using `allocator` for every re-allocation and for
+// releasing its buckets and, with `MapFreeDeep()`, their `key-value` pairs.
+Map MapAllocNBucketsWithAllocator(size_t bucketslen, hash_f hash,
+                                  keycmp_f keycmp,
+                                  const Allocator* const allocator) {
+  size_t rounded = MAP_DEFAULT_BUCKET_LEN;
+  while (rounded < bucketslen)
+    rounded *= 2;
+  bucketslen = rounded;
   if (hash == NULL)
     hash = Hash;
   if (keycmp == NULL)
     keycmp = KeyCmp;
   // clang-format off
   Map map = {.bucketslen = bucketslen, .entrieslen = 0,
-             .buckets = (void*)0, .hash = hash, .keycmp = keycmp};
+             .buckets = (void*)0, .hash = hash, .keycmp = keycmp,
+             .allocator = allocator ? allocator : AllocatorGetDefault()};
   // clang-format on
-  if ((map.buckets = (MapEntry**)(malloc(bucketslen * sizeof(MapEntry*)))) ==
-      NULL)
-    return map;
-  for (size_t i = 0; i < map.bucketslen; ++i)
-    *(map.buckets + i) = NULL;
+  map.buckets = (MapEntry*)AllocatorCacheCalloc(map.allocator, 1,
+                                                MapBucketsSize(bucketslen));
   return map;
 }
 
@@ -103,59 +122,138 @@ Map MapAllocNBuckets(size_t bucketslen, hash_f hash, keycmp_f keycmp) {
 // of its data type and also the built-in key compare function `KeyCmp()` to
 // compare two distinct keys.
 Map MapAllocNEntries(const size_t entrieslen, hash_f hash, keycmp_f keycmp) {
-  double bucketslen = MAP_DEFAULT_BUCKET_LEN;
-  while (((double)entrieslen / bucketslen) > MAX_LOAD_FACTOR)
-    bucketslen *= 2.0;
-  return MapAllocNBuckets((size_t)bucketslen, hash, keycmp);
+  return MapAllocNBuckets(MapComputeBucketsLen(entrieslen), hash, keycmp);
 }
 
-// Re-allocates a `Map` instance by extending the `bucketslen` until the
-// following does not evaluates to true:
+// Returns the number of buckets a `Map` instance needs to hold `entrieslen`
+// entries without exceeding the `MAX_LOAD_FACTOR`, or the fewest holding them
+// all for small ones (see `Map`).
 //
-//                      #Entries
-//      LoadFactor > ~~~~~~~~~~~~~~
-//                      #Buckets
+// The result is always a power of two no smaller than `MAP_DEFAULT_BUCKET_LEN`
+// as required by `CalculateIndex()`.
+size_t MapComputeBucketsLen(const size_t entrieslen) {
+  size_t bucketslen = MAP_DEFAULT_BUCKET_LEN;
+  while (MapEntriesCapacity(bucketslen) < entrieslen)
+    bucketslen *= 2;
+  return bucketslen;
+}
+
+// Returns the size in bytes of the free-store block holding the entries, the
+// control bytes and the indices of `bucketslen` buckets, the count of used
+// entries and the pending migration.
 //
-// Calling this function will result in a new `Map` instance which would be
-// the exact copy of the previous `Map` instance except for the `bucketslen`.
+// `bucketslen` must be a power of two no smaller than `MAP_DEFAULT_BUCKET_LEN`.
+// A zeroed block of that size is a table of empty buckets, ready to be handed
+// to `MapRehash()`.
+size_t MapBucketsSize(const size_t bucketslen) {
+  return MapEntriesCapacity(bucketslen) * sizeof(MapEntry) +
+         MapCtrlLen(bucketslen) + bucketslen * MapIndexWidth(bucketslen) +
+         sizeof(size_t) + sizeof(MapMigration*);
+}
+
+// Returns the size in bytes of the free-store held by the buckets of `map`,
+// those of a pending migration included.
+size_t MapAllocatedSize(const Map* const map) {
+  if (map->buckets == NULL)
+    return 0;
+  const MapMigration* const migration = *MapMigrationOf(map);
+  size_t size = MapBucketsSize(map->bucketslen);
+  if (migration)
+    size += MapBucketsSize(migration->bucketslen) + sizeof(MapMigration);
+  return size;
+}
+
+// Moves every entry of `map` into a fresh block of `bucketslen` buckets and
+// releases the previous one.
 //
-// We want to re-allocate the `Map` instance and extend the number of buckets
-// it currently has so to combat the chances of collisions.
+// Returns `FALSE` if the buckets could not be allocated, `map` is then left
+// untouched.
+static bool_t MapReplaceBuckets(Map* const map, const size_t bucketslen) {
+  MapEntry* buckets = (MapEntry*)AllocatorCacheCalloc(
+      map->allocator, 1, MapBucketsSize(bucketslen));
+  if (buckets == NULL)
+    return FALSE;
+  MapEntry* tmp_buckets = map->buckets;
+  const size_t tmp_bucketslen = map->bucketslen;
+  MapRehash(map, buckets, bucketslen);
+  AllocatorCacheFree(map->allocator, tmp_buckets,
+                     MapBucketsSize(tmp_bucketslen));
+  return TRUE;
+}
+
+// Re-allocates a `Map` instance whose entries are all used, to the
+// `bucketslen` returned by `MapGrowBucketsLen()`.
+//
+// Calling this function will result in a new `Map` instance which would be
+// the exact copy of the previous `Map` instance except for the `bucketslen`
+// and the holes left by removals, which are dropped.
 void MapRealloc(Map* map) {
-  Map map_ = MapAllocNEntries(map->entrieslen, map->hash, map->keycmp);
+  MapReplaceBuckets(map, MapGrowBucketsLen(map));
+}
 
-  const size_t bucketslen = map_.bucketslen;
-  for (size_t i = 0; i < map_.bucketslen; ++i) {
-    MapEntry* current = *(map->buckets + i);
-    while (current)
-      MapPut(&map_, current->key, current->value);
-  }
+// Returns the `bucketslen` a `Map` instance whose entries are all used grows
+// to, with room for half as many entries again as it holds so that removals
+// followed by insertions do not re-allocate it on every insertion.
+size_t MapGrowBucketsLen(const Map* const map) {
+  return MapComputeBucketsLen(map->entrieslen + map->entrieslen / 2 + 1);
+}
 
-  MapEntry** tmp_buckets = map->buckets;
-  map->buckets = map_.buckets;
-  map_.buckets = tmp_buckets;
-  map_.bucketslen = map->bucketslen;
-  MapFree(&map_);
+// Re-allocates the buckets of a `Map` instance down to the fewest its
+// `entrieslen` needs without exceeding the `MAX_LOAD_FACTOR`, e.g. once
+// entries were taken out with `MapRemove()`, dropping the holes they left.
+//
+// Returns `FALSE` if the buckets could not be re-allocated, the `Map` instance
+// is then left untouched.
+bool_t MapShrink(Map* const map) {
+  if (map->buckets == NULL)
+    return TRUE;
+  MapMigrate(map, (size_t)-1);
+  const size_t bucketslen = MapComputeBucketsLen(map->entrieslen);
+  if (bucketslen >= map->bucketslen &&
+      *MapEntriesUsed(map) == map->entrieslen)
+    return TRUE;
+  return MapReplaceBuckets(
+      map, bucketslen < map->bucketslen ? bucketslen : map->bucketslen);
+}
+
+// Moves every entry of the `Map` instance into the given `buckets`, in order.
+//
+// `buckets` must be a zeroed block of `MapBucketsSize(bucketslen)` bytes where
+// `bucketslen` is a power of two no smaller than `MAP_DEFAULT_BUCKET_LEN` and
+// large enough for every entry.  The previous block is left for the caller to
+// release, so the memory of the buckets can be owned by someone other than
+// the free-store.  A pending migration is completed first.
+void MapRehash(Map* const map, MapEntry* const buckets,
+               const size_t bucketslen) {
+  MapMigrate(map, (size_t)-1);
+  const Map tmp = *map;
+  map->buckets = buckets;
   map->bucketslen = bucketslen;
+  map->entrieslen = 0;
+  if (tmp.buckets == NULL)
+    return;
+  const size_t used = *MapEntriesUsed(&tmp);
+  for (size_t i = 0; i < used; ++i)
+    if (!MapEntryRemoved(tmp.buckets + i))
+      MapPutEntry(map, tmp.buckets + i);
 }
 
 // Copies `src` to `dest`.
 //
-// This function will not make the copies of the values stored inside of the
-// `src` hash map but will create a new bucket list of pointers pointing to the
-// values inside `src` hash map.
+// This function will not make the copies of the keys and values stored inside
+// of the `src` hash map but will put entries pointing to them into `dest`,
+// which must hash its keys the way `src` does.
 //
 // This is mainly used when `src` instance is stored in the `stack` while the
 // values inside of it are stored in the `free-store` and you don't want to lose
 // the memory when `src` goes out of scope; thus it's better to copy the entire
 // `src` hash map bucket into a new bucket that is dynamically allocated.
 void MapCopy(Map* const dest, Map* const src) {
-  if (src->entrieslen > dest->entrieslen) {
-    dest->entrieslen = src->entrieslen;
-    MapRealloc(dest);
-  }
-  for (size_t i = 0; i < src->bucketslen; ++i)
-    *(dest->buckets + i) = *(src->buckets + i);
+  MapEntry* current = NULL;
+  MapIterator src_it = MapIteratorNew(src);
+  while ((current = MapIteratorNext(&src_it)))
+    MapPutNWithHash(dest, current->key, current->keylen, current->value,
+                    current->hash);
 }
 
 // Frees up a `Map` instance and the entries associated with it.
@@ -164,15 +262,18 @@ void MapCopy(Map* const dest, Map* const src) {
 // `Map` instance after calling this function the `Map` data reference passed
 // becomes empty.
 void MapFree(Map* const map) {
-  for (size_t i = 0; i < map->bucketslen; ++i) {
-    if (*(map->buckets + i)) {
-      MapFreeEntryImpl(*(map->buckets + i));
-      free(*(map->buckets + i));
-    }
+  MapMigration* const migration = map->buckets ? *MapMigrationOf(map) : NULL;
+  if (migration) {
+    AllocatorCacheFree(map->allocator, migration->buckets,
+                       MapBucketsSize(migration->bucketslen));
+    AllocatorFree(map->allocator, migration);
   }
+  if (map->buckets)
+    AllocatorCacheFree(map->allocator, map->buckets,
+                       MapBucketsSize(map->bucketslen));
+  map->buckets = NULL;
   map->bucketslen = 0;
   map->entrieslen = 0;
-  free(map->buckets);
 }
 
 // Frees up a `Map` instance and the entries associated with it with their
@@ -183,55 +284,13 @@ void MapFree(Map* const map) {
 // becomes empty and the values stored as `key-value` pairs inside of the `Map`
 // instance will be destroyed forever.
 void MapFreeDeep(Map* const map) {
-  for (size_t i = 0; i < map->bucketslen; ++i) {
-    if (map->buckets[i]) {
-      MapFreeEntryDeepImpl(*(map->buckets + i));
-      free(*(map->buckets + i));
-    }
-  }
-  map->bucketslen = 0;
-  map->entrieslen = 0;
-  free(map->buckets);
-}
-
-// Private function to free up the space occupied by the entries in a bucket.
-//
-// Takes in a `MapEntry` instance but frees up all the other entries linked
-// with that map entry and leaves the map entry given intially unchanged.
-//
-// Only the neighbours are freed using this function not the head node you still
-// need to free the head node by yourself.  This function is an implementation
-// detail, you should not use it as it is not the part of the public API.
-void MapFreeEntryImpl(MapEntry* const mapentry) {
-  if (mapentry == NULL)
-    return;
-  if (mapentry->next) {
-    MapFreeEntryImpl(mapentry->next);
-    free(mapentry->next);
-  }
-}
-
-// Private function to free up the space occupied by the entries and their
-// respective `key-value` pairs in a bucket.
-//
-// Takes in a `MapEntry` instance but frees up all the other entries linked
-// with that map entry and leaves the map entry given intially unchanged.
-//
-// Only the neighbours are freed using this function not the head node you still
-// need to free the head node by yourself.  This function is an implementation
-// detail, you should not use it as it is not the part of the public API.
-//
-// The `key-value` pair stored inside of the initial `MapEntry` will always get
-// destroyed from the free-store but not the `MapEntry` container.
-void MapFreeEntryDeepImpl(MapEntry* const mapentry) {
-  if (mapentry) {
-    if (mapentry->next) {
-      MapFreeEntryDeepImpl(mapentry->next);
-      free(mapentry->next);
-    }
-    free(mapentry->key);
-    free(mapentry->value);
+  MapEntry* current = NULL;
+  MapIterator map_it = MapIteratorNew(map);
+  while ((current = MapIteratorNext(&map_it))) {
+    AllocatorFree(map->allocator, current->key);
+    AllocatorFree(map->allocator, current->value);
   }
+  MapFree(map);
 }
 
 // Returns a `Map` instance with the built-in support for hash generation and
@@ -245,30 +304,27 @@ Map MapAllocNStrAsKey(const size_t entrieslen) {
   return MapAllocNEntries(entrieslen, Hash, KeyCmp);
 }
 
-// Creates a hash from a `key` of `string` data type.
-//
-// This functionality allow us to place a `key` inside our `Map` provided that
-// the given `key` is a `string` data type.  We read `keylen` bytes from the
-// given `key` and accumulate a `hash` value.
-hash_t Hash(const void* const key) {
-  hash_t hash = 0;
-  if (key == NULL)
-    return hash;
-  const char* key_ = (char*)key;
-  size_t keylen = strlen(key_);
-  for (size_t i = 0; i < keylen; ++i)
-    hash = (((hash_t)(*(key_ + i))) + (0x1F * hash));
-  return hash;
-}
-
 // Compares the eqaulity of two `keys` of `string` data type.
 //
 // We compare `key1` with `key2` to create a result.  Key should be of `string`
-// data type and must have a `NULL` terminator character.
+// data type and must have a `NULL` terminator character.  Identical pointers,
+// e.g. keys interned by the same `KeyPool`, compare equal without reading the
+// strings.
+//
+// A `Map` instance using it as its `keycmp` stores the length of its keys and
+// compares them by length and bytes instead, see `MapEntry`.
 bool_t KeyCmp(const void* key1, const void* key2) {
-  if (key1 == NULL && key2 == NULL)
+  if (key1 == key2)
     return TRUE;
   if (key1 == NULL || key2 == NULL)
     return FALSE;
   return strcmp((char*)key1, (char*)key2) == 0 ? TRUE : FALSE;
 }
+
+// Returns the length `Map` instance `map` stores for `key`, `strlen(key)` if
+// its keys are compared with `KeyCmp()` and `0` otherwise.
+size_t MapKeyLen(const Map* const map, const void* const key) {
+  if (map->keycmp != KeyCmp || key == NULL)
+    return 0;
+  return strlen((const char*)key);
+}
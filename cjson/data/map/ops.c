@@ -31,8 +31,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
 
+#include "allocator.h"
 #include "bool.h"
+#include "data/map/group.h"
 #include "data/map/map.h"
 
 // Calculates the index of element in the map.
@@ -41,51 +45,293 @@
 // for the element in the map.
 size_t CalculateIndex(hash_t hash, size_t n) { return hash & (n - 0x01); }
 
+// Returns the hash `map` computes for the `keylen` bytes at `key`.
+//
+// The built-in `Hash()` only sees the bytes up to the first `NULL` character,
+// so the length is handed to `HashN()` instead, which hashes equal keys alike.
+static hash_t MapHashN(const Map *const map, const void *const key,
+                       const size_t keylen) {
+  if (map->hash == Hash)
+    return key ? HashN(key, keylen) : 0;
+  return map->hash(key);
+}
+
+// Returns whether the `key` of `keylen` bytes equals the key of `mapentry`.
+static inline bool_t MapEntryHasKey(const Map *const map,
+                                    const MapEntry *const mapentry,
+                                    const void *const key,
+                                    const size_t keylen) {
+  if (map->keycmp != KeyCmp)
+    return map->keycmp(key, mapentry->key);
+  if (mapentry->keylen != keylen)
+    return FALSE;
+  if (mapentry->key == key)
+    return TRUE;
+  return key && mapentry->key && memcmp(key, mapentry->key, keylen) == 0;
+}
+
+// Probes the buckets of `map` for `key` of the given `keylen` and `hash`.
+//
+// Returns the index of the bucket holding an equal key if there is one, its
+// entry is then the one `MapIndexGet()` returns for that bucket.
+// Otherwise returns `map->bucketslen` and, unless `slot` is `NULL`, stores
+// there the first free bucket the probe met, or `map->bucketslen` if every
+// bucket is taken.  The groups are visited in a triangular sequence, which
+// reaches every group of a power of two sized table.
+//
+// Small maps have a single group, the bucket of an entry is its place in the
+// entries and the free one is the next entry to use.
+static size_t MapProbe(const Map *const map, void *const key,
+                       const size_t keylen, const hash_t hash,
+                       size_t *const slot) {
+  const size_t groups = map->bucketslen / MAP_GROUP_WIDTH;
+  const u_int8_t *const ctrl = MapCtrl(map);
+  const u_int8_t tag = MapCtrlTag(hash);
+  size_t group = CalculateIndex(hash, groups);
+  if (slot)
+    *slot = map->bucketslen;
+  if (MapIsSmall(map->bucketslen)) {
+    // Holes and the padding are empty, only the entries in use may match.
+    u_int32_t match = MapGroupMatch(ctrl, tag);
+    while (match) {
+      const size_t idx = (size_t)__builtin_ctz(match);
+      const MapEntry *const mapentry = map->buckets + idx;
+      if (mapentry->hash == hash &&
+          MapEntryHasKey(map, mapentry, key, keylen))
+        return idx;
+      match &= match - 1;
+    }
+    const size_t used = *MapEntriesUsed(map);
+    if (slot && used < map->bucketslen)
+      *slot = used;
+    return map->bucketslen;
+  }
+  for (size_t probe = 1; probe <= groups; ++probe) {
+    const size_t base = group * MAP_GROUP_WIDTH;
+    u_int32_t match = MapGroupMatch(ctrl + base, tag);
+    while (match) {
+      const size_t idx = base + (size_t)__builtin_ctz(match);
+      const MapEntry *const mapentry = map->buckets + MapIndexGet(map, idx);
+      if (mapentry->hash == hash &&
+          MapEntryHasKey(map, mapentry, key, keylen))
+        return idx;
+      match &= match - 1;
+    }
+    const u_int32_t empty = MapGroupMatch(ctrl + base, MAP_CTRL_EMPTY);
+    if (slot && *slot == map->bucketslen) {
+      const u_int32_t free_ =
+          empty | MapGroupMatch(ctrl + base, MAP_CTRL_DELETED);
+      if (free_)
+        *slot = base + (size_t)__builtin_ctz(free_);
+    }
+    if (empty)
+      break;
+    group = CalculateIndex(group + probe, groups);
+  }
+  return map->bucketslen;
+}
+
+// Returns a `Map` instance over the previous buckets of the growing `map`.
+static Map MapMigrationSource(const Map *const map,
+                              const MapMigration *const migration) {
+  Map source = *map;
+  source.buckets = migration->buckets;
+  source.bucketslen = migration->bucketslen;
+  return source;
+}
+
+// Same as `MapProbe()` over the previous buckets `source` of a growing `Map`
+// instance, but only finds keys that were not moved yet.
+static size_t MapMigrationProbe(const Map *const source, void *const key,
+                                const size_t keylen, const hash_t hash) {
+  const size_t idx = MapProbe(source, key, keylen, hash, NULL);
+  // Moved entries are left as holes, their buckets still point to them.
+  if (idx != source->bucketslen &&
+      MapEntryRemoved(source->buckets + MapIndexGet(source, idx)))
+    return source->bucketslen;
+  return idx;
+}
+
+// Returns the entry of `map`, or of its previous buckets if it is growing,
+// holding `key` of the given `keylen` and `hash`, or `NULL` if there is none.
+static MapEntry *MapFind(const Map *const map, void *const key,
+                         const size_t keylen, const hash_t hash) {
+  const size_t idx = MapProbe(map, key, keylen, hash, NULL);
+  if (idx != map->bucketslen)
+    return map->buckets + MapIndexGet(map, idx);
+  const MapMigration *const migration = *MapMigrationOf(map);
+  if (migration == NULL)
+    return NULL;
+  const Map source = MapMigrationSource(map, migration);
+  const size_t old = MapMigrationProbe(&source, key, keylen, hash);
+  return old == source.bucketslen ? NULL
+                                  : source.buckets + MapIndexGet(&source, old);
+}
+
+// Starts growing `map` into the buckets returned by `MapGrowBucketsLen()`,
+// see `MapMigration`.  Returns `FALSE` if the free-store is exhausted.
+static bool_t MapMigrationStart(Map *const map) {
+  const size_t bucketslen = MapGrowBucketsLen(map);
+  MapMigration *const migration =
+      (MapMigration *)AllocatorMalloc(map->allocator, sizeof(MapMigration));
+  MapEntry *const buckets =
+      migration ? (MapEntry *)AllocatorCacheCalloc(
+                      map->allocator, 1, MapBucketsSize(bucketslen))
+                : NULL;
+  if (buckets == NULL) {
+    AllocatorFree(map->allocator, migration);
+    return FALSE;
+  }
+  // clang-format off
+  *migration = (MapMigration){.buckets = map->buckets,
+                              .bucketslen = map->bucketslen, .next = 0,
+                              .moved = 0, .reserved = map->entrieslen};
+  // clang-format on
+  map->buckets = buckets;
+  map->bucketslen = bucketslen;
+  *MapEntriesUsed(map) = migration->reserved;
+  *MapMigrationOf(map) = migration;
+  return TRUE;
+}
+
+// Moves up to `entrieslen` entries of a growing `Map` instance out of its
+// previous buckets, which are released once empty.  Returns whether entries
+// are left to move.
+//
+// Every insertion already moves `MAP_MIGRATE_STEP` entries, this lets callers
+// finish the job ahead of time, e.g. while idle.
+bool_t MapMigrate(Map *const map, const size_t entrieslen) {
+  MapMigration *const migration = map->buckets ? *MapMigrationOf(map) : NULL;
+  if (migration == NULL)
+    return FALSE;
+  const Map source = MapMigrationSource(map, migration);
+  const size_t used = *MapEntriesUsed(&source);
+  u_int8_t *const ctrl = MapCtrl(map);
+  for (size_t moved = 0; migration->next < used && moved < entrieslen;) {
+    MapEntry *const mapentry = source.buckets + migration->next++;
+    if (MapEntryRemoved(mapentry))
+      continue;
+    // The key cannot be in the current buckets yet, only a free bucket is
+    // looked for.
+    size_t slot;
+    MapProbe(map, mapentry->key, mapentry->keylen, mapentry->hash, &slot);
+    ctrl[slot] = MapCtrlTag(mapentry->hash);
+    MapIndexSet(map, slot, migration->moved);
+    map->buckets[migration->moved++] = *mapentry;
+    mapentry->keylen = MAP_ENTRY_REMOVED;
+    ++moved;
+  }
+  if (migration->next < used)
+    return TRUE;
+
+  for (size_t i = migration->moved; i < migration->reserved; ++i)
+    map->buckets[i].keylen = MAP_ENTRY_REMOVED;
+  AllocatorCacheFree(map->allocator, source.buckets,
+                     MapBucketsSize(source.bucketslen));
+  AllocatorFree(map->allocator, migration);
+  *MapMigrationOf(map) = NULL;
+  return FALSE;
+}
+
 // Injects the given set of key-value pair to the given `Map` instance if
 // already exists, overrides it.
 //
-// Generates a hash value using the given key and finds the position of a new
-// `MapEntry` instance in the `buckets` linked list.  To combat collision we
-// extend the already saved `MapEntry` by hooking it up with the new `MapEntry`
-// instance while keeping the order sorted based on the hash computed.
+// Generates a hash value using the given key and appends the pair to the
+// entries, see `MapPutEntry()`.
 //
-// Resizes the `Map` instance in case the load factor exceeds the
-// `MAX_LOAD_FACTOR`.
+// Grows the `Map` instance in case every entry, holes left by removals
+// included, is used, moving its entries a few at a time once it holds more
+// than `MAP_MIGRATE_STEP` of them (see `MapMigrate()`).
 void MapPut(Map *map, void *const key, void *const value) {
-  hash_t hash = map->hash(key);
-  size_t idx = CalculateIndex(hash, map->bucketslen);
-
-  MapEntry *mapentry = MapAllocEntryWithHash(key, value, hash);
-
-  if (*(map->buckets + idx) == NULL) {
-    *(map->buckets + idx) = mapentry;
-    ++(map->entrieslen);
-  } else {
-    MapEntry *current = map->buckets[idx];
-    while (current->next && hash > current->hash)
-      current = current->next;
-    if ((hash == current->hash) && map->keycmp(key, current->key) == TRUE) {
-      current->value = value;
-    } else {
-      MapEntry *tmp_mapentry = current->next;
-      current->next = mapentry;
-      mapentry->next = tmp_mapentry;
-      ++(map->entrieslen);
-    }
-  }
+  const size_t keylen = MapKeyLen(map, key);
+  MapPutNWithHash(map, key, keylen, value, MapHashN(map, key, keylen));
+}
+
+// Same as `MapPut()` but uses the given `hash` instead of computing one from
+// `key`, e.g. one precomputed by a `KeyPool`.  The `hash` must be the one the
+// `hash` function of the `Map` instance computes for `key`.
+void MapPutWithHash(Map *const map, void *const key, void *const value,
+                    const hash_t hash) {
+  MapPutNWithHash(map, key, MapKeyLen(map, key), value, hash);
+}
 
-  if (((double)map->entrieslen / (double)map->bucketslen) > MAX_LOAD_FACTOR)
+// Same as `MapPut()` but maps the `keylen` bytes at `key`, which may hold
+// `NULL` characters, e.g. a key whose length a decoder already knows.  The
+// `Map` instance must compare its keys with `KeyCmp()`.
+void MapPutN(Map *const map, void *const key, const size_t keylen,
+             void *const value) {
+  MapPutNWithHash(map, key, keylen, value, MapHashN(map, key, keylen));
+}
+
+// Same as `MapPutN()` but uses the given precomputed `hash` of `key`.
+void MapPutNWithHash(Map *const map, void *const key, const size_t keylen,
+                     void *const value, const hash_t hash) {
+  if (map->buckets == NULL)
+    return;
+  MapMigrate(map, MAP_MIGRATE_STEP);
+  MapEntry mapentry = {
+      .key = key, .value = value, .hash = hash, .keylen = keylen};
+  if (MapPutEntry(map, &mapentry))
+    return;
+  // The current buckets only fill up before every entry was moved if most of
+  // them were removed meanwhile, the rest is moved at once.
+  if (MapMigrate(map, (size_t)-1) == FALSE && MapPutEntry(map, &mapentry))
+    return;
+  // Entries fitting in a single step are moved at once.
+  if (map->entrieslen > MAP_MIGRATE_STEP && MapMigrationStart(map))
+    MapMigrate(map, MAP_MIGRATE_STEP);
+  else
     MapRealloc(map);
+  MapPutEntry(map, &mapentry);
 }
 
-// Returns a `void*` to the value mapped by the given `key`.
+// Appends a copy of the given `mapentry` to the entries, indexed by the first
+// free bucket of the probe sequence of its hash, and returns the stored entry.
 //
-// Traverse through the entries of the bucket at the computed `idx` value and
-// searches for a `hash` value that matches the computed `hash` value.  If we
-// find a value that is greater than the `hash` computed; not equal but greater
-// than then we immediately return `NULL` as having a value greater than the
-// computed `hash` using the `key` can only be possible when we have traversed
-// long enough but did not find any `hash` value equals to the computed `hash`.
+// The `hash` of `mapentry`, and its `keylen` if the `Map` instance compares its
+// keys with `KeyCmp()`, must already be computed.  If an entry with an
+// equal key already exists only its value is overridden and that entry is
+// returned instead, keeping its place in the order, even one not moved yet out
+// of the previous buckets of a growing `Map` instance.  Returns `NULL` if every
+// entry is used.
+//
+// Unlike `MapPut()` this never allocates nor resizes the `Map` instance, which
+// lets callers own the memory of the buckets.
+MapEntry *MapPutEntry(Map *const map, MapEntry *const mapentry) {
+  if (map->buckets == NULL)
+    return NULL;
+  size_t slot;
+  const size_t idx =
+      MapProbe(map, mapentry->key, mapentry->keylen, mapentry->hash, &slot);
+  MapEntry *stored = idx != map->bucketslen
+                         ? map->buckets + MapIndexGet(map, idx)
+                         : NULL;
+  const MapMigration *const migration = *MapMigrationOf(map);
+  if (stored == NULL && migration) {
+    const Map source = MapMigrationSource(map, migration);
+    const size_t old = MapMigrationProbe(&source, mapentry->key,
+                                         mapentry->keylen, mapentry->hash);
+    if (old != source.bucketslen)
+      stored = source.buckets + MapIndexGet(&source, old);
+  }
+  if (stored) {
+    stored->value = mapentry->value;
+    return stored;
+  }
+  size_t *const used = MapEntriesUsed(map);
+  // Every bucket taken by an entry or left deleted used an entry, so a free
+  // bucket is left as long as an entry is.
+  if (*used == MapEntriesCapacity(map->bucketslen))
+    return NULL;
+  MapCtrl(map)[slot] = MapCtrlTag(mapentry->hash);
+  MapIndexSet(map, slot, *used);
+  stored = map->buckets + (*used)++;
+  *stored = *mapentry;
+  ++(map->entrieslen);
+  return stored;
+}
+
+// Returns a `void*` to the value mapped by the given `key`.
 //
 // This should be very reminiscent of what we are doing in function
 // `MapEntry *MapGetEntry(Map *const map, void *const key)`.
@@ -94,74 +340,111 @@ void *MapGet(Map *const map, void *const key) {
   return mapentry ? mapentry->value : NULL;
 }
 
+// Same as `MapGet()` but uses the given precomputed `hash` of `key`.
+void *MapGetWithHash(Map *const map, void *const key, const hash_t hash) {
+  MapEntry *mapentry = MapGetEntryWithHash(map, key, hash);
+  return mapentry ? mapentry->value : NULL;
+}
+
+// Same as `MapGet()` but looks up the `keylen` bytes at `key`, see `MapPutN()`.
+void *MapGetN(Map *const map, void *const key, const size_t keylen) {
+  MapEntry *mapentry = MapGetEntryN(map, key, keylen);
+  return mapentry ? mapentry->value : NULL;
+}
+
+// Same as `MapGetN()` but uses the given precomputed `hash` of `key`.
+void *MapGetNWithHash(Map *const map, void *const key, const size_t keylen,
+                      const hash_t hash) {
+  MapEntry *mapentry = MapGetEntryNWithHash(map, key, keylen, hash);
+  return mapentry ? mapentry->value : NULL;
+}
+
 // Returns a `MapEntry*` to the `MapEntry` instance that holds the given `key`.
 //
-// Traverse through the entries of the bucket at the computed `idx` value and
-// searches for a `hash` value that matches the computed `hash` value.  If we
-// find a value that is greater than the `hash` computed; not equal but greater
-// than then we immediately return `NULL` as having a value greater than the
-// computed `hash` using the `key` can only be possible when we have traversed
-// long enough but did not find any `hash` value equals to the computed `hash`.
+// The control bytes of the group the hash of `key` maps to are compared with
+// the tag of that hash at once, and only the buckets whose tag matches have
+// their keys compared.  A group with an empty bucket ends the search, a full
+// one sends it on to the next group of the probe sequence.
 MapEntry *MapGetEntry(Map *const map, void *const key) {
-  hash_t hash = map->hash(key);
-  size_t idx = CalculateIndex(hash, map->bucketslen);
+  return MapGetEntryN(map, key, MapKeyLen(map, key));
+}
 
-  if (map->buckets[idx] == NULL)
-    return NULL;
+// Same as `MapGetEntry()` but uses the given precomputed `hash` of `key`.
+MapEntry *MapGetEntryWithHash(Map *const map, void *const key,
+                              const hash_t hash) {
+  return MapGetEntryNWithHash(map, key, MapKeyLen(map, key), hash);
+}
 
-  MapEntry *current = map->buckets[idx];
+// Same as `MapGetEntry()` but looks up the `keylen` bytes at `key`, see
+// `MapPutN()`.
+MapEntry *MapGetEntryN(Map *const map, void *const key, const size_t keylen) {
+  if (map->entrieslen == 0)
+    return NULL;
+  return MapFind(map, key, keylen, MapHashN(map, key, keylen));
+}
 
-  while (current) {
-    if (hash < current->hash)
-      return (current = NULL);
-    if (hash == current->hash && map->keycmp(key, current->key))
-      break;
-    current = current->next;
-  }
+// Same as `MapGetEntryN()` but uses the given precomputed `hash` of `key`.
+MapEntry *MapGetEntryNWithHash(Map *const map, void *const key,
+                               const size_t keylen, const hash_t hash) {
+  if (map->entrieslen == 0)
+    return NULL;
+  return MapFind(map, key, keylen, hash);
+}
 
-  return current;
+// Empties the bucket `idx` of `table` and returns the value of its entry, see
+// `MapRemove()`.
+static void *MapRemoveBucket(const Map *const table, const size_t idx) {
+  u_int8_t *const ctrl = MapCtrl(table);
+  const size_t entry = MapIndexGet(table, idx);
+  size_t *const used = MapEntriesUsed(table);
+  if (MapGroupMatch(ctrl + idx - idx % MAP_GROUP_WIDTH, MAP_CTRL_EMPTY))
+    ctrl[idx] = MAP_CTRL_EMPTY;
+  else
+    ctrl[idx] = MAP_CTRL_DELETED;
+  // A deleted bucket keeps its entry used, so that the buckets taken never
+  // outnumber the entries used.  So does any entry of growing buckets, whose
+  // first ones are kept for the entries still to move.
+  if (entry + 1 == *used && ctrl[idx] == MAP_CTRL_EMPTY &&
+      *MapMigrationOf(table) == NULL)
+    --(*used);
+  else
+    table->buckets[entry].keylen = MAP_ENTRY_REMOVED;
+  return table->buckets[entry].value;
 }
 
 // Returns a `void*` and removes to/the value mapped by the given `key`.
 //
-// `MapEntry` with the associated key i.e., `key` will be deleted from the
-// free-store while returning a `void*` to the value mapped with the given
-// `key`.
-//
-// This should be very reminiscent of what we are doing in function `MapEntry
-// *MapGetEntry(Map *const map, void *const key)` except after locating the
-// entry in the `buckets` list we free the memory occupied by that `MapEntry`.
+// The bucket holding the `key` is marked empty again if its group still has an
+// empty bucket, as no probe was ever sent past that group, or deleted
+// otherwise so that probes keep going past it.  Deleted buckets are reused by
+// later insertions and cleared the next time the `Map` instance is resized.
+// The entry is left as a hole in the order, see `MapEntryRemoved()`, unless it
+// is the last one.  Entries not moved yet out of the previous buckets of a
+// growing `Map` instance are removed from there.
 // This function is not responsible to free up the free-store occupied by the
-// value inside of the `MapEntry` the caller should take care of that.
+// key or the value, the caller should take care of that.
 void *MapRemove(Map *const map, void *const key) {
-  hash_t hash = map->hash(key);
-  size_t idx = CalculateIndex(hash, map->bucketslen);
+  return MapRemoveN(map, key, MapKeyLen(map, key));
+}
 
-  if (map->buckets[idx] == NULL)
+// Same as `MapRemove()` but removes the `keylen` bytes at `key`, see
+// `MapPutN()`.
+void *MapRemoveN(Map *const map, void *const key, const size_t keylen) {
+  if (map->entrieslen == 0)
     return NULL;
-
-  MapEntry *current = map->buckets[idx];
-  MapEntry *prev = NULL;
-
-  while (current) {
-    if (hash < current->hash)
-      return (current = NULL);
-    if (hash == current->hash && map->keycmp(key, current->key))
-      break;
-    prev = current;
-    current = current->next;
+  const hash_t hash = MapHashN(map, key, keylen);
+  const size_t idx = MapProbe(map, key, keylen, hash, NULL);
+  if (idx != map->bucketslen) {
+    --(map->entrieslen);
+    return MapRemoveBucket(map, idx);
   }
-
-  if (current == NULL)
+  const MapMigration *const migration = *MapMigrationOf(map);
+  if (migration == NULL)
+    return NULL;
+  const Map source = MapMigrationSource(map, migration);
+  const size_t old = MapMigrationProbe(&source, key, keylen, hash);
+  if (old == source.bucketslen)
     return NULL;
-
-  void *ret = current->value;
-  if (prev)
-    prev->next = current->next;
-  else
-    map->buckets[idx] = current->next;
-  free(current);
   --(map->entrieslen);
-
-  return ret;
+  return MapRemoveBucket(&source, old);
 }
@@ -49,8 +49,16 @@ void StringStreamConcat(StringStream* const sstream, const char* format, ...) {
   // `vsnprintf()` has overflow protection, so if this condition evaluates to
   // true that means `vsnprintf()` did not concatenate the new string properly;
   // this clause takes care of that.
-  if (StringStreamRealloc(sstream, sstream->length + format_size) ==
-      SSTREAM_REALLOC_SUCCESS) {
+  //
+  // `avail` already keeps the last byte of the buffer aside, so a string that
+  // is one or two bytes short of filling the buffer needs a re-allocation as
+  // well; the computed capacity always leaves room for both terminators.
+  const size_t required = sstream->length + format_size;
+  if (format_size >= avail &&
+      StringStreamRealloc(sstream, required > sstream->capacity
+                                       ? required
+                                       : sstream->capacity + 1) ==
+          SSTREAM_REALLOC_SUCCESS) {
     va_start(args, format);
     avail = _GET_STRING_STREAM_AVAILABLE_SPACE(*sstream);
     format_size = vsnprintf(sstream->data + sstream->length,
@@ -67,12 +75,21 @@ void StringStreamConcat(StringStream* const sstream, const char* format, ...) {
 //
 // The `length` property will decide how many bytes to copy from `data` to
 // `sstream->data` while ignoring the `NULL` bytes on the way.
-void StringStreamRead(StringStream* const sstream, const void* data,
-                      const size_t length) {
-  (void)StringStreamRealloc(sstream, sstream->length + length);
+//
+// Function returns `SSTREAM_READ_FAILURE` and copies nothing if the buffer
+// could not be re-allocated, `SSTREAM_READ_SUCCESS` otherwise.
+u_int8_t StringStreamRead(StringStream* const sstream, const void* data,
+                          const size_t length) {
+  // Data that exactly fills the buffer leaves no room for the terminator.
+  const size_t required = sstream->length + length;
+  const size_t reserved =
+      required == sstream->capacity ? required + 1 : required;
+  if (StringStreamRealloc(sstream, reserved) == SSTREAM_REALLOC_FAILURE)
+    return SSTREAM_READ_FAILURE;
   memcpy(sstream->data + sstream->length, data, length);
   sstream->length += length;
   _TERMINATE_STRING_STREAM_BUFFER(*sstream);
+  return SSTREAM_READ_SUCCESS;
 }
 
 // Impedes the position of the terminate character `\0` by `length`, or if the
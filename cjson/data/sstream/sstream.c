@@ -33,6 +33,7 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include "allocator.h"
 #include "data/sstream/modifiers.h"
 
 // Computes the capacity of the ``StringStream`` instance using the Python list
@@ -61,10 +62,24 @@ StringStream StringStreamAlloc() {
 // `capacity` which we calculate using the function
 // `ComputeStringStreamBufferCapacity()`.
 StringStream StringStreamNAlloc(const size_t length) {
-  StringStream sstream = {.data = (void*)0, .length = 0, .capacity = 0};
+  return StringStreamNAllocWithAllocator(length, NULL);
+}
+
+// Returns a initialized `StringStream` instance of given length whose memory
+// comes from the given `allocator`, or from the process-wide allocator if
+// `allocator` is `NULL`.
+//
+// The `StringStream` instance keeps using `allocator` for every re-allocation
+// and for releasing its data.
+StringStream StringStreamNAllocWithAllocator(const size_t length,
+                                             const Allocator* const allocator) {
+  StringStream sstream = {
+      .data = (void*)0, .length = 0, .capacity = 0,
+      .allocator = allocator ? allocator : AllocatorGetDefault()};
   size_t capacity;
   ComputeStringStreamBufferCapacity(length, &capacity);
-  if (sstream.data = (char*)malloc(capacity * sizeof(char))) {
+  if (sstream.data = (char*)AllocatorMalloc(sstream.allocator,
+                                            capacity * sizeof(char))) {
     sstream.capacity = capacity;
     _TERMINATE_STRING_STREAM_BUFFER(sstream);
   }
@@ -115,14 +130,15 @@ u_int8_t StringStreamRealloc(StringStream* const sstream, const size_t length) {
   size_t capacity;
   ComputeStringStreamBufferCapacity(length, &capacity);
   char* data = sstream->data;
-  if (!(sstream->data =
-            (char*)realloc(sstream->data, capacity * sizeof(char)))) {
-    if (!(sstream->data = (char*)malloc(capacity * sizeof(char)))) {
+  if (!(sstream->data = (char*)AllocatorRealloc(
+            sstream->allocator, sstream->data, capacity * sizeof(char)))) {
+    if (!(sstream->data = (char*)AllocatorMalloc(sstream->allocator,
+                                                 capacity * sizeof(char)))) {
       sstream->data = data;
       return SSTREAM_REALLOC_FAILURE;
     }
     memcpy(sstream->data, data, sstream->length * sizeof(char));
-    free(data);
+    AllocatorFree(sstream->allocator, data);
   }
   sstream->capacity = capacity;
   return SSTREAM_REALLOC_SUCCESS;
@@ -132,6 +148,6 @@ u_int8_t StringStreamRealloc(StringStream* const sstream, const size_t length) {
 void StringStreamDealloc(StringStream* const sstream) {
   sstream->length = 0;
   sstream->capacity = 0;
-  free(sstream->data);
+  AllocatorFree(sstream->allocator, sstream->data);
   sstream->data = (void*)0;
 }
@@ -32,6 +32,8 @@
 #include <stdlib.h>
 #include <sys/types.h>
 
+#include "allocator.h"
+
 // Computes the capacity of the `Vector` instance using the Python list resize
 // routine so that the following evaluates to true:
 //      0 <= size <= capacity
@@ -56,10 +58,23 @@ Vector VectorDefAlloc() { return VectorAlloc(VECTOR_DEFAULT_SIZE); }
 // `capacity` which we calculate using the function
 // `ComputeVectorBufferCapacity()`.
 Vector VectorAlloc(const size_t size) {
-  Vector vector = {.data = (void*)0, .size = 0, .capacity = 0};
+  return VectorAllocWithAllocator(size, NULL);
+}
+
+// Returns an initialized instance of `Vector` of `length` whose memory comes
+// from the given `allocator`, or from the process-wide allocator if
+// `allocator` is `NULL`.
+//
+// The `Vector` instance keeps using `allocator` for every re-allocation and
+// for releasing its data and its elements.
+Vector VectorAllocWithAllocator(const size_t size,
+                                const Allocator* const allocator) {
+  Vector vector = {.data = (void*)0, .size = 0, .capacity = 0,
+                   .allocator = allocator ? allocator : AllocatorGetDefault()};
   size_t capacity;
   ComputeVectorBufferCapacity(size, &capacity);
-  if ((vector.data = (void**)malloc(capacity * sizeof(void*))))
+  if ((vector.data = (void**)AllocatorCacheMalloc(vector.allocator,
+                                                  capacity * sizeof(void*))))
     vector.capacity = capacity;
   return vector;
 }
@@ -80,20 +95,46 @@ u_int8_t VectorResize(Vector* const vector, const size_t size) {
   size_t capacity;
   ComputeVectorBufferCapacity(size, &capacity);
   void** data = vector->data;
-  vector->data = (void**)realloc(vector->data, capacity * sizeof(void*));
+  vector->data = (void**)AllocatorRealloc(vector->allocator, vector->data,
+                                          capacity * sizeof(void*));
   if (!vector->data) {
-    if (!(vector->data = (void**)malloc(capacity * sizeof(void*)))) {
+    if (!(vector->data = (void**)AllocatorMalloc(vector->allocator,
+                                                 capacity * sizeof(void*)))) {
       vector->data = data;
       return VECTOR_RESIZE_FAILURE;
     }
     for (size_t i = 0; i < vector->size; ++i)
       vector->data[i] = data[i];
-    free(data);
+    AllocatorFree(vector->allocator, data);
   }
   vector->capacity = capacity;
   return VECTOR_RESIZE_SUCCESS;
 }
 
+// Re-allocates the free store space occupied by the `Vector` container down to
+// its `size`, releasing the growth slack left by earlier insertions.
+//
+// Function returns:
+//  * `VECTOR_RESIZE_NOT_REQUIRED` if the capacity already matches the size,
+//  * `VECTOR_RESIZE_SUCCESS` if the re-allocation was successful, or
+//  * `VECTOR_RESIZE_FAILURE` if the re-allocation failed, the container is
+//    then left untouched.
+u_int8_t VectorShrink(Vector* const vector) {
+  if (vector->size == vector->capacity)
+    return VECTOR_RESIZE_NOT_REQUIRED;
+  if (vector->size == 0) {
+    VectorFree(vector);
+    return VECTOR_RESIZE_SUCCESS;
+  }
+  void** data = (void**)AllocatorRealloc(vector->allocator, vector->data,
+                                         vector->size * sizeof(void*));
+  if (data == NULL)
+    return VECTOR_RESIZE_FAILURE;
+  vector->data = data;
+  vector->capacity = vector->size;
+  return VECTOR_RESIZE_SUCCESS;
+}
+
 // Copies `src` to `dest`.
 //
 // This function will not make the copies of the values stored inside of the
@@ -108,7 +149,7 @@ u_int8_t VectorCopy(Vector* const dest, Vector* const src) {
   if (dest == NULL)
     return VECTOR_COPY_FAILURE;
   if (src == NULL) {
-    dest->data = NULL;
+    VectorFree(dest);
     dest->size = 0;
     ComputeVectorBufferCapacity(dest->size, &dest->capacity);
     return VECTOR_COPY_SUCCESS;
@@ -127,10 +168,12 @@ u_int8_t VectorCopy(Vector* const dest, Vector* const src) {
 // It does not free the free-store occupied by the `Vector` elements use
 // `VectorFreeDeep()` for it.
 void VectorClear(Vector* const vector) {
-  free(vector->data);
-  vector->data = (void**)malloc(vector->capacity * sizeof(void*));
+  AllocatorCacheFree(vector->allocator, vector->data,
+                     vector->capacity * sizeof(void*));
   vector->size = 0;
   ComputeVectorBufferCapacity(vector->size, &vector->capacity);
+  vector->data = (void**)AllocatorCacheMalloc(
+      vector->allocator, vector->capacity * sizeof(void*));
 }
 
 // Frees up the free-store space occupied by the `Vector` container.
@@ -138,9 +181,10 @@ void VectorClear(Vector* const vector) {
 // It does not free the free-store occupied by the `Vector` elements use
 // `VectorFreeDeep()` for it.
 void VectorFree(Vector* const vector) {
+  AllocatorCacheFree(vector->allocator, vector->data,
+                     vector->capacity * sizeof(void*));
   vector->size = 0;
   vector->capacity = 0;
-  free(vector->data);
   vector->data = (void*)0;
 }
 
@@ -157,9 +201,7 @@ void VectorFree(Vector* const vector) {
 //          free(): double free detected in tcache 2
 //          Aborted (core dumped)
 void VectorFreeDeep(Vector* const vector) {
-  for (size_t i = 0; i < vector->capacity; ++i)
-    free(vector->data[i]);
-  vector->size = 0;
-  vector->capacity = 0;
-  vector->data = (void*)0;
+  for (size_t i = 0; i < vector->size; ++i)
+    AllocatorFree(vector->allocator, vector->data[i]);
+  VectorFree(vector);
 }
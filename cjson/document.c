@@ -0,0 +1,267 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "document.h"
+
+#include <string.h>
+#include <sys/types.h>
+
+#include "accessors.h"
+#include "bool.h"
+#include "cjson.h"
+#include "data/arena/arena.h"
+#include "data/map/map.h"
+#include "data/vector/vector.h"
+
+// Returns an empty `JSON_Document` instance.
+JSON_Document JSON_DocumentAlloc() {
+  JSON_Document document = {.arena = ArenaAlloc(), .root = NULL, .keys = NULL};
+  return document;
+}
+
+// Releases every node of `document` at once.
+void JSON_DocumentFree(JSON_Document* const document) {
+  if (document == NULL)
+    return;
+  ArenaFree(&document->arena);
+  document->root = NULL;
+}
+
+// Copies `json` into a new node allocated in `document`.
+static JSON* DocumentNode(JSON_Document* const document, const JSON json) {
+  if (document == NULL)
+    return NULL;
+  JSON* node = (JSON*)ArenaMalloc(&document->arena, sizeof(JSON));
+  if (node)
+    memcpy(node, &json, sizeof(JSON));
+  return node;
+}
+
+JSON* JSON_DocumentNull(JSON_Document* const document) {
+  return DocumentNode(document, JSON_INIT_TYPE(Null));
+}
+
+JSON* JSON_DocumentBool(JSON_Document* const document,
+                        const json_bool_t boolean) {
+  return DocumentNode(document, JSON_INIT_VAL(Bool, boolean));
+}
+
+JSON* JSON_DocumentNumber(JSON_Document* const document,
+                          const json_number_t number) {
+  return DocumentNode(document, JSON_INIT_VAL(Number, number));
+}
+
+JSON* JSON_DocumentDecimal(JSON_Document* const document,
+                           const json_decimal_t decimal) {
+  return DocumentNode(document, JSON_INIT_VAL(Decimal, decimal));
+}
+
+// Returns a new `JSON_String` node holding a copy of `string`.
+JSON* JSON_DocumentString(JSON_Document* const document,
+                          const char* const string) {
+  return JSON_DocumentStringN(document, string, string ? strlen(string) : 0);
+}
+
+// Returns a new `JSON_String` node holding a `NULL` terminated copy of the
+// `length` bytes at `string`.
+JSON* JSON_DocumentStringN(JSON_Document* const document,
+                           const char* const string, const size_t length) {
+  JSON* node = DocumentNode(document, JSON_INIT_TYPE(String));
+  if (node == NULL)
+    return NULL;
+  char* chars = (char*)ArenaMalloc(&document->arena, length + 1);
+  if (chars == NULL)
+    return NULL;
+  if (length)
+    memcpy(chars, string, length);
+  chars[length] = '\0';
+  node->flags &= ~JSON_FLAG_STRING_INLINE;
+  node->value.string = chars;
+  return node;
+}
+
+// Returns a new empty `JSON_List` node with room for `size` elements.
+JSON* JSON_DocumentList(JSON_Document* const document, const size_t size) {
+  JSON* node = DocumentNode(document, JSON_INIT_TYPE(Null));
+  if (node == NULL)
+    return NULL;
+  const size_t capacity = size ? size : VECTOR_DEFAULT_SIZE;
+  void** data = (void**)ArenaMalloc(&document->arena, capacity * sizeof(void*));
+  if (data == NULL)
+    return NULL;
+  node->type = JSON_List;
+  node->value.list.data = data;
+  node->value.list.size = 0;
+  node->value.list.capacity = capacity;
+  return node;
+}
+
+// Returns a new empty `JSON_Object` node with enough buckets for `entrieslen`
+// entries.
+JSON* JSON_DocumentObject(JSON_Document* const document,
+                          const size_t entrieslen) {
+  JSON* node = DocumentNode(document, JSON_INIT_TYPE(Null));
+  if (node == NULL)
+    return NULL;
+  const size_t bucketslen = MapComputeBucketsLen(entrieslen);
+  MapEntry* buckets =
+      (MapEntry*)ArenaCalloc(&document->arena, MapBucketsSize(bucketslen));
+  if (buckets == NULL)
+    return NULL;
+  // clang-format off
+  Map object = {.hash = Hash, .keycmp = KeyCmp, .buckets = buckets,
+                .bucketslen = bucketslen, .entrieslen = 0};
+  // clang-format on
+  node->type = JSON_Object;
+  node->value.object = object;
+  return node;
+}
+
+// Appends `value` to the `JSON_List` node `list`, growing its buffer in the
+// arena.  Returns `FALSE` if the free-store is exhausted.
+//
+// The previous buffer is abandoned in the arena, doubling the capacity keeps
+// the abandoned bytes below the size of the final buffer.
+bool_t JSON_DocumentListAdd(JSON_Document* const document, JSON* const list,
+                            JSON* const value) {
+  if (document == NULL || list == NULL || list->type != JSON_List)
+    return FALSE;
+  Vector* const vector = &list->value.list;
+  if (vector->size == vector->capacity) {
+    const size_t capacity =
+        vector->capacity ? vector->capacity * 2 : VECTOR_DEFAULT_SIZE;
+    void** data =
+        (void**)ArenaMalloc(&document->arena, capacity * sizeof(void*));
+    if (data == NULL)
+      return FALSE;
+    if (vector->size)
+      memcpy(data, vector->data, vector->size * sizeof(void*));
+    vector->data = data;
+    vector->capacity = capacity;
+  }
+  vector->data[vector->size++] = value;
+  return TRUE;
+}
+
+// Maps a copy of `key` to `value` in the `JSON_Object` node `object`, growing
+// its buckets in the arena.  Returns `FALSE` if the free-store is exhausted.
+//
+// If the `document` has a `KeyPool` the canonical copy of `key` is used instead
+// along with its precomputed hash.
+bool_t JSON_DocumentObjectPut(JSON_Document* const document, JSON* const object,
+                              const char* const key, JSON* const value) {
+  if (key == NULL)
+    return FALSE;
+  return JSON_DocumentObjectPutN(document, object, key, strlen(key), value);
+}
+
+// Same as `JSON_DocumentObjectPut()` but maps the `keylen` bytes at `key`,
+// which may hold `NULL` characters.
+bool_t JSON_DocumentObjectPutN(JSON_Document* const document,
+                               JSON* const object, const char* const key,
+                               const size_t keylen, JSON* const value) {
+  if (document == NULL || object == NULL || object->type != JSON_Object ||
+      key == NULL)
+    return FALSE;
+  Map* const map = &object->value.object;
+  MapEntry mapentry;
+  if (document->keys) {
+    const char* key_ = KeyPoolInternN(document->keys, key, keylen);
+    if (key_ == NULL)
+      return FALSE;
+    mapentry.key = (void*)key_;
+    mapentry.hash = KeyPoolKeyHash(key_);
+  } else {
+    char* key_ = (char*)ArenaMalloc(&document->arena, keylen + 1);
+    if (key_ == NULL)
+      return FALSE;
+    memcpy(key_, key, keylen);
+    key_[keylen] = '\0';
+    mapentry.key = key_;
+    // The built-in `Hash()` stops at the first `NULL` character.
+    mapentry.hash = map->hash == Hash ? HashN(key_, keylen) : map->hash(key_);
+  }
+  mapentry.keylen = keylen;
+  mapentry.value = value;
+  if (MapPutEntry(map, &mapentry))
+    return TRUE;
+
+  // Every entry is used, the buckets grow in the arena.
+  const size_t bucketslen = MapGrowBucketsLen(map);
+  MapEntry* buckets =
+      (MapEntry*)ArenaCalloc(&document->arena, MapBucketsSize(bucketslen));
+  if (buckets == NULL)
+    return FALSE;
+  MapRehash(map, buckets, bucketslen);
+  return MapPutEntry(map, &mapentry) ? TRUE : FALSE;
+}
+
+// Returns a deep copy of `json` allocated in `document`, or `NULL` if the
+// free-store is exhausted.
+JSON* JSON_DocumentImport(JSON_Document* const document,
+                          const JSON* const json) {
+  if (document == NULL || json == NULL)
+    return NULL;
+  switch (json->type) {
+    case JSON_String:
+      return JSON_DocumentStringN(document, JSON_StringData(json),
+                                  JSON_StringLength(json));
+    case JSON_List: {
+      const size_t size = JSON_ListSize(json);
+      JSON* node = JSON_DocumentList(document, size);
+      if (node == NULL)
+        return NULL;
+      for (size_t i = 0; i < size; ++i) {
+        JSON* element = JSON_DocumentImport(document, JSON_ListGet(json, i));
+        if (element == NULL ||
+            JSON_DocumentListAdd(document, node, element) == FALSE)
+          return NULL;
+      }
+      return node;
+    }
+    case JSON_Object: {
+      Map* const object = (Map*)&json->value.object;
+      JSON* node = JSON_DocumentObject(document, object->entrieslen);
+      if (node == NULL)
+        return NULL;
+      MapEntry* current = NULL;
+      MapIterator object_it = MapIteratorNew(object);
+      while ((current = MapIteratorNext(&object_it))) {
+        JSON* value = JSON_DocumentImport(document, (JSON*)current->value);
+        if (value == NULL ||
+            JSON_DocumentObjectPutN(document, node, (const char*)current->key,
+                                    current->keylen, value) == FALSE)
+          return NULL;
+      }
+      return node;
+    }
+    default:
+      return DocumentNode(document, *json);
+  }
+}
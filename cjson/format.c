@@ -0,0 +1,281 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "format.h"
+
+#include <string.h>
+#include <sys/types.h>
+
+#include "bool.h"
+#include "data/sstream/sstream.h"
+#include "internal/arch.h"
+
+#ifdef CJSON_ARCH_SSE2
+#include <emmintrin.h>
+#endif
+
+// Classes of the bytes that the formatters have to stop at; everything else is
+// copied through untouched.
+#define FORMAT_WHITESPACE 0x01
+#define FORMAT_QUOTE 0x02
+#define FORMAT_ESCAPE 0x04
+#define FORMAT_STRUCTURAL 0x08
+
+// Bytes a scan has to stop at inside and outside of a string literal.
+#define FORMAT_STOP_IN_STRING (FORMAT_QUOTE | FORMAT_ESCAPE)
+#define FORMAT_STOP_MINIFY (FORMAT_WHITESPACE | FORMAT_QUOTE)
+#define FORMAT_STOP_REFORMAT \
+  (FORMAT_WHITESPACE | FORMAT_QUOTE | FORMAT_STRUCTURAL)
+
+// clang-format off
+static const u_int8_t kByteClass[256] = {
+  ['\t'] = FORMAT_WHITESPACE, ['\n'] = FORMAT_WHITESPACE,
+  ['\r'] = FORMAT_WHITESPACE, [' ']  = FORMAT_WHITESPACE,
+  ['"']  = FORMAT_QUOTE,      ['\\'] = FORMAT_ESCAPE,
+  ['{']  = FORMAT_STRUCTURAL, ['}']  = FORMAT_STRUCTURAL,
+  ['[']  = FORMAT_STRUCTURAL, [']']  = FORMAT_STRUCTURAL,
+  [',']  = FORMAT_STRUCTURAL, [':']  = FORMAT_STRUCTURAL,
+};
+// clang-format on
+
+// A newline followed by the spaces of the deepest indentation we can emit in a
+// single copy.  Anything deeper is written out in chunks of this table.
+#define FORMAT_INDENT_CHUNK 128
+static const char kIndentTable[FORMAT_INDENT_CHUNK + 2] =
+    "\n"
+    "                                                                "
+    "                                                                ";
+
+#ifdef CJSON_ARCH_SSE2
+// Returns a bit mask of the bytes in `chunk` that might belong to one of the
+// `stop` classes.  Whitespace is approximated by every byte `<= 0x20` so the
+// caller must confirm a candidate against `kByteClass` before acting on it.
+static inline int FormatCandidateMask(const __m128i chunk, const u_int8_t stop) {
+  __m128i mask = _mm_setzero_si128();
+  if (stop & FORMAT_WHITESPACE) {
+    const __m128i space = _mm_set1_epi8(0x20);
+    mask = _mm_cmpeq_epi8(_mm_max_epu8(chunk, space), space);
+  }
+  if (stop & FORMAT_QUOTE)
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')));
+  if (stop & FORMAT_ESCAPE)
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+  if (stop & FORMAT_STRUCTURAL) {
+    // `[`, `]`, `{` and `}` differ from each other only in bits `0x20` and
+    // `0x06`, so masking those off lets a single compare find all four.
+    const __m128i bracket = _mm_andnot_si128(_mm_set1_epi8(0x26), chunk);
+    mask = _mm_or_si128(
+        mask, _mm_cmpeq_epi8(bracket, _mm_set1_epi8('[' & ~0x26)));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(',')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')));
+  }
+  return _mm_movemask_epi8(mask);
+}
+#endif
+
+// Returns a pointer to the first byte in `[begin, end)` that belongs to one of
+// the `stop` classes, or `end` if there is none.
+//
+// This is where the formatters spend most of their time so on targets with
+// `SSE2` we look at sixteen bytes at a time and only fall back to the byte
+// table for the candidates and the tail of the input.
+static const char* FormatScan(const char* begin, const char* const end,
+                              const u_int8_t stop) {
+#ifdef CJSON_ARCH_SSE2
+  while (end - begin >= 16) {
+    int mask = FormatCandidateMask(_mm_loadu_si128((const __m128i*)begin), stop);
+    while (mask) {
+      const int idx = __builtin_ctz(mask);
+      if (kByteClass[(u_int8_t)begin[idx]] & stop)
+        return begin + idx;
+      mask &= mask - 1;
+    }
+    begin += 16;
+  }
+#endif
+  for (; begin < end; ++begin)
+    if (kByteClass[(u_int8_t)*begin] & stop)
+      return begin;
+  return end;
+}
+
+// Returns a pointer one past the closing quote of the string literal starting
+// at `begin`, or `end` if the literal is not terminated.
+static const char* FormatSkipString(const char* begin, const char* const end) {
+  ++begin;
+  while ((begin = FormatScan(begin, end, FORMAT_STOP_IN_STRING)) < end) {
+    if (*begin == '"')
+      return begin + 1;
+    begin += 2;
+  }
+  return end;
+}
+
+// Returns a pointer to the first non-whitespace byte in `[begin, end)`.
+static const char* FormatSkipWhitespace(const char* begin,
+                                        const char* const end) {
+  while (begin < end && (kByteClass[(u_int8_t)*begin] & FORMAT_WHITESPACE))
+    ++begin;
+  return begin;
+}
+
+// Makes room for `length` more bytes and the terminating `\0` at the end of
+// `sstream`.
+static bool_t FormatReserve(StringStream* const sstream, const size_t length) {
+  return StringStreamRealloc(sstream, sstream->length + length + 1) ==
+                 SSTREAM_REALLOC_FAILURE
+             ? FALSE
+             : TRUE;
+}
+
+// Copies `length` bytes from `data` at the end of `sstream`, the caller must
+// have reserved the space already.
+static inline void FormatEmit(StringStream* const sstream, const char* data,
+                              const size_t length) {
+  memcpy(sstream->data + sstream->length, data, length);
+  sstream->length += length;
+}
+
+// Copies `length` bytes from `data` at the end of `sstream`, growing it first
+// if needed.
+static bool_t FormatAppend(StringStream* const sstream, const char* data,
+                           const size_t length) {
+  if (FormatReserve(sstream, length) == FALSE)
+    return FALSE;
+  FormatEmit(sstream, data, length);
+  return TRUE;
+}
+
+// Starts a new line in `sstream` indented by `width` spaces.
+static bool_t FormatAppendNewline(StringStream* const sstream, size_t width) {
+  if (FormatReserve(sstream, width + 1) == FALSE)
+    return FALSE;
+  size_t chunk = width < FORMAT_INDENT_CHUNK ? width : FORMAT_INDENT_CHUNK;
+  FormatEmit(sstream, kIndentTable, chunk + 1);
+  while ((width -= chunk)) {
+    chunk = width < FORMAT_INDENT_CHUNK ? width : FORMAT_INDENT_CHUNK;
+    FormatEmit(sstream, kIndentTable + 1, chunk);
+  }
+  return TRUE;
+}
+
+// Appends the `JSON` text held in `src` onto `dest` with all the insignificant
+// whitespace removed.
+//
+// This works directly on the bytes of `src` without ever building a `JSON`
+// tree, string literals are copied verbatim including their escape sequences.
+// The input is not validated, malformed text is minified on a best effort
+// basis.
+void JSON_Minify(StringStream* const dest, const StringStream* const src) {
+  if (dest == NULL || src == NULL || src->data == NULL)
+    return;
+  // Minified text is never longer than its source so a single reservation up
+  // front lets the loop below be nothing but scans and `memcpy()`s.
+  if (FormatReserve(dest, src->length) == FALSE)
+    return;
+
+  const char* begin = src->data;
+  const char* const end = src->data + src->length;
+  while (begin < end) {
+    const char* stop = FormatScan(begin, end, FORMAT_STOP_MINIFY);
+    if (stop < end && *stop == '"')
+      stop = FormatSkipString(stop, end);
+    FormatEmit(dest, begin, stop - begin);
+    begin = FormatSkipWhitespace(stop, end);
+  }
+  _TERMINATE_STRING_STREAM_BUFFER(*dest);
+}
+
+// Appends the `JSON` text held in `src` onto `dest` re-indented by `indent`
+// spaces per nesting level.
+//
+// Like `JSON_Minify()` this never builds a `JSON` tree.  Members are placed on
+// their own lines, keys are followed by `": "` and empty lists and objects are
+// kept as `[]` and `{}`.  An `indent` of `0` is equivalent to `JSON_Minify()`.
+void JSON_Reformat(StringStream* const dest, const StringStream* const src,
+                   const size_t indent) {
+  if (indent == 0) {
+    JSON_Minify(dest, src);
+    return;
+  }
+  if (dest == NULL || src == NULL || src->data == NULL)
+    return;
+
+  size_t depth = 0;
+  const char* begin = FormatSkipWhitespace(src->data, src->data + src->length);
+  const char* const end = src->data + src->length;
+  while (begin < end) {
+    const char* stop = FormatScan(begin, end, FORMAT_STOP_REFORMAT);
+    if (stop < end && *stop == '"')
+      stop = FormatSkipString(stop, end);
+    if (stop > begin) {
+      if (FormatAppend(dest, begin, stop - begin) == FALSE)
+        return;
+      begin = stop;
+      continue;
+    }
+
+    // `begin` is either at whitespace or at a structural character.
+    bool_t ok = TRUE;
+    switch (*begin) {
+      case '{':
+      case '[': {
+        // Keep empty containers on a single line.
+        const char* next = FormatSkipWhitespace(begin + 1, end);
+        if (next < end && *next == *begin + 2) {
+          ok = FormatAppend(dest, *begin == '{' ? "{}" : "[]", 2);
+          begin = next;
+          break;
+        }
+        ok = FormatAppend(dest, begin, 1) &&
+             FormatAppendNewline(dest, ++depth * indent);
+        break;
+      }
+      case '}':
+      case ']':
+        depth = depth ? depth - 1 : 0;
+        ok = FormatAppendNewline(dest, depth * indent) &&
+             FormatAppend(dest, begin, 1);
+        break;
+      case ',':
+        ok = FormatAppend(dest, begin, 1) &&
+             FormatAppendNewline(dest, depth * indent);
+        break;
+      case ':':
+        ok = FormatAppend(dest, ": ", 2);
+        break;
+      default:
+        break;
+    }
+    if (ok == FALSE)
+      return;
+    begin = FormatSkipWhitespace(begin + 1, end);
+  }
+  _TERMINATE_STRING_STREAM_BUFFER(*dest);
+}
@@ -64,7 +64,7 @@ char** SplitStr(const char* str, const char* sep) {
 
   // Allocate `ncomps` block of memory, each of a size of `char*` to store the
   // splited components.
-  char** comps = (char**)calloc(ncomps, sizeof(char*));
+  char** comps = (char**)calloc(ncomps + 1, sizeof(char*));
 
   // Declare `beg` and `end` pointers to point to the beginning and the end of a
   // component in the given path string.
@@ -103,7 +103,7 @@ char** SplitStr(const char* str, const char* sep) {
 
     // Allocate memory for the current component because we are about to take it
     // out.
-    char* str_ = (char*)malloc((end - beg) * sizeof(char));
+    char* str_ = (char*)malloc((end - beg + 1) * sizeof(char));
     char* ptr = str_;
     for (beg; beg != end; ++beg)
       *ptr++ = *beg;  // Copy every element from `beg` to `end` to the newly
@@ -33,32 +33,91 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "allocator.h"
+#include "bool.h"
 #include "cjson.h"
 #include "data/map/map.h"
 #include "data/vector/vector.h"
+#include "ref.h"
+
+// Makes room for one more element in a list storing its elements by value,
+// growing it the way a `Vector` grows.
+static bool_t ListReserve(json_values_t* const values) {
+  if (values->size < values->capacity)
+    return TRUE;
+  const size_t capacity =
+      values->capacity ? values->capacity * 2 : VECTOR_DEFAULT_SIZE;
+  JSON* data =
+      (JSON*)AllocatorRealloc(NULL, values->data, capacity * sizeof(JSON));
+  if (data == NULL)
+    return FALSE;
+  values->data = data;
+  values->capacity = capacity;
+  return TRUE;
+}
 
+// Adds the free-store allocated `value` to the end of `list`, which takes
+// ownership of it.
+//
+// A list storing its elements by value (see `JSON_FLAG_LIST_VALUES`) moves
+// `*value` into its array and releases the container `value` right away, or
+// for an attached shared tree (see `JSON_Ref`) copies it and drops `value`.
 void JSON_ListAdd(JSON* const list, JSON* const value) {
+  if (list->flags & JSON_FLAG_LIST_VALUES) {
+    const bool_t shared = value->flags & JSON_FLAG_SHARED;
+    if (JSON_ListAppend(list, value) && !shared)
+      AllocatorCacheFree(NULL, value, sizeof(JSON));
+    return;
+  }
   VectorPush(&list->value.list, (void*)value);
 }
 
-#define __json_copy_and_insert_into_json_list(json, obj_to_copy, list) \
-  do {                                                                 \
-    memcpy(json, &obj_to_copy, sizeof(JSON));                          \
-    JSON_ListAdd(list, json);                                          \
-  } while (0)
+// Adds a copy of `*value` to the end of `list` and returns the copy, or `NULL`
+// if the free-store is exhausted.  The copy takes over whatever `*value` owns,
+// e.g. the characters of a string.
+//
+// A list storing its elements by value copies `*value` into its array, any
+// other list into a new free-store container.  The reference held by an
+// attached shared tree (see `JSON_Ref`) is dropped once the tree is copied.
+JSON* JSON_ListAppend(JSON* const list, const JSON* const value) {
+  if (value->flags & JSON_FLAG_SHARED) {
+    JSON copy;
+    if (JSON_RefCopy(&copy, value) == FALSE)
+      return NULL;
+    JSON* const element = JSON_ListAppend(list, &copy);
+    if (element == NULL) {
+      JSON_FreeDeep(&copy);
+      return NULL;
+    }
+    JSON_RefDetach((JSON*)value);
+    return element;
+  }
+  if (list->flags & JSON_FLAG_LIST_VALUES) {
+    json_values_t* const values = &list->value.values;
+    if (ListReserve(values) == FALSE)
+      return NULL;
+    JSON* const element = values->data + values->size++;
+    memcpy(element, value, sizeof(JSON));
+    return element;
+  }
+  JSON* const element = (JSON*)AllocatorCacheMalloc(NULL, sizeof(JSON));
+  if (element == NULL)
+    return NULL;
+  memcpy(element, value, sizeof(JSON));
+  VectorPush(&list->value.list, (void*)element);
+  return element;
+}
 
-#define __json_add_null_value_to_json_list(type, list)       \
-  do {                                                       \
-    JSON* json = (JSON*)(malloc(sizeof(JSON)));              \
-    JSON type = JSON_INIT(type);                             \
-    __json_copy_and_insert_into_json_list(json, type, list); \
+#define __json_add_null_value_to_json_list(type, list) \
+  do {                                                 \
+    JSON type = JSON_INIT(type);                       \
+    JSON_ListAppend(list, &type);                      \
   } while (0)
 
-#define __json_add_value_to_json_list(type, list, value)     \
-  do {                                                       \
-    JSON* json = (JSON*)(malloc(sizeof(JSON)));              \
-    JSON type = JSON_INIT_VAL(type, value);                  \
-    __json_copy_and_insert_into_json_list(json, type, list); \
+#define __json_add_value_to_json_list(type, list, value) \
+  do {                                                   \
+    JSON type = JSON_INIT_VAL(type, value);              \
+    JSON_ListAppend(list, &type);                        \
   } while (0)
 
 void _JSON_ListAddNull(JSON* const list) {
@@ -86,6 +145,11 @@ void JSON_ObjectPut(JSON* const object, const json_string_t const key,
   MapPut(&object->value.object, (void*)key, (void*)value);
 }
 
+void JSON_ObjectPutN(JSON* const object, const json_string_t key,
+                     const size_t keylen, JSON* const value) {
+  MapPutN(&object->value.object, (void*)key, keylen, (void*)value);
+}
+
 #define __json_copy_and_insert_into_json_object(json, obj_to_copy, key, \
                                                 object)                 \
   do {                                                                  \
@@ -95,14 +159,14 @@ void JSON_ObjectPut(JSON* const object, const json_string_t const key,
 
 #define __json_add_null_value_to_json_object(type, key, object)       \
   do {                                                                \
-    JSON* json = (JSON*)(malloc(sizeof(JSON)));                       \
+    JSON* json = (JSON*)(AllocatorCacheMalloc(NULL, sizeof(JSON)));   \
     JSON type = JSON_INIT(type);                                      \
     __json_copy_and_insert_into_json_object(json, type, key, object); \
   } while (0)
 
 #define __json_add_value_to_json_object(type, object, key, value)     \
   do {                                                                \
-    JSON* json = (JSON*)(malloc(sizeof(JSON)));                       \
+    JSON* json = (JSON*)(AllocatorCacheMalloc(NULL, sizeof(JSON)));   \
     JSON type = JSON_INIT_VAL(type, value);                           \
     __json_copy_and_insert_into_json_object(json, type, key, object); \
   } while (0)
@@ -0,0 +1,473 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "msgpack.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "accessors.h"
+#include "allocator.h"
+#include "bool.h"
+#include "cjson.h"
+#include "data/map/map.h"
+#include "data/sstream/sstream.h"
+#include "data/vector/vector.h"
+#include "internal/endian.h"
+
+// clang-format off
+#define MSGPACK_NIL       0xC0
+#define MSGPACK_FALSE     0xC2
+#define MSGPACK_TRUE      0xC3
+#define MSGPACK_FLOAT32   0xCA
+#define MSGPACK_FLOAT64   0xCB
+#define MSGPACK_UINT8     0xCC
+#define MSGPACK_UINT16    0xCD
+#define MSGPACK_UINT32    0xCE
+#define MSGPACK_UINT64    0xCF
+#define MSGPACK_INT8      0xD0
+#define MSGPACK_INT16     0xD1
+#define MSGPACK_INT32     0xD2
+#define MSGPACK_INT64     0xD3
+#define MSGPACK_STR8      0xD9
+#define MSGPACK_STR16     0xDA
+#define MSGPACK_STR32     0xDB
+#define MSGPACK_ARRAY16   0xDC
+#define MSGPACK_ARRAY32   0xDD
+#define MSGPACK_MAP16     0xDE
+#define MSGPACK_MAP32     0xDF
+
+#define MSGPACK_FIXMAP    0x80
+#define MSGPACK_FIXARRAY  0x90
+#define MSGPACK_FIXSTR    0xA0
+// clang-format on
+
+// Writes the `marker` byte followed by the low `width` bytes of `argument`.
+static bool_t MsgPackWriteMarker(StringStream* const msgpack,
+                                 const u_int8_t marker,
+                                 const u_int64_t argument, const size_t width) {
+  u_int8_t item[9];
+  item[0] = marker;
+  StoreBigEndian(item + 1, argument, width);
+  return StringStreamRead(msgpack, item, width + 1) == SSTREAM_READ_SUCCESS;
+}
+
+static bool_t MsgPackWriteNumber(StringStream* const msgpack,
+                                 const json_number_t number) {
+  if (number >= 0) {
+    const u_int64_t value = (u_int64_t)number;
+    if (value < 0x80)
+      return MsgPackWriteMarker(msgpack, (u_int8_t)value, 0, 0);
+    if (value <= UINT8_MAX)
+      return MsgPackWriteMarker(msgpack, MSGPACK_UINT8, value, 1);
+    if (value <= UINT16_MAX)
+      return MsgPackWriteMarker(msgpack, MSGPACK_UINT16, value, 2);
+    if (value <= UINT32_MAX)
+      return MsgPackWriteMarker(msgpack, MSGPACK_UINT32, value, 4);
+    return MsgPackWriteMarker(msgpack, MSGPACK_UINT64, value, 8);
+  }
+  // Two's complement truncation keeps the sign in the narrower widths.
+  if (number >= -32)
+    return MsgPackWriteMarker(msgpack, (u_int8_t)number, 0, 0);
+  if (number >= INT8_MIN)
+    return MsgPackWriteMarker(msgpack, MSGPACK_INT8, (u_int64_t)number, 1);
+  if (number >= INT16_MIN)
+    return MsgPackWriteMarker(msgpack, MSGPACK_INT16, (u_int64_t)number, 2);
+  if (number >= INT32_MIN)
+    return MsgPackWriteMarker(msgpack, MSGPACK_INT32, (u_int64_t)number, 4);
+  return MsgPackWriteMarker(msgpack, MSGPACK_INT64, (u_int64_t)number, 8);
+}
+
+// Writes a floating-point value in single precision if that loses nothing and
+// in double precision otherwise.
+static bool_t MsgPackWriteDecimal(StringStream* const msgpack,
+                                  const json_decimal_t decimal) {
+  const float single = (float)decimal;
+  if ((json_decimal_t)single == decimal) {
+    u_int32_t bits;
+    memcpy(&bits, &single, sizeof(bits));
+    return MsgPackWriteMarker(msgpack, MSGPACK_FLOAT32, bits, 4);
+  }
+  u_int64_t bits;
+  memcpy(&bits, &decimal, sizeof(bits));
+  return MsgPackWriteMarker(msgpack, MSGPACK_FLOAT64, bits, 8);
+}
+
+static bool_t MsgPackWriteString(StringStream* const msgpack,
+                                 const char* const string,
+                                 const size_t length) {
+  bool_t written;
+  if (length < 32)
+    written =
+        MsgPackWriteMarker(msgpack, (u_int8_t)(MSGPACK_FIXSTR | length), 0, 0);
+  else if (length <= UINT8_MAX)
+    written = MsgPackWriteMarker(msgpack, MSGPACK_STR8, length, 1);
+  else if (length <= UINT16_MAX)
+    written = MsgPackWriteMarker(msgpack, MSGPACK_STR16, length, 2);
+  else
+    written = MsgPackWriteMarker(msgpack, MSGPACK_STR32, length, 4);
+  return written &&
+         StringStreamRead(msgpack, string, length) == SSTREAM_READ_SUCCESS;
+}
+
+// Writes the head of an array or a map, `fixed` is the marker of the format
+// that packs `count` into its low four bits and `marker16` the marker of the
+// 16-bit format, the 32-bit format always follows it.
+static bool_t MsgPackWriteContainer(StringStream* const msgpack,
+                                    const u_int8_t fixed,
+                                    const u_int8_t marker16,
+                                    const size_t count) {
+  if (count < 16)
+    return MsgPackWriteMarker(msgpack, (u_int8_t)(fixed | count), 0, 0);
+  if (count <= UINT16_MAX)
+    return MsgPackWriteMarker(msgpack, marker16, count, 2);
+  return MsgPackWriteMarker(msgpack, marker16 + 1, count, 4);
+}
+
+// Appends the MessagePack encoding of `json` onto `msgpack`.
+//
+// Every value is written in the smallest format that holds it:
+//
+//      JSON_Null     nil
+//      JSON_Boolean  false and true
+//      JSON_Number   positive or negative fixint, uint 8 to 64 for positive
+//                    numbers and int 8 to 64 for negative ones
+//      JSON_Decimal  float 32 if lossless, float 64 otherwise
+//      JSON_String   fixstr, str 8, str 16 or str 32
+//      JSON_List     fixarray, array 16 or array 32
+//      JSON_Object   fixmap, map 16 or map 32 with string keys
+//
+// Returns `FALSE` if an argument is `NULL` or if `msgpack` could not grow to
+// hold the encoding, in which case it holds a truncated prefix of it.
+bool_t JSON_ToMsgPack(StringStream* const msgpack, const JSON* const json) {
+  if (msgpack == NULL || json == NULL)
+    return FALSE;
+  switch (json->type) {
+    case JSON_Null:
+      return MsgPackWriteMarker(msgpack, MSGPACK_NIL, 0, 0);
+    case JSON_Boolean:
+      return MsgPackWriteMarker(
+          msgpack, json->value.boolean ? MSGPACK_TRUE : MSGPACK_FALSE, 0, 0);
+    case JSON_Number:
+      return MsgPackWriteNumber(msgpack, json->value.number);
+    case JSON_Decimal:
+      return MsgPackWriteDecimal(msgpack, json->value.decimal);
+    case JSON_String:
+      return MsgPackWriteString(msgpack, JSON_StringData(json),
+                                JSON_StringLength(json));
+    case JSON_List: {
+      const size_t size = JSON_ListSize(json);
+      if (!MsgPackWriteContainer(msgpack, MSGPACK_FIXARRAY, MSGPACK_ARRAY16,
+                                 size))
+        return FALSE;
+      for (size_t i = 0; i < size; ++i) {
+        if (!JSON_ToMsgPack(msgpack, JSON_ListGet(json, i)))
+          return FALSE;
+      }
+      return TRUE;
+    }
+    case JSON_Object: {
+      Map* const object = (Map*)&json->value.object;
+      if (!MsgPackWriteContainer(msgpack, MSGPACK_FIXMAP, MSGPACK_MAP16,
+                                 object->entrieslen))
+        return FALSE;
+      MapEntry* current = NULL;
+      MapIterator object_it = MapIteratorNew(object);
+      while ((current = MapIteratorNext(&object_it))) {
+        if (!MsgPackWriteString(msgpack, (const char*)current->key,
+                                current->keylen) ||
+            !JSON_ToMsgPack(msgpack, (JSON*)current->value))
+          return FALSE;
+      }
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+// Cursor over the bytes of the MessagePack object being decoded.
+typedef struct MsgPackReader {
+  const u_int8_t* cur;
+  const u_int8_t* end;
+  bool_t zero_copy;
+} MsgPackReader;
+
+// Reads the `width` bytes big-endian argument that follows a marker.
+static bool_t MsgPackReadArgument(MsgPackReader* const reader,
+                                  const size_t width,
+                                  u_int64_t* const argument) {
+  if ((size_t)(reader->end - reader->cur) < width)
+    return FALSE;
+  *argument = LoadBigEndian(reader->cur, width);
+  reader->cur += width;
+  return TRUE;
+}
+
+// Reads the length of a string whose `marker` has already been consumed,
+// returns `FALSE` if `marker` is not one of the string formats.
+static bool_t MsgPackReadStringLength(MsgPackReader* const reader,
+                                      const u_int8_t marker,
+                                      u_int64_t* const length) {
+  if ((marker & 0xE0) == MSGPACK_FIXSTR) {
+    *length = marker & 0x1F;
+    return TRUE;
+  }
+  switch (marker) {
+    case MSGPACK_STR8:
+      return MsgPackReadArgument(reader, 1, length);
+    case MSGPACK_STR16:
+      return MsgPackReadArgument(reader, 2, length);
+    case MSGPACK_STR32:
+      return MsgPackReadArgument(reader, 4, length);
+    default:
+      return FALSE;
+  }
+}
+
+// Copies the `length` bytes of a string into a `NUL` terminated string in the
+// free-store.
+static char* MsgPackCopyString(MsgPackReader* const reader,
+                               const u_int64_t length) {
+  if (length > (u_int64_t)(reader->end - reader->cur))
+    return NULL;
+  char* const string = (char*)AllocatorMalloc(NULL, (size_t)length + 1);
+  if (string == NULL)
+    return NULL;
+  memcpy(string, reader->cur, (size_t)length);
+  string[length] = '\0';
+  reader->cur += length;
+  return string;
+}
+
+// Reads an object key, which must be a string, and stores its length in
+// `keylen`.
+static char* MsgPackReadKey(MsgPackReader* const reader, size_t* const keylen) {
+  u_int64_t length;
+  if (reader->cur >= reader->end ||
+      MsgPackReadStringLength(reader, *reader->cur++, &length) == FALSE)
+    return NULL;
+  *keylen = (size_t)length;
+  return MsgPackCopyString(reader, length);
+}
+
+// Releases a child that failed to decode along with whatever it holds.
+static void MsgPackFreeChild(JSON* const child) {
+  if (child == NULL)
+    return;
+  JSON_FreeDeep(child);
+  AllocatorCacheFree(NULL, child, sizeof(JSON));
+}
+
+static bool_t MsgPackReadItem(MsgPackReader* const reader, JSON* const json,
+                              const size_t depth);
+
+static bool_t MsgPackReadList(MsgPackReader* const reader, JSON* const json,
+                              const u_int64_t count, const size_t depth) {
+  // Every item takes at least a byte, so anything larger is malformed and
+  // must not make us pre-allocate a huge list.
+  if (count > (u_int64_t)(reader->end - reader->cur))
+    return FALSE;
+  *json = JSON_INIT_TYPE_SIZE(List, (size_t)count);
+  for (u_int64_t i = 0; i < count; ++i) {
+    JSON* const item = (JSON*)AllocatorCacheMalloc(NULL, sizeof(JSON));
+    if (item == NULL || MsgPackReadItem(reader, item, depth + 1) == FALSE) {
+      MsgPackFreeChild(item);
+      return FALSE;
+    }
+    JSON_ListAdd(json, item);
+  }
+  return TRUE;
+}
+
+static bool_t MsgPackReadObject(MsgPackReader* const reader, JSON* const json,
+                                const u_int64_t count, const size_t depth) {
+  if (count > (u_int64_t)(reader->end - reader->cur) / 2)
+    return FALSE;
+  *json = JSON_INIT_TYPE_SIZE(Object, (size_t)count);
+  for (u_int64_t i = 0; i < count; ++i) {
+    size_t keylen;
+    char* const key = MsgPackReadKey(reader, &keylen);
+    if (key == NULL || MapGetN(&json->value.object, key, keylen) != NULL) {
+      AllocatorFree(NULL, key);
+      return FALSE;
+    }
+    JSON* const value = (JSON*)AllocatorCacheMalloc(NULL, sizeof(JSON));
+    if (value == NULL || MsgPackReadItem(reader, value, depth + 1) == FALSE) {
+      MsgPackFreeChild(value);
+      AllocatorFree(NULL, key);
+      return FALSE;
+    }
+    JSON_ObjectPutN(json, key, keylen, value);
+  }
+  return TRUE;
+}
+
+static bool_t MsgPackReadString(MsgPackReader* const reader, JSON* const json,
+                                const u_int64_t length) {
+  if (reader->zero_copy == TRUE) {
+    if (length > (u_int64_t)(reader->end - reader->cur))
+      return FALSE;
+    *json = JSON_InitStringViewImpl((json_string_t)reader->cur, (size_t)length);
+    reader->cur += length;
+    return TRUE;
+  }
+  if (length > (u_int64_t)(reader->end - reader->cur))
+    return FALSE;
+  *json = JSON_InitStringNImpl((json_string_t)reader->cur, (size_t)length);
+  if (JSON_StringData(json) == NULL)
+    return FALSE;
+  reader->cur += length;
+  return TRUE;
+}
+
+// Decodes the next object into `json`.  On failure `json` is left holding
+// whatever was decoded so far, ready to be released with `JSON_FreeDeep()`.
+static bool_t MsgPackReadItem(MsgPackReader* const reader, JSON* const json,
+                              const size_t depth) {
+  *json = JSON_INIT_TYPE(Null);
+  if (depth > JSON_MSGPACK_MAX_DEPTH || reader->cur >= reader->end)
+    return FALSE;
+
+  const u_int8_t marker = *reader->cur++;
+  if (marker < 0x80) {
+    *json = JSON_INIT_VAL(Number, marker);
+    return TRUE;
+  }
+  if (marker >= 0xE0) {
+    *json = JSON_INIT_VAL(Number, (int8_t)marker);
+    return TRUE;
+  }
+  if ((marker & 0xF0) == MSGPACK_FIXMAP)
+    return MsgPackReadObject(reader, json, marker & 0x0F, depth);
+  if ((marker & 0xF0) == MSGPACK_FIXARRAY)
+    return MsgPackReadList(reader, json, marker & 0x0F, depth);
+
+  u_int64_t argument;
+  if (MsgPackReadStringLength(reader, marker, &argument) == TRUE)
+    return MsgPackReadString(reader, json, argument);
+
+  switch (marker) {
+    case MSGPACK_NIL:
+      return TRUE;
+    case MSGPACK_FALSE:
+    case MSGPACK_TRUE:
+      *json = JSON_INIT_VAL(Bool, marker == MSGPACK_TRUE);
+      return TRUE;
+    case MSGPACK_FLOAT32: {
+      if (MsgPackReadArgument(reader, 4, &argument) == FALSE)
+        return FALSE;
+      const u_int32_t bits = (u_int32_t)argument;
+      float single;
+      memcpy(&single, &bits, sizeof(single));
+      *json = JSON_INIT_VAL(Decimal, single);
+      return TRUE;
+    }
+    case MSGPACK_FLOAT64: {
+      if (MsgPackReadArgument(reader, 8, &argument) == FALSE)
+        return FALSE;
+      json_decimal_t decimal;
+      memcpy(&decimal, &argument, sizeof(decimal));
+      *json = JSON_INIT_VAL(Decimal, decimal);
+      return TRUE;
+    }
+    case MSGPACK_UINT8:
+    case MSGPACK_UINT16:
+    case MSGPACK_UINT32:
+    case MSGPACK_UINT64:
+      if (MsgPackReadArgument(reader, 1 << (marker - MSGPACK_UINT8),
+                              &argument) == FALSE)
+        return FALSE;
+      if (argument <= INT64_MAX)
+        *json = JSON_INIT_VAL(Number, (json_number_t)argument);
+      else
+        *json = JSON_INIT_VAL(Decimal, (json_decimal_t)argument);
+      return TRUE;
+    case MSGPACK_INT8:
+    case MSGPACK_INT16:
+    case MSGPACK_INT32:
+    case MSGPACK_INT64: {
+      const size_t width = 1 << (marker - MSGPACK_INT8);
+      if (MsgPackReadArgument(reader, width, &argument) == FALSE)
+        return FALSE;
+      // Sign-extend the `width` bytes wide two's complement value.
+      const size_t shift = 64 - width * 8;
+      *json = JSON_INIT_VAL(Number,
+                            (json_number_t)(argument << shift) >> shift);
+      return TRUE;
+    }
+    case MSGPACK_ARRAY16:
+    case MSGPACK_ARRAY32:
+      if (MsgPackReadArgument(reader, marker == MSGPACK_ARRAY16 ? 2 : 4,
+                              &argument) == FALSE)
+        return FALSE;
+      return MsgPackReadList(reader, json, argument, depth);
+    case MSGPACK_MAP16:
+    case MSGPACK_MAP32:
+      if (MsgPackReadArgument(reader, marker == MSGPACK_MAP16 ? 2 : 4,
+                              &argument) == FALSE)
+        return FALSE;
+      return MsgPackReadObject(reader, json, argument, depth);
+    default:
+      // Bin and ext types have no `JSON` counterpart and 0xC1 is never used.
+      return FALSE;
+  }
+}
+
+// Decodes the single MessagePack object held in `msgpack` into `json`.
+//
+// If `zero_copy` is `TRUE` string values are not copied, they are decoded as
+// views (see `JSON_FLAG_STRING_VIEW`) into `msgpack->data` which then must
+// outlive the decoded tree and must not be modified.  Object keys are always
+// copied.
+//
+// Returns `TRUE` on success in which case the decoded tree lives in the
+// free-store and must be released with `JSON_FreeDeep()`.  Returns `FALSE` and
+// leaves a `JSON_Null` in `json` if `msgpack` is not well-formed, holds
+// trailing bytes, or uses something that has no `JSON` counterpart such as bin
+// and ext types, non-string or duplicate object keys.
+bool_t JSON_FromMsgPack(JSON* const json, const StringStream* const msgpack,
+                        const bool_t zero_copy) {
+  if (json == NULL)
+    return FALSE;
+  *json = JSON_INIT_TYPE(Null);
+  if (msgpack == NULL || msgpack->data == NULL)
+    return FALSE;
+  MsgPackReader reader = {
+      .cur = (const u_int8_t*)msgpack->data,
+      .end = (const u_int8_t*)msgpack->data + msgpack->length,
+      .zero_copy = zero_copy};
+  if (MsgPackReadItem(&reader, json, 0) == FALSE || reader.cur != reader.end) {
+    JSON_FreeDeep(json);
+    *json = JSON_INIT_TYPE(Null);
+    return FALSE;
+  }
+  return TRUE;
+}
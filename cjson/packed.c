@@ -0,0 +1,462 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "packed.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "accessors.h"
+#include "allocator.h"
+#include "bool.h"
+#include "cjson.h"
+#include "data/map/map.h"
+#include "data/map/ops.h"
+#include "data/vector/vector.h"
+#include "modifiers.h"
+
+#define PACKED_DEFAULT_SIZE (1 << 4)
+
+// A node of the source tree waiting to be packed at position `index` of the
+// node array, whose slot was reserved along with the ones of its siblings.
+typedef struct PackedTask {
+  const JSON* json;
+  size_t index;
+} PackedTask;
+
+typedef struct PackedWriter {
+  JSON_Packed* packed;
+  size_t nodescap;
+  size_t charscap;
+  // Offsets in `chars` of the strings written so far, keyed by the characters
+  // of the source tree, so a repeated string or key is stored once.
+  Map strings;
+  PackedTask* tasks;
+  size_t taskslen;
+  size_t taskscap;
+} PackedWriter;
+
+// Grows `*buffer` of `size`-byte items so that it holds at least `required`
+// items.
+static bool_t PackedGrow(void** const buffer, size_t* const capacity,
+                         const size_t required, const size_t size) {
+  if (required <= *capacity)
+    return TRUE;
+  size_t capacity_ = *capacity ? *capacity : PACKED_DEFAULT_SIZE;
+  while (capacity_ < required) {
+    if (capacity_ > SIZE_MAX / 2 / size)
+      return FALSE;
+    capacity_ *= 2;
+  }
+  void* buffer_ = AllocatorRealloc(NULL, *buffer, capacity_ * size);
+  if (buffer_ == NULL)
+    return FALSE;
+  *buffer = buffer_;
+  *capacity = capacity_;
+  return TRUE;
+}
+
+// Reserves `count` zeroed consecutive nodes and stores the position of the
+// first one in `offset`.
+static bool_t PackedReserve(PackedWriter* const writer, const size_t count,
+                            u_int64_t* const offset) {
+  JSON_Packed* const packed = writer->packed;
+  if (count > SIZE_MAX - packed->nodeslen ||
+      PackedGrow((void**)&packed->nodes, &writer->nodescap,
+                 packed->nodeslen + count, sizeof(JSON_PackedNode)) == FALSE)
+    return FALSE;
+  memset(packed->nodes + packed->nodeslen, 0, count * sizeof(JSON_PackedNode));
+  *offset = packed->nodeslen;
+  packed->nodeslen += count;
+  return TRUE;
+}
+
+static bool_t PackedPush(PackedWriter* const writer, const JSON* const json,
+                         const size_t index) {
+  if (PackedGrow((void**)&writer->tasks, &writer->taskscap,
+                 writer->taskslen + 1, sizeof(PackedTask)) == FALSE)
+    return FALSE;
+  writer->tasks[writer->taskslen].json = json;
+  writer->tasks[writer->taskslen].index = index;
+  ++(writer->taskslen);
+  return TRUE;
+}
+
+static bool_t PackedWriteString(PackedWriter* const writer, const size_t index,
+                                const char* const string,
+                                const size_t length) {
+  JSON_Packed* const packed = writer->packed;
+  if (length > UINT32_MAX)
+    return FALSE;
+  u_int64_t offset = 0;
+  MapEntry* const shared =
+      length > JSON_PACKED_SHORT_STRING_CAPACITY
+          ? MapGetEntryN(&writer->strings, (void*)string, length)
+          : NULL;
+  if (shared) {
+    offset = (u_int64_t)(uintptr_t)shared->value;
+  } else if (length > JSON_PACKED_SHORT_STRING_CAPACITY) {
+    if (PackedGrow((void**)&packed->chars, &writer->charscap,
+                   packed->charslen + length + 1, sizeof(char)) == FALSE)
+      return FALSE;
+    offset = packed->charslen;
+    memcpy(packed->chars + offset, string, length);
+    packed->chars[offset + length] = '\0';
+    packed->charslen += length + 1;
+    // Failing to remember the string only costs a copy if it is met again.
+    MapPutN(&writer->strings, (void*)string, length,
+            (void*)(uintptr_t)offset);
+  }
+  JSON_PackedNode* const node = packed->nodes + index;
+  node->type = JSON_String;
+  node->count = (u_int32_t)length;
+  if (length > JSON_PACKED_SHORT_STRING_CAPACITY) {
+    node->value.offset = offset;
+  } else {
+    node->flags = JSON_FLAG_STRING_INLINE;
+    memcpy(node->value.shortstr, string, length);
+  }
+  return TRUE;
+}
+
+static int PackedEntryCmp(const void* entry1, const void* entry2) {
+  const MapEntry* const lhs = *(const MapEntry* const*)entry1;
+  const MapEntry* const rhs = *(const MapEntry* const*)entry2;
+  const size_t length = lhs->keylen < rhs->keylen ? lhs->keylen : rhs->keylen;
+  const int cmp = memcmp(lhs->key, rhs->key, length);
+  if (cmp != 0 || lhs->keylen == rhs->keylen)
+    return cmp;
+  return lhs->keylen < rhs->keylen ? -1 : 1;
+}
+
+static bool_t PackedWriteList(PackedWriter* const writer, const size_t index,
+                              const JSON* const list) {
+  const size_t size = JSON_ListSize(list);
+  u_int64_t offset;
+  if (size > UINT32_MAX || PackedReserve(writer, size, &offset) == FALSE)
+    return FALSE;
+  JSON_PackedNode* const node = writer->packed->nodes + index;
+  node->type = JSON_List;
+  node->count = (u_int32_t)size;
+  node->value.offset = offset;
+  for (size_t i = 0; i < size; ++i) {
+    if (PackedPush(writer, JSON_ListGet(list, i), offset + i) == FALSE)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+static bool_t PackedWriteObject(PackedWriter* const writer, const size_t index,
+                                const Map* const object) {
+  const size_t count = object->entrieslen;
+  if (count > UINT32_MAX)
+    return FALSE;
+  MapEntry** const entries = (MapEntry**)AllocatorMalloc(
+      NULL, (count ? count : 1) * sizeof(MapEntry*));
+  if (entries == NULL)
+    return FALSE;
+  size_t i = 0;
+  MapEntry* current = NULL;
+  MapIterator object_it = MapIteratorNew((Map*)object);
+  while ((current = MapIteratorNext(&object_it)) && i < count)
+    entries[i++] = current;
+  qsort(entries, i, sizeof(MapEntry*), PackedEntryCmp);
+
+  u_int64_t offset;
+  bool_t ok = PackedReserve(writer, 2 * i, &offset);
+  if (ok) {
+    JSON_PackedNode* const node = writer->packed->nodes + index;
+    node->type = JSON_Object;
+    node->count = (u_int32_t)i;
+    node->value.offset = offset;
+  }
+  for (size_t j = 0; ok && j < i; ++j) {
+    const MapEntry* const entry = entries[j];
+    ok = PackedWriteString(writer, offset + 2 * j, (const char*)entry->key,
+                           entry->keylen) &&
+         PackedPush(writer, (const JSON*)entry->value, offset + 2 * j + 1);
+  }
+  AllocatorFree(NULL, entries);
+  return ok;
+}
+
+static bool_t PackedWriteNode(PackedWriter* const writer,
+                              const PackedTask task) {
+  JSON_PackedNode* const node = writer->packed->nodes + task.index;
+  node->type = (u_int8_t)task.json->type;
+  switch (task.json->type) {
+    case JSON_Null:
+      return TRUE;
+    case JSON_Boolean:
+      node->value.boolean = task.json->value.boolean;
+      return TRUE;
+    case JSON_Number:
+      node->value.number = task.json->value.number;
+      return TRUE;
+    case JSON_Decimal:
+      node->value.decimal = task.json->value.decimal;
+      return TRUE;
+    case JSON_String:
+      return PackedWriteString(writer, task.index, JSON_StringData(task.json),
+                               JSON_StringLength(task.json));
+    case JSON_List:
+      return PackedWriteList(writer, task.index, task.json);
+    case JSON_Object:
+      return PackedWriteObject(writer, task.index, &task.json->value.object);
+  }
+  return FALSE;
+}
+
+// Packs the tree rooted at `json` into `packed`, which must be released with
+// `JSON_PackedFree()`.
+//
+// Returns `FALSE` if the free-store is exhausted or if a string, list or object
+// is too large for the layout (more than `UINT32_MAX` characters or elements),
+// `packed` is then left empty.
+bool_t JSON_Pack(JSON_Packed* const packed, const JSON* const json) {
+  if (packed == NULL)
+    return FALSE;
+  memset(packed, 0, sizeof(JSON_Packed));
+  if (json == NULL)
+    return FALSE;
+  PackedWriter writer = {.packed = packed, .nodescap = 0, .charscap = 0,
+                         .strings = MapAllocStrAsKey(), .tasks = NULL,
+                         .taskslen = 0, .taskscap = 0};
+  u_int64_t root;
+  // An explicit stack of tasks rather than recursion so deep trees cannot
+  // overflow the call stack.
+  bool_t ok = PackedReserve(&writer, 1, &root) &&
+              PackedPush(&writer, json, (size_t)root);
+  while (ok && writer.taskslen)
+    ok = PackedWriteNode(&writer, writer.tasks[--writer.taskslen]);
+  AllocatorFree(NULL, writer.tasks);
+  MapFree(&writer.strings);
+  if (ok == FALSE) {
+    JSON_PackedFree(packed);
+    return FALSE;
+  }
+  // Give back the slack of the doubling growth, the tree is read-only.
+  JSON_PackedNode* nodes = (JSON_PackedNode*)AllocatorRealloc(
+      NULL, packed->nodes, packed->nodeslen * sizeof(JSON_PackedNode));
+  if (nodes)
+    packed->nodes = nodes;
+  if (packed->charslen) {
+    char* chars =
+        (char*)AllocatorRealloc(NULL, packed->chars, packed->charslen);
+    if (chars)
+      packed->chars = chars;
+  }
+  return TRUE;
+}
+
+static void PackedFreeChild(JSON* const child) {
+  if (child == NULL)
+    return;
+  JSON_FreeDeep(child);
+  AllocatorCacheFree(NULL, child, sizeof(JSON));
+}
+
+// Unpacks the subtree of `packed` rooted at `node` into `json`, a regular tree
+// owning copies of every string and key which is released with
+// `JSON_FreeDeep()`.  Returns `FALSE` if the free-store is exhausted, `json` is
+// then left holding whatever was unpacked so far.
+bool_t JSON_Unpack(JSON* const json, const JSON_Packed* const packed,
+                   const JSON_PackedNode* const node) {
+  *json = JSON_INIT_TYPE(Null);
+  if (packed == NULL || node == NULL)
+    return FALSE;
+  switch (node->type) {
+    case JSON_Null:
+      return TRUE;
+    case JSON_Boolean:
+      *json = JSON_INIT_VAL(Bool, node->value.boolean);
+      return TRUE;
+    case JSON_Number:
+      *json = JSON_INIT_VAL(Number, node->value.number);
+      return TRUE;
+    case JSON_Decimal:
+      *json = JSON_INIT_VAL(Decimal, node->value.decimal);
+      return TRUE;
+    case JSON_String: {
+      size_t length;
+      const char* const string = JSON_PackedString(packed, node, &length);
+      *json = JSON_InitStringNImpl((json_string_t)string, length);
+      return JSON_StringData(json) != NULL;
+    }
+    case JSON_List: {
+      *json = JSON_INIT_TYPE_SIZE(List, node->count);
+      for (size_t i = 0; i < node->count; ++i) {
+        JSON* const element = (JSON*)AllocatorCacheMalloc(NULL, sizeof(JSON));
+        if (element == NULL ||
+            JSON_Unpack(element, packed, JSON_PackedListGet(packed, node, i)) ==
+                FALSE) {
+          PackedFreeChild(element);
+          return FALSE;
+        }
+        JSON_ListAdd(json, element);
+      }
+      return TRUE;
+    }
+    case JSON_Object: {
+      *json = JSON_INIT_TYPE_SIZE(Object, node->count);
+      for (size_t i = 0; i < node->count; ++i) {
+        const JSON_PackedNode* const keynode =
+            packed->nodes + node->value.offset + 2 * i;
+        size_t keylen;
+        const char* const key_ = JSON_PackedString(packed, keynode, &keylen);
+        char* const key = (char*)AllocatorMalloc(NULL, keylen + 1);
+        JSON* const value = (JSON*)AllocatorCacheMalloc(NULL, sizeof(JSON));
+        if (key == NULL || value == NULL ||
+            JSON_Unpack(value, packed, keynode + 1) == FALSE) {
+          AllocatorFree(NULL, key);
+          PackedFreeChild(value);
+          return FALSE;
+        }
+        memcpy(key, key_, keylen);
+        key[keylen] = '\0';
+        JSON_ObjectPutN(json, key, keylen, value);
+      }
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+// Releases both buffers of `packed`.
+void JSON_PackedFree(JSON_Packed* const packed) {
+  if (packed == NULL)
+    return;
+  AllocatorFree(NULL, packed->nodes);
+  AllocatorFree(NULL, packed->chars);
+  memset(packed, 0, sizeof(JSON_Packed));
+}
+
+// Returns the number of bytes held by `packed`.
+size_t JSON_PackedMemoryUsage(const JSON_Packed* const packed) {
+  if (packed == NULL)
+    return 0;
+  return packed->nodeslen * sizeof(JSON_PackedNode) + packed->charslen;
+}
+
+// Returns the root node of `packed`, `NULL` if it is empty.
+const JSON_PackedNode* JSON_PackedRoot(const JSON_Packed* const packed) {
+  if (packed == NULL || packed->nodeslen == 0)
+    return NULL;
+  return packed->nodes;
+}
+
+// Returns the `NULL` terminated characters of a `JSON_String` node and stores
+// their count in `length` unless it is `NULL`.  Returns `NULL` for any other
+// node.
+const char* JSON_PackedString(const JSON_Packed* const packed,
+                              const JSON_PackedNode* const node,
+                              size_t* const length) {
+  if (packed == NULL || node == NULL || node->type != JSON_String)
+    return NULL;
+  if (length)
+    *length = node->count;
+  if (node->flags & JSON_FLAG_STRING_INLINE)
+    return node->value.shortstr;
+  return packed->chars + node->value.offset;
+}
+
+// Returns the number of elements of a `JSON_List` node or entries of a
+// `JSON_Object` node, `0` for any other node.
+size_t JSON_PackedSize(const JSON_PackedNode* const node) {
+  if (node == NULL || (node->type != JSON_List && node->type != JSON_Object))
+    return 0;
+  return node->count;
+}
+
+// Returns the element at `index` of a `JSON_List` node, `NULL` if there is
+// none.
+const JSON_PackedNode* JSON_PackedListGet(const JSON_Packed* const packed,
+                                          const JSON_PackedNode* const node,
+                                          const size_t index) {
+  if (packed == NULL || node == NULL || node->type != JSON_List ||
+      index >= node->count)
+    return NULL;
+  return packed->nodes + node->value.offset + index;
+}
+
+// Returns the value of `key` in a `JSON_Object` node, `NULL` if there is none.
+const JSON_PackedNode* JSON_PackedObjectGet(const JSON_Packed* const packed,
+                                            const JSON_PackedNode* const node,
+                                            const char* const key) {
+  if (key == NULL)
+    return NULL;
+  return JSON_PackedObjectGetN(packed, node, key, strlen(key));
+}
+
+// Same as `JSON_PackedObjectGet()` but looks up the `keylen` bytes at `key`,
+// which may hold `NULL` characters.
+const JSON_PackedNode* JSON_PackedObjectGetN(const JSON_Packed* const packed,
+                                             const JSON_PackedNode* const node,
+                                             const char* const key,
+                                             const size_t keylen) {
+  if (packed == NULL || node == NULL || node->type != JSON_Object ||
+      key == NULL)
+    return NULL;
+  const JSON_PackedNode* const entries = packed->nodes + node->value.offset;
+  size_t low = 0, high = node->count;
+  while (low < high) {
+    const size_t mid = low + (high - low) / 2;
+    // Entries are sorted the way `PackedEntryCmp()` orders them.
+    size_t length;
+    const char* const entry =
+        JSON_PackedString(packed, entries + 2 * mid, &length);
+    int cmp = memcmp(key, entry, keylen < length ? keylen : length);
+    if (cmp == 0 && keylen != length)
+      cmp = keylen < length ? -1 : 1;
+    if (cmp == 0)
+      return entries + 2 * mid + 1;
+    if (cmp < 0)
+      high = mid;
+    else
+      low = mid + 1;
+  }
+  return NULL;
+}
+
+// Returns the value of the entry at `index` of a `JSON_Object` node and stores
+// its key in `key` unless it is `NULL`.  Entries are sorted by key.
+const JSON_PackedNode* JSON_PackedObjectEntry(const JSON_Packed* const packed,
+                                              const JSON_PackedNode* const node,
+                                              const size_t index,
+                                              const char** const key) {
+  if (packed == NULL || node == NULL || node->type != JSON_Object ||
+      index >= node->count)
+    return NULL;
+  const JSON_PackedNode* const entry =
+      packed->nodes + node->value.offset + 2 * index;
+  if (key)
+    *key = JSON_PackedString(packed, entry, NULL);
+  return entry + 1;
+}
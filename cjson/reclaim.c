@@ -0,0 +1,135 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "reclaim.h"
+
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "bool.h"
+#include "cjson.h"
+
+// The reclamation thread and the ring of trees waiting for it, all guarded by
+// `mutex`.
+static struct {
+  pthread_mutex_t mutex;
+  // Signalled when a tree is queued or a drain starts.
+  pthread_cond_t pending;
+  // Signalled when a drain ends.
+  pthread_cond_t drained;
+  pthread_t thread;
+  bool_t running;
+  bool_t draining;
+  JSON queue[JSON_RECLAIM_QUEUE_DEPTH];
+  size_t head;
+  size_t size;
+} reclaimer = {.mutex = PTHREAD_MUTEX_INITIALIZER,
+               .pending = PTHREAD_COND_INITIALIZER,
+               .drained = PTHREAD_COND_INITIALIZER,
+               .running = FALSE,
+               .draining = FALSE,
+               .head = 0,
+               .size = 0};
+
+// Releases queued trees until the queue is empty and a drain has started.
+static void* ReclaimWorker(void* arg) {
+  (void)arg;
+  pthread_mutex_lock(&reclaimer.mutex);
+  for (;;) {
+    while (reclaimer.size == 0 && reclaimer.draining == FALSE)
+      pthread_cond_wait(&reclaimer.pending, &reclaimer.mutex);
+    if (reclaimer.size == 0)
+      break;
+    JSON json = reclaimer.queue[reclaimer.head];
+    reclaimer.head = (reclaimer.head + 1) % JSON_RECLAIM_QUEUE_DEPTH;
+    --reclaimer.size;
+    pthread_mutex_unlock(&reclaimer.mutex);
+    JSON_FreeDeep(&json);
+    pthread_mutex_lock(&reclaimer.mutex);
+  }
+  pthread_mutex_unlock(&reclaimer.mutex);
+  return NULL;
+}
+
+// Detaches the tree `json` holds and hands it to a background reclamation
+// thread, which releases it with `JSON_FreeDeep()`.  `json` is left a
+// `JSON_Null` instance, the node itself stays with the caller.
+//
+// The reclamation thread is started on first use.  Returns `FALSE` if the tree
+// was freed in the calling thread instead, because it holds nothing worth
+// deferring, the queue is full or the thread could not be started.  The
+// process-wide allocator must be thread-safe, as libc's is, and shared trees
+// attached below `json` must have been made atomic with `JSON_RefShare()`.
+bool_t JSON_FreeAsync(JSON* const json) {
+  bool_t queued = FALSE;
+  if ((json->type == JSON_List || json->type == JSON_Object) &&
+      !(json->flags & JSON_FLAG_SHARED)) {
+    pthread_mutex_lock(&reclaimer.mutex);
+    if (reclaimer.running == FALSE && reclaimer.draining == FALSE &&
+        pthread_create(&reclaimer.thread, NULL, ReclaimWorker, NULL) == 0)
+      reclaimer.running = TRUE;
+    if (reclaimer.running && reclaimer.draining == FALSE &&
+        reclaimer.size < JSON_RECLAIM_QUEUE_DEPTH) {
+      reclaimer.queue[(reclaimer.head + reclaimer.size) %
+                      JSON_RECLAIM_QUEUE_DEPTH] = *json;
+      ++reclaimer.size;
+      pthread_cond_signal(&reclaimer.pending);
+      queued = TRUE;
+    }
+    pthread_mutex_unlock(&reclaimer.mutex);
+  }
+  if (queued == FALSE)
+    JSON_FreeDeep(json);
+  *json = JSON_InitNullImpl();
+  return queued;
+}
+
+// Waits until every tree handed to `JSON_FreeAsync()` has been released and
+// stops the reclamation thread, typically at shutdown.  A later
+// `JSON_FreeAsync()` starts a new one.
+void JSON_FreeAsyncDrain() {
+  pthread_mutex_lock(&reclaimer.mutex);
+  while (reclaimer.draining)
+    pthread_cond_wait(&reclaimer.drained, &reclaimer.mutex);
+  if (reclaimer.running == FALSE) {
+    pthread_mutex_unlock(&reclaimer.mutex);
+    return;
+  }
+  reclaimer.draining = TRUE;
+  pthread_cond_signal(&reclaimer.pending);
+  pthread_mutex_unlock(&reclaimer.mutex);
+
+  pthread_join(reclaimer.thread, NULL);
+
+  pthread_mutex_lock(&reclaimer.mutex);
+  reclaimer.running = FALSE;
+  reclaimer.draining = FALSE;
+  pthread_cond_broadcast(&reclaimer.drained);
+  pthread_mutex_unlock(&reclaimer.mutex);
+}
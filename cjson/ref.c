@@ -0,0 +1,269 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "ref.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "accessors.h"
+#include "allocator.h"
+#include "bool.h"
+#include "cjson.h"
+#include "data/map/iterators.h"
+#include "data/map/map.h"
+#include "data/map/ops.h"
+#include "data/vector/vector.h"
+
+// The block a shared tree lives in: its count followed by its root node, which
+// is what handles and attachments point to.
+struct JSON_Shared {
+  atomic_size_t refs;
+  bool_t atomic;
+  JSON json;
+};
+
+// Returns the block the attached node `json` is the root of.
+static JSON_Shared* RefSharedOf(const JSON* const json) {
+  return (JSON_Shared*)((char*)json - offsetof(JSON_Shared, json));
+}
+
+// Takes a reference to `shared`.
+static void RefIncrement(JSON_Shared* const shared) {
+  if (shared->atomic) {
+    atomic_fetch_add_explicit(&shared->refs, 1, memory_order_relaxed);
+    return;
+  }
+  atomic_store_explicit(
+      &shared->refs,
+      atomic_load_explicit(&shared->refs, memory_order_relaxed) + 1,
+      memory_order_relaxed);
+}
+
+// Drops a reference to `shared` and releases it if that was the last one.
+static void RefDecrement(JSON_Shared* const shared) {
+  if (shared->atomic) {
+    if (atomic_fetch_sub_explicit(&shared->refs, 1, memory_order_acq_rel) != 1)
+      return;
+  } else {
+    const size_t refs =
+        atomic_load_explicit(&shared->refs, memory_order_relaxed) - 1;
+    atomic_store_explicit(&shared->refs, refs, memory_order_relaxed);
+    if (refs)
+      return;
+  }
+  shared->json.flags &= ~JSON_FLAG_SHARED;
+  JSON_FreeDeep(&shared->json);
+  AllocatorFree(NULL, shared);
+}
+
+// Returns a handle to a new shared tree that takes over `*json` and whatever it
+// owns, like `JSON_ListAppend()` does, or a handle to nothing if the
+// free-store is exhausted.  The container `json` itself is left to the caller.
+//
+// The count is not atomic until `JSON_RefShare()` is called.
+JSON_Ref JSON_RefNew(const JSON* const json) {
+  JSON_Ref ref = {.shared =
+                      (JSON_Shared*)AllocatorMalloc(NULL, sizeof(JSON_Shared))};
+  if (ref.shared == NULL)
+    return ref;
+  atomic_init(&ref.shared->refs, 1);
+  ref.shared->atomic = FALSE;
+  memcpy(&ref.shared->json, json, sizeof(JSON));
+  ref.shared->json.flags |= JSON_FLAG_SHARED;
+  return ref;
+}
+
+// Makes every later change to the count of `ref` atomic so that its handles
+// and the trees it is attached to can be released from any thread.  Must be
+// called before the tree is handed to another thread.
+void JSON_RefShare(const JSON_Ref ref) {
+  if (ref.shared)
+    ref.shared->atomic = TRUE;
+}
+
+// Returns a new handle to the tree of `ref`.
+JSON_Ref JSON_RefRetain(const JSON_Ref ref) {
+  if (ref.shared)
+    RefIncrement(ref.shared);
+  return ref;
+}
+
+// Drops the reference held by `*ref` and resets it, the tree is released if
+// that was the last one.
+void JSON_RefRelease(JSON_Ref* const ref) {
+  if (ref->shared == NULL)
+    return;
+  RefDecrement(ref->shared);
+  ref->shared = NULL;
+}
+
+// Returns the number of references to the tree of `ref`, attachments included.
+size_t JSON_RefCount(const JSON_Ref ref) {
+  if (ref.shared == NULL)
+    return 0;
+  return atomic_load_explicit(&ref.shared->refs, memory_order_acquire);
+}
+
+// Returns the root of the tree of `ref` for reading.
+const JSON* JSON_RefGet(const JSON_Ref ref) {
+  return ref.shared ? &ref.shared->json : NULL;
+}
+
+// Returns the root of the tree of `ref` for writing, after replacing the tree
+// of `*ref` with a copy of its own if it is shared with anyone else.  Returns
+// `NULL` and leaves `*ref` unchanged if the free-store is exhausted.
+JSON* JSON_RefMut(JSON_Ref* const ref) {
+  if (ref->shared == NULL)
+    return NULL;
+  if (JSON_RefCount(*ref) == 1)
+    return &ref->shared->json;
+  JSON copy;
+  if (JSON_RefCopy(&copy, &ref->shared->json) == FALSE)
+    return NULL;
+  JSON_Ref mine = JSON_RefNew(&copy);
+  if (mine.shared == NULL) {
+    JSON_FreeDeep(&copy);
+    return NULL;
+  }
+  JSON_RefRelease(ref);
+  *ref = mine;
+  return &ref->shared->json;
+}
+
+// Takes a new reference to the tree of `ref` and returns its root node, to be
+// added to a pointer list or an object of another tree.
+JSON* JSON_RefAttach(const JSON_Ref ref) {
+  if (ref.shared == NULL)
+    return NULL;
+  RefIncrement(ref.shared);
+  return &ref.shared->json;
+}
+
+// Drops the reference held by the attached node `json`, this is what
+// `JSON_Free()` and `JSON_FreeDeep()` do with nodes carrying
+// `JSON_FLAG_SHARED`.
+void JSON_RefDetach(JSON* const json) { RefDecrement(RefSharedOf(json)); }
+
+// Returns a new free-store node holding a copy of `json`, or `json` itself
+// with one more reference if it is an attached shared tree.
+static JSON* RefCopyNode(JSON* const json) {
+  if (json->flags & JSON_FLAG_SHARED) {
+    RefIncrement(RefSharedOf(json));
+    return json;
+  }
+  JSON* const node = (JSON*)AllocatorCacheMalloc(NULL, sizeof(JSON));
+  if (node == NULL)
+    return NULL;
+  if (JSON_RefCopy(node, json) == FALSE) {
+    AllocatorCacheFree(NULL, node, sizeof(JSON));
+    return NULL;
+  }
+  return node;
+}
+
+// Copies the tree under `src` into `dest` as a tree of its own that can be
+// modified and released with `JSON_FreeDeep()`.  Shared trees attached below
+// `src` are attached to the copy rather than copied.
+//
+// Returns `FALSE` and leaves nothing allocated if the free-store is exhausted.
+bool_t JSON_RefCopy(JSON* const dest, const JSON* const src) {
+  memcpy(dest, src, sizeof(JSON));
+  dest->flags &= ~JSON_FLAG_SHARED;
+  switch (src->type) {
+    case JSON_String: {
+      if (src->flags & (JSON_FLAG_STRING_VIEW | JSON_FLAG_STRING_INLINE) ||
+          src->value.string == NULL)
+        return TRUE;
+      const size_t length = strlen(src->value.string);
+      if ((dest->value.string = (char*)AllocatorMalloc(NULL, length + 1)) ==
+          NULL)
+        return FALSE;
+      memcpy(dest->value.string, src->value.string, length + 1);
+      return TRUE;
+    }
+    case JSON_List: {
+      const size_t size = JSON_ListSize(src);
+      if (src->flags & JSON_FLAG_LIST_VALUES) {
+        *dest = JSON_InitValueListImpl(size);
+        if (size && dest->value.values.data == NULL)
+          return FALSE;
+        for (size_t i = 0; i < size; ++i) {
+          if (JSON_RefCopy(dest->value.values.data + i,
+                           src->value.values.data + i) == FALSE)
+            goto fail;
+          ++dest->value.values.size;
+        }
+        return TRUE;
+      }
+      dest->value.list = VectorAlloc(size);
+      if (dest->value.list.data == NULL)
+        return FALSE;
+      for (size_t i = 0; i < size; ++i) {
+        JSON* const element = RefCopyNode(JSON_ListGet(src, i));
+        if (element == NULL)
+          goto fail;
+        VectorPush(&dest->value.list, element);
+      }
+      return TRUE;
+    }
+    case JSON_Object: {
+      const Map* const object = &src->value.object;
+      dest->value.object = MapAllocNBuckets(
+          MapComputeBucketsLen(object->entrieslen), object->hash,
+          object->keycmp);
+      if (dest->value.object.buckets == NULL)
+        return FALSE;
+      MapEntry* current = NULL;
+      MapIterator object_it = MapIteratorNew((Map*)object);
+      while ((current = MapIteratorNext(&object_it))) {
+        const size_t keylen = current->keylen;
+        char* const key = (char*)AllocatorMalloc(NULL, keylen + 1);
+        JSON* const value = key ? RefCopyNode((JSON*)current->value) : NULL;
+        if (value == NULL) {
+          AllocatorFree(NULL, key);
+          goto fail;
+        }
+        memcpy(key, current->key, keylen);
+        key[keylen] = '\0';
+        MapPutNWithHash(&dest->value.object, key, keylen, value,
+                        current->hash);
+      }
+      return TRUE;
+    }
+    default:
+      return TRUE;
+  }
+
+fail:
+  JSON_FreeDeep(dest);
+  return FALSE;
+}
@@ -0,0 +1,549 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "accessors.h"
+#include "allocator.h"
+#include "bool.h"
+#include "cjson.h"
+#include "data/map/map.h"
+#include "data/sstream/sstream.h"
+#include "data/vector/vector.h"
+
+#define SNAPSHOT_ALIGNMENT 8
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+
+// The layout of a snapshot, every offset is relative to the beginning of the
+// header and every node is 8-byte aligned:
+//
+//      SnapshotHeader
+//      SnapshotNode              type and count
+//        JSON_Null               no payload
+//        JSON_Boolean            no payload, `count` is the value
+//        JSON_Number             int64_t
+//        JSON_Decimal            double
+//        JSON_String             `count` characters and a `NUL` terminator
+//        JSON_List               `count` u_int64_t offsets of the elements
+//        JSON_Object             u_int32_t bucket count and padding,
+//                                `count` SnapshotEntry,
+//                                bucket count u_int32_t index slots
+//
+// Index slots hold one plus the position of the entry in the entries array, or
+// zero if they are empty, and are probed linearly from the slot the key hashes
+// to.
+typedef struct SnapshotHeader {
+  char magic[8];
+  u_int32_t byte_order;
+  u_int32_t reserved;
+  u_int64_t length;
+  u_int64_t root;
+} SnapshotHeader;
+
+typedef struct SnapshotNode {
+  u_int32_t type;
+  u_int32_t count;
+} SnapshotNode;
+
+typedef struct SnapshotEntry {
+  u_int64_t hash;
+  u_int64_t key;
+  u_int64_t value;
+} SnapshotEntry;
+
+// FNV-1a, unlike `Hash()` it must never change as it is persisted.
+static u_int64_t SnapshotHash(const char* const key, const size_t keylen) {
+  u_int64_t hash = 0xCBF29CE484222325ULL;
+  for (size_t i = 0; i < keylen; ++i) {
+    hash ^= (u_int8_t)key[i];
+    hash *= 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+// Returns the smallest power of two bucket count that keeps the index of an
+// object with `count` entries at most half full.
+static u_int64_t SnapshotBucketCount(const u_int64_t count) {
+  u_int64_t buckets = 1;
+  while (buckets < count * 2)
+    buckets <<= 1;
+  return count ? buckets : 0;
+}
+
+// Incrementally serializes a `JSON` tree, `base` is where the snapshot starts
+// in `sstream`.
+typedef struct SnapshotWriter {
+  StringStream* sstream;
+  size_t base;
+} SnapshotWriter;
+
+// Appends a node with `length` bytes of `payload` followed by `zeros` zero
+// bytes, at most `SNAPSHOT_ALIGNMENT`, and returns its offset, or
+// `JSON_SNAPSHOT_NONE` if the free-store is exhausted.
+static JSON_SnapshotNode SnapshotAppendNodeZeros(SnapshotWriter* const writer,
+                                                 const JSON_type type,
+                                                 const u_int32_t count,
+                                                 const void* const payload,
+                                                 const size_t length,
+                                                 const size_t zeros) {
+  static const u_int8_t kPadding[2 * SNAPSHOT_ALIGNMENT] = {0};
+  StringStream* const sstream = writer->sstream;
+  const JSON_SnapshotNode node = sstream->length - writer->base;
+  const SnapshotNode head = {.type = (u_int32_t)type, .count = count};
+  const size_t padding =
+      zeros + (SNAPSHOT_ALIGNMENT - (length + zeros) % SNAPSHOT_ALIGNMENT) %
+                  SNAPSHOT_ALIGNMENT;
+  // Reserves the terminator too so none of the appends below re-allocates.
+  if (StringStreamRealloc(sstream, sstream->length + sizeof(head) + length +
+                                       padding + 1) == SSTREAM_REALLOC_FAILURE)
+    return JSON_SNAPSHOT_NONE;
+  StringStreamRead(sstream, &head, sizeof(head));
+  if (length)
+    StringStreamRead(sstream, payload, length);
+  StringStreamRead(sstream, kPadding, padding);
+  return node;
+}
+
+// Appends a node with `length` bytes of `payload` and returns its offset, or
+// `JSON_SNAPSHOT_NONE` if the free-store is exhausted.
+static JSON_SnapshotNode SnapshotAppendNode(SnapshotWriter* const writer,
+                                            const JSON_type type,
+                                            const u_int32_t count,
+                                            const void* const payload,
+                                            const size_t length) {
+  return SnapshotAppendNodeZeros(writer, type, count, payload, length, 0);
+}
+
+// The characters are appended straight from `string`, the padding after them
+// provides the `NUL` terminator.
+static JSON_SnapshotNode SnapshotAppendString(SnapshotWriter* const writer,
+                                              const char* const string,
+                                              const size_t length) {
+  if (length > UINT32_MAX)
+    return JSON_SNAPSHOT_NONE;
+  return SnapshotAppendNodeZeros(writer, JSON_String, (u_int32_t)length,
+                                 string, length, 1);
+}
+
+static JSON_SnapshotNode SnapshotAppendValue(SnapshotWriter* const writer,
+                                             const JSON* const json);
+
+static JSON_SnapshotNode SnapshotAppendList(SnapshotWriter* const writer,
+                                            const JSON* const list) {
+  const size_t size = JSON_ListSize(list);
+  if (size > UINT32_MAX)
+    return JSON_SNAPSHOT_NONE;
+  u_int64_t* const elements = (u_int64_t*)AllocatorMalloc(
+      NULL, (size ? size : 1) * sizeof(u_int64_t));
+  if (elements == NULL)
+    return JSON_SNAPSHOT_NONE;
+  JSON_SnapshotNode node = JSON_SNAPSHOT_NONE;
+  for (size_t i = 0; i < size; ++i) {
+    if ((elements[i] = SnapshotAppendValue(writer, JSON_ListGet(list, i))) ==
+        JSON_SNAPSHOT_NONE)
+      goto out;
+  }
+  node = SnapshotAppendNode(writer, JSON_List, (u_int32_t)size, elements,
+                            size * sizeof(u_int64_t));
+out:
+  AllocatorFree(NULL, elements);
+  return node;
+}
+
+static JSON_SnapshotNode SnapshotAppendObject(SnapshotWriter* const writer,
+                                              const Map* const object) {
+  const u_int64_t count = object->entrieslen;
+  const u_int64_t buckets = SnapshotBucketCount(count);
+  if (count > UINT32_MAX || buckets > UINT32_MAX)
+    return JSON_SNAPSHOT_NONE;
+  const size_t length = sizeof(u_int64_t) + count * sizeof(SnapshotEntry) +
+                        buckets * sizeof(u_int32_t);
+  u_int8_t* const payload = (u_int8_t*)AllocatorCalloc(NULL, length, 1);
+  if (payload == NULL)
+    return JSON_SNAPSHOT_NONE;
+  const u_int32_t buckets_ = (u_int32_t)buckets;
+  memcpy(payload, &buckets_, sizeof(buckets_));
+  SnapshotEntry* const entries = (SnapshotEntry*)(payload + sizeof(u_int64_t));
+  u_int32_t* const index = (u_int32_t*)(entries + count);
+
+  JSON_SnapshotNode node = JSON_SNAPSHOT_NONE;
+  u_int32_t i = 0;
+  MapEntry* current = NULL;
+  MapIterator object_it = MapIteratorNew((Map*)object);
+  while ((current = MapIteratorNext(&object_it))) {
+    const char* const key = (const char*)current->key;
+    const size_t keylen = current->keylen;
+    SnapshotEntry* const entry = entries + i;
+    entry->hash = SnapshotHash(key, keylen);
+    if ((entry->key = SnapshotAppendString(writer, key, keylen)) ==
+            JSON_SNAPSHOT_NONE ||
+        (entry->value = SnapshotAppendValue(
+             writer, (const JSON*)current->value)) == JSON_SNAPSHOT_NONE)
+      goto out;
+    u_int64_t slot = entry->hash & (buckets - 1);
+    while (index[slot])
+      slot = (slot + 1) & (buckets - 1);
+    index[slot] = ++i;
+  }
+  node = SnapshotAppendNode(writer, JSON_Object, (u_int32_t)count, payload,
+                            length);
+out:
+  AllocatorFree(NULL, payload);
+  return node;
+}
+
+// Appends `json` after its children, so that the offsets of the children are
+// known by the time the node itself is written.
+static JSON_SnapshotNode SnapshotAppendValue(SnapshotWriter* const writer,
+                                             const JSON* const json) {
+  switch (json->type) {
+    case JSON_Null:
+      return SnapshotAppendNode(writer, JSON_Null, 0, NULL, 0);
+    case JSON_Boolean:
+      return SnapshotAppendNode(writer, JSON_Boolean,
+                                json->value.boolean ? 1 : 0, NULL, 0);
+    case JSON_Number: {
+      const int64_t number = json->value.number;
+      return SnapshotAppendNode(writer, JSON_Number, 0, &number,
+                                sizeof(number));
+    }
+    case JSON_Decimal: {
+      const double decimal = json->value.decimal;
+      return SnapshotAppendNode(writer, JSON_Decimal, 0, &decimal,
+                                sizeof(decimal));
+    }
+    case JSON_String:
+      return SnapshotAppendString(writer, JSON_StringData(json),
+                                  JSON_StringLength(json));
+    case JSON_List:
+      return SnapshotAppendList(writer, json);
+    case JSON_Object:
+      return SnapshotAppendObject(writer, &json->value.object);
+  }
+  return JSON_SNAPSHOT_NONE;
+}
+
+// Appends the snapshot of `json` onto `snapshot`.
+//
+// Every node starts at an 8-byte aligned offset and refers to its children with
+// offsets rather than pointers.  Object keys are hashed at write time into a
+// per-object open addressing index so lookups only hash the searched key.
+// Numbers are stored in native byte order, snapshots are not portable across
+// byte orders.
+//
+// Returns `FALSE` if the free-store is exhausted or if a string, list or object
+// is too large for the format (more than `UINT32_MAX` bytes or elements).
+bool_t JSON_SnapshotWrite(StringStream* const snapshot,
+                          const JSON* const json) {
+  if (snapshot == NULL || json == NULL)
+    return FALSE;
+  SnapshotWriter writer = {.sstream = snapshot, .base = snapshot->length};
+  SnapshotHeader header = {.byte_order = SNAPSHOT_BYTE_ORDER};
+  memcpy(header.magic, JSON_SNAPSHOT_MAGIC, sizeof(header.magic));
+  if (StringStreamRead(snapshot, &header, sizeof(header)) ==
+      SSTREAM_READ_FAILURE)
+    return FALSE;
+  if ((header.root = SnapshotAppendValue(&writer, json)) ==
+      JSON_SNAPSHOT_NONE) {
+    StringStreamRetreat(snapshot, snapshot->length - writer.base);
+    return FALSE;
+  }
+  header.length = snapshot->length - writer.base;
+  memcpy(snapshot->data + writer.base, &header, sizeof(header));
+  return TRUE;
+}
+
+// Initializes `snapshot` over the `length` bytes at `data`.
+//
+// `data` is not copied so it must outlive `snapshot` and must be 8-byte
+// aligned.  Returns `FALSE` if `data` does not hold a snapshot written on a
+// machine with the same byte order.
+bool_t JSON_SnapshotFromBuffer(JSON_Snapshot* const snapshot,
+                               const void* const data, const size_t length) {
+  if (snapshot == NULL)
+    return FALSE;
+  snapshot->data = NULL;
+  snapshot->length = 0;
+  snapshot->mapped = FALSE;
+  if (data == NULL || (uintptr_t)data % SNAPSHOT_ALIGNMENT ||
+      length < sizeof(SnapshotHeader))
+    return FALSE;
+  const SnapshotHeader* const header = (const SnapshotHeader*)data;
+  // A snapshot holds at least its root node, which keeps the bounds checks of
+  // `SnapshotNodeAt()` from wrapping around.
+  if (memcmp(header->magic, JSON_SNAPSHOT_MAGIC, sizeof(header->magic)) ||
+      header->byte_order != SNAPSHOT_BYTE_ORDER ||
+      header->length < sizeof(SnapshotHeader) + sizeof(SnapshotNode) ||
+      header->length > length)
+    return FALSE;
+  snapshot->data = (const u_int8_t*)data;
+  snapshot->length = header->length;
+  return TRUE;
+}
+
+// Maps the snapshot file at `path` read-only into memory.
+//
+// Pages are shared with every other process mapping the same file and are only
+// read from disk once touched.  Returns `FALSE` if the file cannot be mapped or
+// does not hold a snapshot, release a mapped snapshot with
+// `JSON_SnapshotClose()`.
+bool_t JSON_SnapshotOpen(JSON_Snapshot* const snapshot,
+                         const char* const path) {
+  if (snapshot == NULL || path == NULL)
+    return FALSE;
+  const int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return FALSE;
+  struct stat st;
+  if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(SnapshotHeader)) {
+    close(fd);
+    return FALSE;
+  }
+  const size_t length = (size_t)st.st_size;
+  void* const data = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping keeps its own reference to the file.
+  close(fd);
+  if (data == MAP_FAILED)
+    return FALSE;
+  if (JSON_SnapshotFromBuffer(snapshot, data, length) == FALSE) {
+    munmap(data, length);
+    return FALSE;
+  }
+  // Unmap the whole file even if the snapshot is followed by other bytes.
+  snapshot->length = length;
+  snapshot->mapped = TRUE;
+  return TRUE;
+}
+
+// Unmaps a snapshot opened with `JSON_SnapshotOpen()`, does nothing more than
+// resetting `snapshot` if it was initialized with `JSON_SnapshotFromBuffer()`.
+void JSON_SnapshotClose(JSON_Snapshot* const snapshot) {
+  if (snapshot == NULL)
+    return;
+  if (snapshot->mapped == TRUE && snapshot->data != NULL)
+    munmap((void*)snapshot->data, snapshot->length);
+  snapshot->data = NULL;
+  snapshot->length = 0;
+  snapshot->mapped = FALSE;
+}
+
+// Returns the root node of `snapshot`.
+JSON_SnapshotNode JSON_SnapshotRoot(const JSON_Snapshot* const snapshot) {
+  if (snapshot == NULL || snapshot->data == NULL)
+    return JSON_SNAPSHOT_NONE;
+  return ((const SnapshotHeader*)snapshot->data)->root;
+}
+
+// Returns the head of `node` if `node` and its `payload` bytes lie within the
+// snapshot, `NULL` otherwise.
+//
+// `snapshot->length` holds at least a header and a node, see
+// `JSON_SnapshotFromBuffer()`.
+static const SnapshotNode* SnapshotNodeAt(const JSON_Snapshot* const snapshot,
+                                          const JSON_SnapshotNode node,
+                                          const u_int64_t payload) {
+  if (snapshot == NULL || snapshot->data == NULL ||
+      node < sizeof(SnapshotHeader) || node % SNAPSHOT_ALIGNMENT ||
+      node > snapshot->length - sizeof(SnapshotNode) ||
+      payload > snapshot->length - sizeof(SnapshotNode) - node)
+    return NULL;
+  return (const SnapshotNode*)(snapshot->data + node);
+}
+
+// Returns the head of `node` if it is a node of the given `type` whose whole
+// payload lies within the snapshot, `NULL` otherwise.
+static const SnapshotNode* SnapshotNodeOfType(
+    const JSON_Snapshot* const snapshot, const JSON_SnapshotNode node,
+    const JSON_type type) {
+  const SnapshotNode* const head = SnapshotNodeAt(snapshot, node, 0);
+  if (head == NULL || head->type != (u_int32_t)type)
+    return NULL;
+  u_int64_t payload = 0;
+  switch (type) {
+    case JSON_Number:
+    case JSON_Decimal:
+      payload = sizeof(u_int64_t);
+      break;
+    case JSON_String:
+      payload = (u_int64_t)head->count + 1;
+      break;
+    case JSON_List:
+      payload = (u_int64_t)head->count * sizeof(u_int64_t);
+      break;
+    case JSON_Object: {
+      if (SnapshotNodeAt(snapshot, node, sizeof(u_int64_t)) == NULL)
+        return NULL;
+      const u_int32_t buckets = *(const u_int32_t*)(head + 1);
+      if (buckets != SnapshotBucketCount(head->count))
+        return NULL;
+      payload = sizeof(u_int64_t) +
+                (u_int64_t)head->count * sizeof(SnapshotEntry) +
+                (u_int64_t)buckets * sizeof(u_int32_t);
+      break;
+    }
+    default:
+      break;
+  }
+  return SnapshotNodeAt(snapshot, node, payload);
+}
+
+// Returns the `JSON_type` of `node`.
+//
+// Every accessor below checks that `node` lies within the snapshot, so even a
+// corrupt snapshot is never read out of bounds.  Nodes that fail the check,
+// including `JSON_SNAPSHOT_NONE`, read as `JSON_Null`.
+JSON_type JSON_SnapshotType(const JSON_Snapshot* const snapshot,
+                            const JSON_SnapshotNode node) {
+  const SnapshotNode* const head = SnapshotNodeAt(snapshot, node, 0);
+  if (head == NULL || head->type > JSON_Object)
+    return JSON_Null;
+  return (JSON_type)head->type;
+}
+
+// Returns the value of a `JSON_Boolean` node, `FALSE` for any other node.
+json_bool_t JSON_SnapshotBool(const JSON_Snapshot* const snapshot,
+                              const JSON_SnapshotNode node) {
+  const SnapshotNode* const head =
+      SnapshotNodeOfType(snapshot, node, JSON_Boolean);
+  return head != NULL && head->count ? TRUE : FALSE;
+}
+
+// Returns the value of a `JSON_Number` node, `0` for any other node.
+json_number_t JSON_SnapshotNumber(const JSON_Snapshot* const snapshot,
+                                  const JSON_SnapshotNode node) {
+  const SnapshotNode* const head =
+      SnapshotNodeOfType(snapshot, node, JSON_Number);
+  return head != NULL ? *(const int64_t*)(head + 1) : 0;
+}
+
+// Returns the value of a `JSON_Decimal` node, `0.0` for any other node.
+json_decimal_t JSON_SnapshotDecimal(const JSON_Snapshot* const snapshot,
+                                    const JSON_SnapshotNode node) {
+  const SnapshotNode* const head =
+      SnapshotNodeOfType(snapshot, node, JSON_Decimal);
+  return head != NULL ? *(const double*)(head + 1) : 0.0;
+}
+
+// Returns the `NULL` terminated characters of a `JSON_String` node and stores
+// their count in `length` unless it is `NULL`.  Returns `NULL` for any other
+// node.
+const char* JSON_SnapshotString(const JSON_Snapshot* const snapshot,
+                                const JSON_SnapshotNode node,
+                                size_t* const length) {
+  const SnapshotNode* const head =
+      SnapshotNodeOfType(snapshot, node, JSON_String);
+  if (head == NULL)
+    return NULL;
+  if (length != NULL)
+    *length = head->count;
+  return (const char*)(head + 1);
+}
+
+// Returns the number of elements of a `JSON_List` node or entries of a
+// `JSON_Object` node, `0` for any other node.
+size_t JSON_SnapshotSize(const JSON_Snapshot* const snapshot,
+                         const JSON_SnapshotNode node) {
+  const JSON_type type = JSON_SnapshotType(snapshot, node);
+  if (type != JSON_List && type != JSON_Object)
+    return 0;
+  const SnapshotNode* const head = SnapshotNodeOfType(snapshot, node, type);
+  return head != NULL ? head->count : 0;
+}
+
+// Returns the element at `index` of a `JSON_List` node.
+JSON_SnapshotNode JSON_SnapshotListGet(const JSON_Snapshot* const snapshot,
+                                       const JSON_SnapshotNode node,
+                                       const size_t index) {
+  const SnapshotNode* const head =
+      SnapshotNodeOfType(snapshot, node, JSON_List);
+  if (head == NULL || index >= head->count)
+    return JSON_SNAPSHOT_NONE;
+  return ((const u_int64_t*)(head + 1))[index];
+}
+
+// Returns the value of `key` in a `JSON_Object` node.
+JSON_SnapshotNode JSON_SnapshotObjectGet(const JSON_Snapshot* const snapshot,
+                                         const JSON_SnapshotNode node,
+                                         const char* const key) {
+  const SnapshotNode* const head =
+      SnapshotNodeOfType(snapshot, node, JSON_Object);
+  if (head == NULL || key == NULL || head->count == 0)
+    return JSON_SNAPSHOT_NONE;
+  const u_int32_t buckets = *(const u_int32_t*)(head + 1);
+  const SnapshotEntry* const entries =
+      (const SnapshotEntry*)((const u_int8_t*)(head + 1) + sizeof(u_int64_t));
+  const u_int32_t* const index = (const u_int32_t*)(entries + head->count);
+
+  const size_t keylen = strlen(key);
+  const u_int64_t hash = SnapshotHash(key, keylen);
+  u_int64_t slot = hash & (buckets - 1);
+  // The index is at most half full so an empty slot always ends the probe, the
+  // bound only guards against corrupt snapshots.
+  for (u_int32_t probes = 0; probes < buckets && index[slot]; ++probes) {
+    if (index[slot] <= head->count) {
+      const SnapshotEntry* const entry = entries + index[slot] - 1;
+      size_t length;
+      const char* candidate;
+      if (entry->hash == hash &&
+          (candidate = JSON_SnapshotString(snapshot, entry->key, &length)) &&
+          length == keylen && memcmp(candidate, key, keylen) == 0)
+        return entry->value;
+    }
+    slot = (slot + 1) & (buckets - 1);
+  }
+  return JSON_SNAPSHOT_NONE;
+}
+
+// Returns the value of the entry at `index` of a `JSON_Object` node and stores
+// its key in `key` unless it is `NULL`.  Entries are in the order the object
+// was iterated when the snapshot was written.
+JSON_SnapshotNode JSON_SnapshotObjectEntry(const JSON_Snapshot* const snapshot,
+                                           const JSON_SnapshotNode node,
+                                           const size_t index,
+                                           const char** const key) {
+  const SnapshotNode* const head =
+      SnapshotNodeOfType(snapshot, node, JSON_Object);
+  if (head == NULL || index >= head->count)
+    return JSON_SNAPSHOT_NONE;
+  const SnapshotEntry* const entry =
+      (const SnapshotEntry*)((const u_int8_t*)(head + 1) + sizeof(u_int64_t)) +
+      index;
+  if (key != NULL)
+    *key = JSON_SnapshotString(snapshot, entry->key, NULL);
+  return entry->value;
+}
@@ -0,0 +1,117 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "stats.h"
+
+#include <string.h>
+#include <sys/types.h>
+
+#include "accessors.h"
+#include "bool.h"
+#include "cjson.h"
+#include "data/map/iterators.h"
+#include "data/map/map.h"
+#include "data/vector/modifiers.h"
+#include "data/vector/vector.h"
+
+// Pushes the child `json` onto `pending`, counting its node when it has one of
+// its own, or counts it as shared and leaves it out of the walk.
+static void StatsPush(Vector* const pending, JSON* const json,
+                      JSON_MemoryUsage* const usage, const bool_t node) {
+  if (json->flags & JSON_FLAG_SHARED) {
+    ++usage->shared;
+    return;
+  }
+  if (node)
+    usage->nodes += sizeof(JSON);
+  VectorPush(pending, json);
+}
+
+// Adds what `json` holds itself, not counting its node, to `usage` and pushes
+// its children onto `pending`.
+static void StatsVisit(const JSON* const json, JSON_MemoryUsage* const usage,
+                       Vector* const pending) {
+  ++usage->types[json->type];
+  switch (json->type) {
+    case JSON_String:
+      if (!(json->flags & (JSON_FLAG_STRING_VIEW | JSON_FLAG_STRING_INLINE)) &&
+          json->value.string)
+        usage->strings += strlen(json->value.string) + 1;
+      break;
+    case JSON_List: {
+      const size_t size = JSON_ListSize(json);
+      if (json->flags & JSON_FLAG_LIST_VALUES) {
+        usage->vectors += json->value.values.capacity * sizeof(JSON);
+        usage->unused += (json->value.values.capacity - size) * sizeof(JSON);
+      } else {
+        usage->vectors += json->value.list.capacity * sizeof(void*);
+        usage->unused += (json->value.list.capacity - size) * sizeof(void*);
+      }
+      for (size_t i = 0; i < size; ++i)
+        StatsPush(pending, JSON_ListGet(json, i), usage,
+                  !(json->flags & JSON_FLAG_LIST_VALUES));
+      break;
+    }
+    case JSON_Object: {
+      const Map* const object = &json->value.object;
+      usage->buckets += MapAllocatedSize(object);
+      usage->entries += object->entrieslen * sizeof(MapEntry);
+      MapEntry* current = NULL;
+      MapIterator object_it = MapIteratorNew((Map*)object);
+      while ((current = MapIteratorNext(&object_it))) {
+        usage->strings += current->keylen + 1;
+        StatsPush(pending, current->value, usage, TRUE);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Walks the tree under `json` and returns the memory it holds.
+//
+// This takes time proportional to the size of the tree; for a running total of
+// every tree of the process, see `AllocatorCounting()`.
+JSON_MemoryUsage JSON_MemoryStats(const JSON* const json) {
+  JSON_MemoryUsage usage;
+  memset(&usage, 0, sizeof(usage));
+  if (json == NULL)
+    return usage;
+  usage.nodes += sizeof(JSON);
+  // The tree is walked with an explicit stack of the nodes left to visit.
+  Vector pending = VectorAlloc(0);
+  VectorPush(&pending, (void*)json);
+  const JSON* current = NULL;
+  while ((current = (const JSON*)VectorRemove(&pending)))
+    StatsVisit(current, &usage, &pending);
+  VectorFree(&pending);
+  usage.total = usage.nodes + usage.buckets + usage.vectors + usage.strings;
+  return usage;
+}
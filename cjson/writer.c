@@ -0,0 +1,298 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "writer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "bool.h"
+#include "bytes.h"
+#include "cjson.h"
+#include "data/sstream/sstream.h"
+
+#define WRITER_IS_OBJECT(writer, level) \
+  ((writer)->objects[(level) >> 6] & ((u_int64_t)1 << ((level)&0x3F)))
+
+// Escape sequences of the bytes that can not appear verbatim inside of a `JSON`
+// string; `NULL` for the bytes that can.
+// clang-format off
+static const char* const kEscapes[0x80] = {
+  "\\u0000", "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005", "\\u0006",
+  "\\u0007", "\\b",     "\\t",     "\\n",     "\\u000b", "\\f",     "\\r",
+  "\\u000e", "\\u000f", "\\u0010", "\\u0011", "\\u0012", "\\u0013", "\\u0014",
+  "\\u0015", "\\u0016", "\\u0017", "\\u0018", "\\u0019", "\\u001a", "\\u001b",
+  "\\u001c", "\\u001d", "\\u001e", "\\u001f",
+  ['"'] = "\\\"", ['\\'] = "\\\\",
+};
+// clang-format on
+
+// Appends `length` bytes of `data`, or fails the writer if its `StringStream`
+// can not grow to hold them and the terminator.
+static inline void WriterAppend(JSON_Writer* const writer, const char* data,
+                                const size_t length) {
+  if (!writer->failed &&
+      StringStreamRead(writer->sstream, data, length) == SSTREAM_READ_FAILURE)
+    writer->failed = TRUE;
+}
+
+// Appends `length` bytes of `string` as a quoted and escaped `JSON` string.
+//
+// Bytes that do not need escaping are copied in runs so an ordinary string
+// costs two scans and a single `memcpy()`.
+static void WriterAppendString(JSON_Writer* const writer, const char* string,
+                               const size_t length) {
+  const char* const end = string + length;
+  WriterAppend(writer, "\"", 1);
+  while (string < end) {
+    const char* run = string;
+    while (run < end && ((u_int8_t)*run >= 0x80 || !kEscapes[(u_int8_t)*run]))
+      ++run;
+    WriterAppend(writer, string, run - string);
+    if (run == end)
+      break;
+    const char* escape = kEscapes[(u_int8_t)*run];
+    WriterAppend(writer, escape, strlen(escape));
+    string = run + 1;
+  }
+  WriterAppend(writer, "\"", 1);
+}
+
+// Checks that a value may be written at the current position and writes the
+// comma preceding it if required.
+static bool_t WriterBeginValue(JSON_Writer* const writer) {
+  if (writer->failed)
+    return FALSE;
+  if (writer->depth == 0) {
+    // Only a single top-level value makes a document.
+    if (writer->complete)
+      writer->failed = TRUE;
+  } else if (WRITER_IS_OBJECT(writer, writer->depth - 1)) {
+    // Inside of an object every value must be preceded by its key.
+    if (!writer->after_key)
+      writer->failed = TRUE;
+    writer->after_key = FALSE;
+  } else if (writer->needs_comma) {
+    WriterAppend(writer, ",", 1);
+  }
+  return writer->failed ? FALSE : TRUE;
+}
+
+// Book-keeping after a complete value was written in the current container.
+static void WriterEndValue(JSON_Writer* const writer) {
+  writer->needs_comma = TRUE;
+  if (writer->depth == 0)
+    writer->complete = TRUE;
+  if (writer->sink && writer->sstream->length >= JSON_WRITER_SINK_THRESHOLD)
+    JSON_WriterFlush(writer);
+}
+
+static void WriterBeginContainer(JSON_Writer* const writer,
+                                 const bool_t is_object) {
+  if (WriterBeginValue(writer) == FALSE)
+    return;
+  if (writer->depth == JSON_WRITER_MAX_DEPTH) {
+    writer->failed = TRUE;
+    return;
+  }
+  const size_t level = writer->depth++;
+  if (is_object)
+    writer->objects[level >> 6] |= (u_int64_t)1 << (level & 0x3F);
+  else
+    writer->objects[level >> 6] &= ~((u_int64_t)1 << (level & 0x3F));
+  writer->needs_comma = FALSE;
+  WriterAppend(writer, is_object ? "{" : "[", 1);
+}
+
+static void WriterEndContainer(JSON_Writer* const writer,
+                               const bool_t is_object) {
+  if (writer->failed)
+    return;
+  const bool_t in_object =
+      writer->depth && WRITER_IS_OBJECT(writer, writer->depth - 1) ? TRUE
+                                                                    : FALSE;
+  if (writer->depth == 0 || writer->after_key || in_object != is_object) {
+    writer->failed = TRUE;
+    return;
+  }
+  --(writer->depth);
+  WriterAppend(writer, is_object ? "}" : "]", 1);
+  WriterEndValue(writer);
+}
+
+// Initializes a `JSON_Writer` that appends its output to `sstream`.
+void JSON_WriterInit(JSON_Writer* const writer, StringStream* const sstream) {
+  JSON_WriterInitSink(writer, sstream, NULL, NULL);
+}
+
+// Initializes a `JSON_Writer` that uses `sstream` as a buffer and hands its
+// content to `sink` in chunks of about `JSON_WRITER_SINK_THRESHOLD` bytes.
+//
+// `sstream` is emptied every time it is flushed to the `sink` so its capacity
+// is reused for the entire document.
+void JSON_WriterInitSink(JSON_Writer* const writer, StringStream* const sstream,
+                         JSON_WriterSink sink, void* const ctx) {
+  memset(writer, 0, sizeof(JSON_Writer));
+  writer->sstream = sstream;
+  writer->sink = sink;
+  writer->sink_ctx = ctx;
+  writer->failed = sstream == NULL ? TRUE : FALSE;
+}
+
+void JSON_WriterBeginObject(JSON_Writer* const writer) {
+  WriterBeginContainer(writer, TRUE);
+}
+
+void JSON_WriterEndObject(JSON_Writer* const writer) {
+  WriterEndContainer(writer, TRUE);
+}
+
+void JSON_WriterBeginList(JSON_Writer* const writer) {
+  WriterBeginContainer(writer, FALSE);
+}
+
+void JSON_WriterEndList(JSON_Writer* const writer) {
+  WriterEndContainer(writer, FALSE);
+}
+
+// Writes the `key` of the next member of the current object.  `key` is escaped
+// on the way.
+void JSON_WriterKey(JSON_Writer* const writer, const char* const key) {
+  JSON_WriterKeyN(writer, key, key ? strlen(key) : 0);
+}
+
+void JSON_WriterKeyN(JSON_Writer* const writer, const char* const key,
+                     const size_t length) {
+  if (writer->failed)
+    return;
+  if (key == NULL || writer->depth == 0 || writer->after_key ||
+      !WRITER_IS_OBJECT(writer, writer->depth - 1)) {
+    writer->failed = TRUE;
+    return;
+  }
+  if (writer->needs_comma)
+    WriterAppend(writer, ",", 1);
+  WriterAppendString(writer, key, length);
+  WriterAppend(writer, ":", 1);
+  writer->after_key = TRUE;
+}
+
+void JSON_WriterNull(JSON_Writer* const writer) {
+  if (WriterBeginValue(writer) == FALSE)
+    return;
+  WriterAppend(writer, JSON_NULL, sizeof(JSON_NULL) - 1);
+  WriterEndValue(writer);
+}
+
+void JSON_WriterNumber(JSON_Writer* const writer, const json_number_t number) {
+  if (WriterBeginValue(writer) == FALSE)
+    return;
+  // Digits are produced back to front into a buffer on the stack; the
+  // magnitude is taken as unsigned so that `INT64_MIN` does not overflow.
+  char buffer[24];
+  char* digit = buffer + sizeof(buffer);
+  u_int64_t magnitude =
+      number < 0 ? (u_int64_t)0 - (u_int64_t)number : (u_int64_t)number;
+  do {
+    *--digit = (char)('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude);
+  if (number < 0)
+    *--digit = '-';
+  WriterAppend(writer, digit, buffer + sizeof(buffer) - digit);
+  WriterEndValue(writer);
+}
+
+void JSON_WriterDecimal(JSON_Writer* const writer,
+                        const json_decimal_t decimal) {
+  if (WriterBeginValue(writer) == FALSE)
+    return;
+  // `JSON` has no representation for infinities and NaNs.
+  if (!isfinite(decimal)) {
+    WriterAppend(writer, JSON_NULL, sizeof(JSON_NULL) - 1);
+  } else {
+    char buffer[32];
+    const int length = snprintf(buffer, sizeof(buffer), "%.17g", decimal);
+    WriterAppend(writer, buffer, (size_t)length);
+    // Keep the value a decimal when read back, `%g` drops the fraction of
+    // integral values.
+    if (strpbrk(buffer, ".eE") == NULL)
+      WriterAppend(writer, ".0", 2);
+  }
+  WriterEndValue(writer);
+}
+
+void JSON_WriterBool(JSON_Writer* const writer, const json_bool_t boolean) {
+  if (WriterBeginValue(writer) == FALSE)
+    return;
+  if (boolean)
+    WriterAppend(writer, JSON_TRUE, sizeof(JSON_TRUE) - 1);
+  else
+    WriterAppend(writer, JSON_FALSE, sizeof(JSON_FALSE) - 1);
+  WriterEndValue(writer);
+}
+
+// Writes `string` as a `JSON` string, escaping quotes, back-slashes and control
+// characters on the way.
+void JSON_WriterString(JSON_Writer* const writer, const char* const string) {
+  JSON_WriterStringN(writer, string, string ? strlen(string) : 0);
+}
+
+void JSON_WriterStringN(JSON_Writer* const writer, const char* const string,
+                        const size_t length) {
+  if (string == NULL) {
+    JSON_WriterNull(writer);
+    return;
+  }
+  if (WriterBeginValue(writer) == FALSE)
+    return;
+  WriterAppendString(writer, string, length);
+  WriterEndValue(writer);
+}
+
+// Hands whatever is buffered in the writer's `StringStream` to its sink, has no
+// effect on a writer without a sink.
+void JSON_WriterFlush(JSON_Writer* const writer) {
+  if (writer->sink == NULL || writer->sstream == NULL ||
+      writer->sstream->length == 0)
+    return;
+  writer->sink(writer->sink_ctx, writer->sstream->data,
+               writer->sstream->length);
+  writer->sstream->length = 0;
+  _TERMINATE_STRING_STREAM_BUFFER(*writer->sstream);
+}
+
+// Flushes the writer and returns `TRUE` if exactly one complete top-level value
+// was written without misusing the writer.
+bool_t JSON_WriterFinish(JSON_Writer* const writer) {
+  JSON_WriterFlush(writer);
+  return !writer->failed && writer->complete ? TRUE : FALSE;
+}
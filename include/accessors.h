@@ -40,6 +40,25 @@
 extern "C" {
 #endif
 
+// Returns a pointer to the characters of a `JSON_String` instance.
+//
+// The characters are only guaranteed to be `NULL` terminated if the string is
+// not a view (see `JSON_FLAG_STRING_VIEW`), use `JSON_StringLength()` to know
+// how many there are.  Inline strings (see `JSON_FLAG_STRING_INLINE`) live in
+// `json` itself so the returned pointer is only valid as long as `json` is.
+const char* JSON_StringData(const JSON* const json);
+
+// Returns the number of characters in a `JSON_String` instance.
+size_t JSON_StringLength(const JSON* const json);
+
+// Returns the number of elements of a `JSON_List` instance, whether they are
+// stored by value (see `JSON_FLAG_LIST_VALUES`) or as pointers.
+size_t JSON_ListSize(const JSON* const list);
+
+// Returns the element at `index` of a `JSON_List` instance, or `NULL` if there
+// is none.
+JSON* JSON_ListGet(const JSON* const list, const size_t index);
+
 StringStream JSON_Stringify(JSON* const json, const bool_t prettify,
                             const size_t init_tab_pos,
                             const bool_t is_dict_valid);
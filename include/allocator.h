@@ -0,0 +1,152 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_ALLOCATOR_H_
+#define CJSON_INCLUDE_ALLOCATOR_H_
+
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Function signatures of the hooks an `Allocator` is made of, they follow the
+// contracts of their libc counterparts and receive the `ctx` of the
+// `Allocator` instance they belong to.
+typedef void* (*malloc_f)(void* ctx, size_t size);
+typedef void* (*realloc_f)(void* ctx, void* ptr, size_t size);
+typedef void (*free_f)(void* ctx, void* ptr);
+
+// `Allocator` is where every container and `JSON` node gets its memory from.
+//
+// `Vector`, `Map` and `StringStream` instances remember the allocator they were
+// allocated with and use it for every later re-allocation and release; `JSON`
+// nodes, their strings and object keys always come from the process-wide
+// allocator.  A `NULL` allocator always stands for the process-wide allocator.
+typedef struct Allocator {
+  malloc_f malloc;
+  realloc_f realloc;
+  free_f free;
+  void* ctx;
+} Allocator;
+
+// Returns the process-wide allocator, libc's unless `AllocatorSetDefault()`
+// replaced it.
+const Allocator* AllocatorGetDefault();
+
+// Replaces the process-wide allocator, `NULL` restores libc's.
+//
+// Memory must be released by the allocator that allocated it, so the
+// process-wide allocator must only be replaced while no container or `JSON`
+// node allocated with it is alive, typically once at start-up.  The given
+// `allocator` must outlive its use.
+void AllocatorSetDefault(const Allocator* const allocator);
+
+// Wrappers calling the hooks of `allocator`, or of the process-wide allocator
+// if `allocator` is `NULL`.
+void* AllocatorMalloc(const Allocator* const allocator, const size_t size);
+void* AllocatorCalloc(const Allocator* const allocator, const size_t count,
+                      const size_t size);
+void* AllocatorRealloc(const Allocator* const allocator, void* const ptr,
+                       const size_t size);
+void AllocatorFree(const Allocator* const allocator, void* const ptr);
+
+// Running totals of the memory served through an `Allocator` returned by
+// `AllocatorCounting()`.  Read them with `AllocatorCounterBytes()` and
+// `AllocatorCounterBlocks()`, they are updated atomically.
+typedef struct AllocatorCounter {
+  // Where the memory comes from, captured when the counting `Allocator` is
+  // created.
+  const Allocator* allocator;
+  size_t bytes;
+  size_t blocks;
+} AllocatorCounter;
+
+// Returns an `Allocator` that serves every request from `allocator`, or from
+// the process-wide allocator if `allocator` is `NULL`, while keeping `counter`
+// up to date with the bytes and blocks currently allocated through it.
+//
+// Installed with `AllocatorSetDefault()` once at start-up, before any container
+// or `JSON` node is allocated, it gives an O(1) running total of what every
+// `JSON` tree of the process holds, kept up to date by every constructor and
+// modifier.  `JSON` nodes, strings and keys always come from the process-wide
+// allocator, so the total covers the whole process and not a single document;
+// handed to a container instead, it only counts the buffers of that container.
+// Every block carries a small size prefix and the thread-local caches are
+// bypassed, so it costs a little more than the allocator it wraps and its
+// blocks must never be released once another allocator replaced it.
+// `counter` must outlive the `Allocator`.
+Allocator AllocatorCounting(AllocatorCounter* const counter,
+                            const Allocator* const allocator);
+
+// Returns the number of bytes currently allocated through `counter`.
+size_t AllocatorCounterBytes(const AllocatorCounter* const counter);
+
+// Returns the number of blocks currently allocated through `counter`.
+size_t AllocatorCounterBlocks(const AllocatorCounter* const counter);
+
+// Blocks of up to this many bytes released with `AllocatorCacheFree()` are
+// kept for reuse instead of being handed back to libc.
+#define ALLOCATOR_CACHE_MAX_BLOCK_SIZE (1 << 8)
+
+// Upper bound of the bytes kept by the cache of a single thread.
+#define ALLOCATOR_CACHE_MAX_BYTES (1 << 18)
+
+// Thread-local caches of small released blocks, one free-list per multiple of
+// eight bytes up to `ALLOCATOR_CACHE_MAX_BLOCK_SIZE`.
+//
+// `JSON` nodes, `MapEntry` nodes, bucket arrays and `Vector` buffers are
+// allocated and released through these so that building and dropping many
+// small trees recycles their memory within the thread instead of going
+// through libc's locks each time.  Only libc's allocator is cached: when
+// `allocator` (or the process-wide allocator for `NULL`) is any other one the
+// calls go straight to it, so custom allocators keep seeing every call.
+//
+// `AllocatorCacheFree()` must be given a `size` no larger than the block was
+// allocated with; blocks from either function can also be released with
+// `AllocatorFree()` or re-allocated with `AllocatorRealloc()`.  A thread's
+// cache is released to libc when the thread exits.
+void* AllocatorCacheMalloc(const Allocator* const allocator,
+                           const size_t size);
+void* AllocatorCacheCalloc(const Allocator* const allocator, const size_t count,
+                           const size_t size);
+void AllocatorCacheFree(const Allocator* const allocator, void* const ptr,
+                        const size_t size);
+
+// Releases every block cached by the calling thread to libc.
+void AllocatorCacheFlush();
+
+// Returns the number of bytes cached by the calling thread.
+size_t AllocatorCacheSize();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_ALLOCATOR_H_
@@ -0,0 +1,75 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_CBOR_H_
+#define CJSON_INCLUDE_CBOR_H_
+
+#include "bool.h"
+#include "cjson.h"
+#include "data/sstream/sstream.h"
+
+// Deepest nesting of lists and objects `JSON_FromCBOR()` accepts, protects the
+// decoder from exhausting the stack on hostile input.
+#define JSON_CBOR_MAX_DEPTH 512
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Appends the CBOR (RFC 8949) encoding of `json` onto `cbor`.
+//
+// `JSON_type`s map onto the CBOR major types as follows:
+//
+//      JSON_Null     simple value 22 (null)
+//      JSON_Boolean  simple values 20 (false) and 21 (true)
+//      JSON_Number   major type 0 or 1 in the smallest width that fits
+//      JSON_Decimal  single precision float if lossless, double otherwise
+//      JSON_String   major type 3, text string
+//      JSON_List     major type 4 with a definite length of `Vector.size`
+//      JSON_Object   major type 5 with a definite length of `Map.entrieslen`
+//
+// Returns `FALSE` if an argument is `NULL` or if `cbor` could not grow to hold
+// the encoding, in which case it holds a truncated prefix of it.
+bool_t JSON_ToCBOR(StringStream* const cbor, const JSON* const json);
+
+// Decodes the single CBOR data item held in `cbor` into `json`.
+//
+// Returns `TRUE` on success in which case the decoded tree lives in the
+// free-store and must be released with `JSON_FreeDeep()`.  Returns `FALSE` and
+// leaves a `JSON_Null` in `json` if `cbor` is not well-formed, holds trailing
+// bytes, or uses something that has no `JSON` counterpart such as byte
+// strings, indefinite lengths, non-string or duplicate object keys.  Tags are
+// skipped and `undefined` is decoded as `null`.
+bool_t JSON_FromCBOR(JSON* const json, const StringStream* const cbor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_CBOR_H_
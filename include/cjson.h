@@ -71,6 +71,54 @@ typedef enum JSON_type {
   // clang-format on
 } JSON_type;
 
+// A string that is not owned by the `JSON` instance holding it, e.g. one that
+// points straight into the buffer a document was decoded from.  The bytes are
+// not `NULL` terminated so the `length` must always be respected.
+typedef struct json_strview_t {
+  json_string_t data;
+  size_t length;
+} json_strview_t;
+
+// The elements of a list stored by value in one contiguous array, so walking
+// the list walks memory linearly instead of chasing a pointer per element.
+// Grows like a `Vector`, which moves the elements: pointers to them are only
+// valid until the next element is added.
+typedef struct json_values_t {
+  struct JSON* data;
+  size_t size;
+  size_t capacity;
+} json_values_t;
+
+// clang-format off
+// Flags describing how the `JSON_value` of a `JSON` instance is stored.
+//
+// `JSON_FLAG_STRING_VIEW`: `json.value.view` holds a `json_strview_t` instead
+// of an owned `NULL` terminated string in `json.value.string`.  Views are
+// never freed by `JSON_Free()` or `JSON_FreeDeep()`.
+//
+// `JSON_FLAG_STRING_INLINE`: `json.value.shortstr` holds the `NULL` terminated
+// characters of a string no longer than `JSON_SHORT_STRING_CAPACITY` and
+// `json.length` its length, nothing is allocated in the free-store for it.
+//
+// `JSON_FLAG_LIST_VALUES`: `json.value.values` holds the elements of a list by
+// value (see `json_values_t`) instead of `json.value.list` holding pointers to
+// them.  Use `JSON_ListSize()` and `JSON_ListGet()` to read lists that might
+// be stored either way.
+//
+// `JSON_FLAG_SHARED`: the instance is the root of a reference-counted tree (see
+// `JSON_Ref`), freeing it drops a reference instead of freeing the tree.
+#define JSON_FLAG_STRING_VIEW    (1 << 0)
+#define JSON_FLAG_STRING_INLINE  (1 << 1)
+#define JSON_FLAG_LIST_VALUES    (1 << 2)
+#define JSON_FLAG_SHARED         (1 << 3)
+// clang-format on
+
+// Strings up to this many characters are stored inline in the `JSON` instance
+// instead of the free-store, see `JSON_FLAG_STRING_INLINE`.  The characters
+// plus the `NULL` terminator take as much room as a `json_strview_t` so the
+// `JSON_value` union does not grow.
+#define JSON_SHORT_STRING_CAPACITY (sizeof(json_strview_t) - 1)
+
 // `JSON_value` union stores `JSON` style values.  `union` is preferred over a
 // `struct` to save memory.  Only one the value at a time can be stored while
 // the others will be currupted.
@@ -78,7 +126,8 @@ typedef union JSON_value {
   // clang-format off
   json_null_t null; json_bool_t boolean; json_string_t string;
   json_number_t number; json_decimal_t decimal; json_list_t list;
-  json_object_t object;
+  json_object_t object; json_strview_t view; json_values_t values;
+  char shortstr[JSON_SHORT_STRING_CAPACITY + 1];
   // clang-format on
 } JSON_value;
 
@@ -91,6 +140,12 @@ typedef union JSON_value {
 // read and write operations over a single value at a time.
 typedef struct JSON {
   JSON_type type;
+  // Bit-set of `JSON_FLAG_*` values.  Lives in what would otherwise be the
+  // padding between `type` and `value`.
+  u_int8_t flags;
+  // Length of an inline string (see `JSON_FLAG_STRING_INLINE`), also living in
+  // the padding.
+  u_int8_t length;
   JSON_value value;
 } JSON;
 
@@ -122,11 +177,24 @@ JSON JSON_InitNullImpl();
 
 // Creates a `JSON` instance from a `json_string_t` type.
 //
-// Allocates free-store memory to store the comming `string` instance. Assigns
-// `NULL` to the `json.value.string` instance if dynamic-memory allocation
-// failed.
+// Strings no longer than `JSON_SHORT_STRING_CAPACITY` are copied inline into
+// the `JSON` instance, longer ones into the free-store.  Assigns `NULL` to the
+// `json.value.string` instance if dynamic-memory allocation failed.  Use
+// `JSON_StringData()` and `JSON_StringLength()` to read the string back.
 JSON JSON_InitStringImpl(const json_string_t string);
 
+// Same as `JSON_InitStringImpl()` but copies exactly `length` bytes of
+// `string`, which does not need to be `NULL` terminated.
+JSON JSON_InitStringNImpl(const json_string_t string, const size_t length);
+
+// Creates a `JSON` instance viewing `length` bytes of `string` without copying
+// them.
+//
+// The returned `JSON` instance does not own `string`, which must outlive it and
+// does not need to be `NULL` terminated.  Use `JSON_StringData()` and
+// `JSON_StringLength()` to read strings that might be views.
+JSON JSON_InitStringViewImpl(const json_string_t string, const size_t length);
+
 // Creates a `JSON` instance from a `json_number_t` type.
 //
 // The given number is copied to the `json.value.number` instance of the
@@ -166,6 +234,14 @@ JSON JSON_InitBoolImpl(const json_bool_t boolean);
 // dynamically allocated data.
 JSON JSON_InitListImpl(json_list_t* list);
 
+// Returns an empty `JSON_List` instance storing its elements by value (see
+// `JSON_FLAG_LIST_VALUES`) with room for `capacity` elements before it grows.
+//
+// Elements added with `JSON_ListAdd()` are moved into the list and their
+// free-store container released, `JSON_ListAppend()` copies them without any
+// allocation of its own.
+JSON JSON_InitValueListImpl(const size_t capacity);
+
 // Creates a `JSON` instance from a `json_object_t*` pointer type.
 //
 // Saves a `json_object_t*` value by going over the `buckets` attribute of
@@ -183,7 +259,18 @@ JSON JSON_InitObjectImpl(json_object_t* object);
 JSON* JSON_AllocType(JSON_type type);
 JSON* JSON_AllocTypeSize(JSON_type type, size_t size);
 
+// Releases what `json` holds and what its children hold, but not the child
+// nodes themselves nor the object keys.
+//
+// The tree is walked with an explicit work stack, so its depth is bounded by
+// the free-store rather than by the call stack.
 void JSON_Free(JSON* const json);
+
+// Releases what `json` holds along with every child node and object key below
+// it, the node `json` itself is left to the caller.
+//
+// The tree is walked with an explicit work stack, so its depth is bounded by
+// the free-store rather than by the call stack.
 void JSON_FreeDeep(JSON* const json);
 
 #define JSON_INIT(type) JSON_Init##type##Impl()
@@ -194,6 +281,8 @@ void JSON_FreeDeep(JSON* const json);
 #endif
 
 #include "accessors.h"
+#include "format.h"
 #include "modifiers.h"
+#include "writer.h"
 
 #endif  // CJSON_INCLUDE_CJSON_H_
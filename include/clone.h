@@ -0,0 +1,63 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_CLONE_H_
+#define CJSON_INCLUDE_CLONE_H_
+
+#include <sys/types.h>
+
+#include "cjson.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returns a deep copy of the tree under `json` whose nodes, map entries,
+// bucket arrays, list buffers and strings all live in a single free-store
+// block, or `NULL` if the free-store is exhausted.
+//
+// The tree is measured first so that the block is allocated once and every map
+// is built with the buckets its final size needs.  Shared trees (see
+// `JSON_Ref`) and string views are copied too, the clone depends on nothing
+// but its own block.
+//
+// Like the nodes of a `JSON_Document`, the nodes of a clone can be read with
+// every accessor but must never be modified or passed to `JSON_Free()` or
+// `JSON_FreeDeep()`; the whole clone is released at once by
+// `JSON_CloneFree()`.
+JSON* JSON_Clone(const JSON* const json);
+
+// Releases a clone returned by `JSON_Clone()`.
+void JSON_CloneFree(JSON* const clone);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_CLONE_H_
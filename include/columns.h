@@ -0,0 +1,114 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_COLUMNS_H_
+#define CJSON_INCLUDE_COLUMNS_H_
+
+#include <sys/types.h>
+
+#include "bool.h"
+#include "cjson.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A single key of a list of objects stored as one contiguous, typed array.
+//
+// `type` is the `JSON_type` shared by every non-null value of the key and picks
+// the member of `values` holding them, a column whose values are all null has
+// the type `JSON_Null` and holds no values.  Row `i` of the column is null if
+// bit `i % 8` of `nulls[i / 8]` is set, in which case `values` holds a zero at
+// that row.  `absent` marks the subset of null rows whose object did not have
+// the key at all.
+//
+// The characters of row `i` of a `JSON_String` column are the
+// `offsets[i + 1] - offsets[i]` bytes at `chars + offsets[i]`, they are not
+// `NULL` terminated.
+//
+// `key` is a `NULL` terminated copy of the `keylen` bytes of the key, which may
+// hold `NULL` characters of their own.
+typedef struct JSON_Column {
+  char* key;
+  size_t keylen;
+  JSON_type type;
+  u_int8_t* nulls;
+  u_int8_t* absent;
+  union {
+    json_number_t* numbers;
+    json_decimal_t* decimals;
+    u_int8_t* booleans;
+    struct {
+      u_int64_t* offsets;
+      char* chars;
+    } strings;
+  } values;
+} JSON_Column;
+
+// Struct-of-arrays form of a `JSON_List` of `JSON_Object`s, one `JSON_Column`
+// per distinct key in the order the keys were first seen.
+typedef struct JSON_Columns {
+  size_t rows;
+  size_t ncolumns;
+  JSON_Column* columns;
+} JSON_Columns;
+
+// Shreds the `JSON_Object`s of `list` into `columns`.
+//
+// `JSON_Number` and `JSON_Decimal` values of the same key are widened into a
+// `JSON_Decimal` column.  Returns `FALSE` and leaves `columns` empty if `list`
+// is not a list of objects, if a key holds a list, an object or otherwise
+// mixed types, or if the free-store is exhausted.  Release `columns` with
+// `JSON_ColumnsFree()`.
+bool_t JSON_ColumnsFromList(JSON_Columns* const columns,
+                            const JSON* const list);
+
+// Rebuilds the `JSON_List` of `JSON_Object`s shredded into `columns`.
+//
+// Absent rows are left out of their objects while the other null rows become
+// `JSON_Null` values.  The list lives in the free-store and must be released
+// with `JSON_FreeDeep()`.  Returns `FALSE` and leaves a `JSON_Null` in `list`
+// if the free-store is exhausted.
+bool_t JSON_ColumnsToList(JSON* const list, const JSON_Columns* const columns);
+
+// Returns the column of `key`, or `NULL` if none of the objects had `key`.
+const JSON_Column* JSON_ColumnsFind(const JSON_Columns* const columns,
+                                    const char* const key);
+
+// Returns `TRUE` if `row` of `column` is null or absent.
+bool_t JSON_ColumnIsNull(const JSON_Column* const column, const size_t row);
+
+// Releases every column of `columns`.
+void JSON_ColumnsFree(JSON_Columns* const columns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_COLUMNS_H_
@@ -0,0 +1,69 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_COMPACT_H_
+#define CJSON_INCLUDE_COMPACT_H_
+
+#include <sys/types.h>
+
+#include "cjson.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Trims the tree under `json` to the memory its current contents need: list
+// buffers lose their growth slack and objects their surplus buckets, e.g. the
+// ones left behind by removals.
+//
+// Shared trees attached below `json` (see `JSON_Ref`) are immutable and left
+// as they are.  Trimming is best-effort, a buffer that cannot be re-allocated
+// is kept.  The tree stays mutable; the next insertion grows it again.
+void JSON_Compact(JSON* const json);
+
+// Relocates the tree under `json` into a single contiguous block and returns
+// it, or returns `NULL` and leaves `json` untouched if the free-store is
+// exhausted.
+//
+// The nodes are laid out in depth-first order, the elements of a list or the
+// values of an object next to each other and followed by their own subtrees,
+// so a traversal walks the block forward.  Shared trees are copied in.
+//
+// On success the memory held by `json` is released and `json` is left as a
+// `JSON_Null` instance, the node itself stays with the caller.  The returned
+// tree is a clone (see `JSON_Clone()`): it can be read with every accessor but
+// never modified, and is released with `JSON_CloneFree()`.  This suits
+// long-lived documents that are read far more often than they are built.
+JSON* JSON_CompactRelocate(JSON* const json);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_COMPACT_H_
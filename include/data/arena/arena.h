@@ -0,0 +1,108 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_DATA_ARENA_ARENA_H_
+#define CJSON_INCLUDE_DATA_ARENA_ARENA_H_
+
+#include <sys/types.h>
+
+#include "allocator.h"
+
+#define ARENA_DEFAULT_BLOCK_SIZE (1 << 16)
+// Every allocation is aligned to `ARENA_ALIGNMENT` bytes which suits any
+// scalar type.
+#define ARENA_ALIGNMENT (1 << 4)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A block of free-store memory allocations are bumped out of.  The usable bytes
+// directly follow the header.
+typedef struct ArenaBlock {
+  struct ArenaBlock* next;
+  size_t size;
+  size_t used;
+} ArenaBlock;
+
+// `Arena` is a bump allocator, allocations are carved out of large blocks and
+// are never freed individually; instead every block is freed at once by
+// `ArenaFree()`.
+//
+// +~~~~~~~~~~~~~~~~+     +~~~~~~~~~~~~~~~~+
+// !     blocks ~~~~+~~~> !      next  ~~~~+~~> ... ~~> NULL
+// !     blocksize  !     !      size      !
+// !     allocator  !     !      used      !
+// +~~~~~~~~~~~~~~~~+     +~~~~~~~~~~~~~~~~+
+//                        !  allocations   !
+//                        +~~~~~~~~~~~~~~~~+
+typedef struct Arena {
+  ArenaBlock* blocks;
+  size_t blocksize;
+
+  // Where the blocks come from, captured when the `Arena` is created.
+  const Allocator* allocator;
+} Arena;
+
+// Returns an `Arena` instance that allocates blocks of
+// `ARENA_DEFAULT_BLOCK_SIZE` bytes.  No block is allocated until the first
+// allocation.
+Arena ArenaAlloc();
+
+// Returns an `Arena` instance that allocates blocks of `blocksize` bytes.
+Arena ArenaNAlloc(const size_t blocksize);
+
+// Returns `size` bytes aligned to `ARENA_ALIGNMENT` that live until the
+// `arena` is freed, or `NULL` if the free-store is exhausted.
+//
+// Allocations larger than a quarter of the block size get a block of their
+// own so they never waste the rest of the current block.
+void* ArenaMalloc(Arena* const arena, const size_t size);
+
+// Same as `ArenaMalloc()` but the returned bytes are zeroed.
+void* ArenaCalloc(Arena* const arena, const size_t size);
+
+// Frees every block of the `arena` and with them every allocation made from
+// it.  The `arena` can be reused afterwards.
+void ArenaFree(Arena* const arena);
+
+// Returns an `Allocator` that serves every request out of the given `arena`,
+// so that containers created with it are released all at once by
+// `ArenaFree()`.
+//
+// Freeing through the returned `Allocator` is a no-op and growing an
+// allocation copies it to a new one; the `arena` must outlive every container
+// using the returned `Allocator`.
+Allocator ArenaAllocator(Arena* const arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_DATA_ARENA_ARENA_H_
@@ -0,0 +1,168 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_DATA_MAP_GROUP_H_
+#define CJSON_INCLUDE_DATA_MAP_GROUP_H_
+
+#include <sys/types.h>
+
+#include "bool.h"
+#include "data/map/map.h"
+#include "internal/arch.h"
+
+#ifdef CJSON_ARCH_SSE2
+#include <emmintrin.h>
+#endif
+
+// Returns whether a block of `bucketslen` buckets is a small one, see `Map`.
+static inline bool_t MapIsSmall(const size_t bucketslen) {
+  return bucketslen < MAP_GROUP_WIDTH;
+}
+
+// Returns the number of entries a block of `bucketslen` buckets has room for,
+// `MAX_LOAD_FACTOR` of its buckets or every one of a small block.
+static inline size_t MapEntriesCapacity(const size_t bucketslen) {
+  return MapIsSmall(bucketslen) ? bucketslen : bucketslen - bucketslen / 4;
+}
+
+// Returns the number of control bytes of a block of `bucketslen` buckets, a
+// whole group even for a small block so that it is matched at once.
+static inline size_t MapCtrlLen(const size_t bucketslen) {
+  return MapIsSmall(bucketslen) ? MAP_GROUP_WIDTH : bucketslen;
+}
+
+// Returns the width in bytes of the indices into the entries of a block of
+// `bucketslen` buckets, the smallest one holding every index.  Small blocks
+// have none, their control bytes are those of the entries themselves.
+static inline size_t MapIndexWidth(const size_t bucketslen) {
+  if (MapIsSmall(bucketslen))
+    return 0;
+  if (bucketslen <= 0x100)
+    return sizeof(u_int8_t);
+  if (bucketslen <= 0x10000)
+    return sizeof(u_int16_t);
+  if (bucketslen <= 0x100000000ULL)
+    return sizeof(u_int32_t);
+  return sizeof(u_int64_t);
+}
+
+// Returns the control bytes of the buckets of `map`, stored right after its
+// entries.
+static inline u_int8_t* MapCtrl(const Map* const map) {
+  return (u_int8_t*)(map->buckets + MapEntriesCapacity(map->bucketslen));
+}
+
+// Returns the index of the entry held by the bucket `idx` of `map`, which must
+// be full.  The indices are stored right after the control bytes.
+static inline size_t MapIndexGet(const Map* const map, const size_t idx) {
+  const u_int8_t* const index = MapCtrl(map) + map->bucketslen;
+  switch (MapIndexWidth(map->bucketslen)) {
+    case 0:
+      return idx;
+    case sizeof(u_int8_t):
+      return index[idx];
+    case sizeof(u_int16_t):
+      return ((const u_int16_t*)index)[idx];
+    case sizeof(u_int32_t):
+      return ((const u_int32_t*)index)[idx];
+    default:
+      return (size_t)((const u_int64_t*)index)[idx];
+  }
+}
+
+// Makes the bucket `idx` of `map` hold the entry of the given `entry` index.
+static inline void MapIndexSet(const Map* const map, const size_t idx,
+                               const size_t entry) {
+  u_int8_t* const index = MapCtrl(map) + map->bucketslen;
+  switch (MapIndexWidth(map->bucketslen)) {
+    case 0:
+      break;
+    case sizeof(u_int8_t):
+      index[idx] = (u_int8_t)entry;
+      break;
+    case sizeof(u_int16_t):
+      ((u_int16_t*)index)[idx] = (u_int16_t)entry;
+      break;
+    case sizeof(u_int32_t):
+      ((u_int32_t*)index)[idx] = (u_int32_t)entry;
+      break;
+    default:
+      ((u_int64_t*)index)[idx] = (u_int64_t)entry;
+      break;
+  }
+}
+
+// Returns the count of the entries of `map` used so far, removed ones
+// included, stored right after the indices.  New entries are appended there.
+static inline size_t* MapEntriesUsed(const Map* const map) {
+  return (size_t*)(MapCtrl(map) + MapCtrlLen(map->bucketslen) +
+                   map->bucketslen * MapIndexWidth(map->bucketslen));
+}
+
+// Returns the pending migration of `map`, stored right after the count of used
+// entries, or `NULL` if there is none.
+static inline MapMigration** MapMigrationOf(const Map* const map) {
+  return (MapMigration**)(MapEntriesUsed(map) + 1);
+}
+
+// Returns whether the entry `mapentry` was removed and is only left as a hole
+// in the order of the entries.
+static inline bool_t MapEntryRemoved(const MapEntry* const mapentry) {
+  return mapentry->keylen == MAP_ENTRY_REMOVED;
+}
+
+// Returns the control byte of a bucket holding an entry of the given `hash`.
+//
+// The seven bits of the tag are the high bits of the hash multiplied by a
+// large odd constant, so even hash functions leaving their high bits unused
+// spread their entries over every tag.
+static inline u_int8_t MapCtrlTag(const hash_t hash) {
+  const u_int64_t mixed = (u_int64_t)hash * 0x9E3779B97F4A7C15ULL;
+  return (u_int8_t)(MAP_CTRL_FULL | (u_int8_t)(mixed >> 57));
+}
+
+// Returns a mask with bit `i` set for each of the `MAP_GROUP_WIDTH` control
+// bytes at `ctrl` that equals `byte`.
+//
+// On targets with `SSE2` the whole group is compared at once.
+static inline u_int32_t MapGroupMatch(const u_int8_t* const ctrl,
+                                      const u_int8_t byte) {
+#ifdef CJSON_ARCH_SSE2
+  const __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+  return (u_int32_t)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(group, _mm_set1_epi8((char)byte)));
+#else
+  u_int32_t mask = 0;
+  for (u_int32_t i = 0; i < MAP_GROUP_WIDTH; ++i)
+    mask |= (u_int32_t)(ctrl[i] == byte) << i;
+  return mask;
+#endif
+}
+
+#endif  // CJSON_INCLUDE_DATA_MAP_GROUP_H_
@@ -0,0 +1,100 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CJSON_INCLUDE_DATA_MAP_INTERN_H_
+#define CJSON_INCLUDE_DATA_MAP_INTERN_H_
+
+#include <sys/types.h>
+
+#include "data/arena/arena.h"
+#include "data/map/map.h"
+
+#define KEYPOOL_DEFAULT_CAPACITY (1 << 6)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Header stored right in front of the characters of every interned key, so
+// that the hash and the length of a key can be read back from the canonical
+// pointer alone.
+typedef struct KeyPoolKey {
+  hash_t hash;
+  size_t length;
+} KeyPoolKey;
+
+// `KeyPool` interns keys: equal strings map to one canonical, `NULL`
+// terminated copy that carries its precomputed `Hash()` and length.
+//
+// Repeated keys, e.g. the same field names in every record of a large list,
+// take the memory of a single copy, and maps holding only canonical keys
+// compare them by pointer (see `KeyCmp()`) and can skip hashing and measuring
+// them with `MapPutNWithHash()` and `MapGetNWithHash()`, given
+// `KeyPoolKeyHash()` and `KeyPoolKeyLength()`.
+//
+// Keys are bump-allocated out of the pool's own `Arena` and live until
+// `KeyPoolFree()`; the open-addressed table of canonical pointers comes from
+// the process-wide allocator.
+typedef struct KeyPool {
+  Arena arena;
+  const char** slots;
+  size_t capacity;
+  size_t length;
+} KeyPool;
+
+// Returns an empty `KeyPool` instance, nothing is allocated until the first key
+// is interned.
+KeyPool KeyPoolAlloc();
+
+// Returns the canonical copy of the `NULL` terminated `key`, interning it first
+// if it is not in the `pool` yet, or `NULL` if the free-store is exhausted.
+const char* KeyPoolIntern(KeyPool* const pool, const char* const key);
+
+// Same as `KeyPoolIntern()` but interns the `length` bytes at `key`, which do
+// not need to be `NULL` terminated.
+const char* KeyPoolInternN(KeyPool* const pool, const char* const key,
+                           const size_t length);
+
+// Returns the canonical copy of `key` if it is interned in the `pool`, `NULL`
+// otherwise.  Never allocates.
+const char* KeyPoolFind(const KeyPool* const pool, const char* const key);
+
+// Return the precomputed `Hash()` and length of a key returned by the
+// functions above.  Calling them with any other pointer is undefined.
+hash_t KeyPoolKeyHash(const char* const key);
+size_t KeyPoolKeyLength(const char* const key);
+
+// Releases every interned key and the table of the `pool`, which can be
+// reused afterwards.
+void KeyPoolFree(KeyPool* const pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_DATA_MAP_INTERN_H_
@@ -70,12 +70,16 @@ void MapTraverseWithMapInstance(Map *const map,
 
 typedef struct MapIterator {
   Map *map;
-  size_t cur_bucket_idx;
-  MapEntry *cur_entry;
+  // The next entry to look at.
+  size_t cur_entry_idx;
 } MapIterator;
 
+// Returns an iterator over the entries of the `Map` instance, in the order of
+// their insertion.
 MapIterator MapIteratorNew(Map *const map);
 
+// Returns the next entry of the iterator, or `NULL` once every entry was
+// returned.  The `Map` instance must not be modified meanwhile.
 MapEntry *MapIteratorNext(MapIterator *const it);
 
 #ifdef __cplusplus
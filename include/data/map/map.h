@@ -32,6 +32,7 @@
 
 #include <sys/types.h>
 
+#include "allocator.h"
 #include "bool.h"
 
 // We are pretty much doing everything in constant time if we don't have a load
@@ -41,7 +42,7 @@
 //      LoadFactor = ~~~~~~~~~~~~~~    <= 1 for O(1)
 //                      #Buckets
 #define MAX_LOAD_FACTOR 0.75f
-#define MAP_DEFAULT_BUCKET_LEN (1 << 4)
+#define MAP_DEFAULT_BUCKET_LEN (1 << 2)
 
 #ifdef __cplusplus
 extern "C" {
@@ -66,43 +67,138 @@ typedef hash_t (*hash_f)(const void* key);
 // pair inside the `Map`.
 typedef bool_t (*keycmp_f)(const void* key1, const void* key2);
 
-// Creates a Map entry inside of a bucket.  This map entry is later extended in
-// case the `LoadFactor` exceeds by `1` due to collision.
+// The number of control bytes, and thus of buckets, probed at once.  Bucket
+// arrays always hold a multiple of it, but for those of small maps.
+#define MAP_GROUP_WIDTH 16
+
+// Control bytes, one per bucket, tell whether a bucket is free and, if not,
+// carry seven bits of the hash of its key.  Zeroed memory is a valid table of
+// empty buckets.
+//
+//   MAP_CTRL_EMPTY     never used, a probe for a key stops at a group holding
+//                      one.
+//   MAP_CTRL_DELETED   emptied by a removal in a group a probe had to pass
+//                      through, it can be reused but does not stop a probe.
+//   MAP_CTRL_FULL | h  holds an entry whose hash has the tag `h`.
+#define MAP_CTRL_EMPTY 0x00
+#define MAP_CTRL_DELETED 0x01
+#define MAP_CTRL_FULL 0x80
+
+// The `keylen` of an entry taken out by a removal, left as a hole in the order
+// of the entries until the `Map` instance is resized.
+#define MAP_ENTRY_REMOVED ((size_t)-1)
+
+// The number of entries moved out of the previous buckets of a growing `Map`
+// instance by every insertion, see `MapMigrate()`.
+#define MAP_MIGRATE_STEP 64
+
+// A key-value pair stored inline in the entries of a `Map` instance, along
+// with the hash of the key so that the `Map` can be resized without hashing
+// the keys again.
+//
+// Maps comparing their keys with `KeyCmp()` also store the length of every key
+// in `keylen`, keys then are the `keylen` bytes at `key` and may hold `NULL`
+// characters.  Probes compare the lengths first and the bytes with `memcmp()`,
+// never calling `strlen()` nor `strcmp()`.  Other maps leave it `0`.
+//
+// Entries are moved when the `Map` instance is resized, a pointer to one stays
+// valid only until the next insertion.
 typedef struct MapEntry {
   void* key;
   void* value;
   hash_t hash;
-  // Pointer to the entires inside a bucket to combat collisions.
-  //
-  // +~~~~~~~~~~~~~~~~+  +~> +~~~~~~~~~~~~~~~~+
-  // !      key       !  !   !      key       !
-  // !      value     !  !   !      value     !
-  // !      hash      !  !   !      hash      !
-  // +~~~~~~~~~~~~~~~~+  !   +~~~~~~~~~~~~~~~~+
-  // !      next  ~~~~+~~+   !      next  ~~~~+~~> NULL
-  // +~~~~~~~~~~~~~~~~+      +~~~~~~~~~~~~~~~~+
-  struct MapEntry* next;
+  size_t keylen;
 } MapEntry;
 
 // Creates a `MapEntry` instance with the given key-value pairs and a hash.
 //
 // Allocates a `MapEntry` instance in the free-store and fills that memory
-// with the given values.  Remember to free the returned `MapEntry` instance
-// when not needed.
+// with the given values, its `keylen` is left `0`.  Remember to free the
+// returned `MapEntry` instance when not needed.
 MapEntry* MapAllocEntryWithHash(void* key, void* value, const hash_t hash);
 
+// An insertion-ordered hash table, a dense array of entries indexed by an
+// open-addressing table in the style of a Swiss table.
+//
+// The `buckets` point to a free-store block holding, in order, room for
+// `MAX_LOAD_FACTOR` times `bucketslen` entries, `bucketslen` control bytes,
+// `bucketslen` indices into the entries, the count of entries used so far and
+// the `MapMigration` of a `Map` instance still growing, if any (see
+// `MapBucketsSize()`).  The indices take one, two, four or eight bytes,
+// the fewest fitting every index.
+//
+// New entries are appended to the entries, which therefore keep the order of
+// insertion and are iterated with a linear scan.  A removal leaves a hole
+// behind, skipped by iterators and dropped the next time the `Map` instance is
+// resized.
+//
+// A key hashes to a group of `MAP_GROUP_WIDTH` buckets whose control bytes are
+// compared with the tag of its hash at once, only the entries of the buckets
+// whose tag matches are looked at.  Full groups send the probe on to the next
+// group in a triangular sequence.
+//
+// Maps of fewer than `MAP_GROUP_WIDTH` buckets, e.g. the default ones of a
+// fresh map, are small: their entries fill every bucket and have no indices,
+// each control byte belongs to the entry of the same place.  Their control
+// bytes are padded to a single group with empty ones, a lookup then compares
+// the tag of its hash with every entry at once.  A small map becomes a hash
+// table the first time it grows past `MAP_GROUP_WIDTH / 2` entries.
+//
+// Once every entry is used `MapPut()` allocates larger buckets but leaves the
+// entries in the previous ones, moving `MAP_MIGRATE_STEP` of them with every
+// insertion until none is left, so that no insertion has to move them all.
+// Lookups and removals meanwhile look at both.
+//
+//  buckets ~~> +~~~~~~~~~+~~~~~~~~~+     +~~~~~~~~~+
+//              ! entry 0 ! entry 1 ! ... ! entry m !
+//              +~~~~~~~~~+~~~~~~~~~+     +~~~~~~~~~+
+//              ! ctrl 0  ! ctrl 1  ! ... ! ctrl n  !
+//              +~~~~~~~~~+~~~~~~~~~+     +~~~~~~~~~+
+//              ! index 0 ! index 1 ! ... ! index n !  used  ! migration !
+//              +~~~~~~~~~+~~~~~~~~~+     +~~~~~~~~~+~~~~~~~~+~~~~~~~~~~~+
 typedef struct Map {
   hash_f hash;
   keycmp_f keycmp;
 
-  // Each bucket is an element of a singly linked list so we want to have access
-  // to its head.
-  MapEntry** buckets;
+  MapEntry* buckets;
 
   size_t bucketslen;
   size_t entrieslen;
+
+  // Where the buckets come from.
+  const Allocator* allocator;
 } Map;
 
+// Returns the size in bytes of the free-store block holding the entries, the
+// control bytes and the indices of `bucketslen` buckets, the count of used
+// entries and the pending migration.
+//
+// `bucketslen` must be a power of two no smaller than `MAP_DEFAULT_BUCKET_LEN`.
+// A zeroed block of that size is a table of empty buckets, ready to be handed
+// to `MapRehash()`.
+size_t MapBucketsSize(const size_t bucketslen);
+
+// The state of a `Map` instance growing incrementally: its previous buckets,
+// whose entries are moved a few at a time into the current ones.
+//
+// The current entries keep `reserved` places, as many as the `Map` instance
+// held when it started growing, for the entries of the previous buckets, which
+// are moved there in order.  Entries inserted meanwhile go after them.  The
+// places left unused by removals become holes once every entry was moved.
+typedef struct MapMigration {
+  MapEntry* buckets;
+  size_t bucketslen;
+  // The next entry of `buckets` to move.
+  size_t next;
+  // The number of entries moved so far, and where the next one goes.
+  size_t moved;
+  size_t reserved;
+} MapMigration;
+
+// Returns the size in bytes of the free-store held by the buckets of `map`,
+// those of a pending migration included.
+size_t MapAllocatedSize(const Map* const map);
+
 // Allocates a `Map` instance of a default bucket length of
 // `MAP_DEFAULT_BUCKET_LEN` provided the `hash` function to generate a hash and
 // a `keycmp` function to compare two distinct keys inside a `Map` instance is
@@ -116,7 +212,8 @@ Map MapAlloc(hash_f hash, keycmp_f keycmp);
 
 // Allocates a `Map` instance of the given `bucketslen` provided the `hash`
 // function to generate a hash and a `keycmp` function to compare two distinct
-// keys inside a `Map` instance.
+// keys inside a `Map` instance.  The `bucketslen` is rounded up to a power of
+// two no smaller than `MAP_DEFAULT_BUCKET_LEN`.
 //
 // While allocating a `Map` instance you can also use the built-in hash
 // generator function `Hash()` to generate a hash value from a `key` regardless
@@ -124,6 +221,16 @@ Map MapAlloc(hash_f hash, keycmp_f keycmp);
 // compare two distinct keys.
 Map MapAllocNBuckets(size_t bucketslen, hash_f hash, keycmp_f keycmp);
 
+// Allocates a `Map` instance of the given `bucketslen` whose buckets come from
+// the given `allocator`, or from the process-wide allocator if `allocator` is
+// `NULL`.
+//
+// The `Map` instance keeps using `allocator` for every re-allocation and for
+// releasing its buckets and, with `MapFreeDeep()`, their `key-value` pairs.
+Map MapAllocNBucketsWithAllocator(size_t bucketslen, hash_f hash,
+                                  keycmp_f keycmp,
+                                  const Allocator* const allocator);
+
 // Allocates a `Map` instance when the number of entries that are going to be in
 // our bucket is given.
 //
@@ -138,25 +245,50 @@ Map MapAllocNBuckets(size_t bucketslen, hash_f hash, keycmp_f keycmp);
 // compare two distinct keys.
 Map MapAllocNEntries(const size_t entrieslen, hash_f hash, keycmp_f keycmp);
 
-// Re-allocates a `Map` instance by extending the `bucketslen` until the
-// following does not evaluates to true:
+// Returns the number of buckets a `Map` instance needs to hold `entrieslen`
+// entries without exceeding the `MAX_LOAD_FACTOR`, or the fewest holding them
+// all for small ones (see `Map`).
 //
-//                      #Entries
-//      LoadFactor > ~~~~~~~~~~~~~~
-//                      #Buckets
+// The result is always a power of two no smaller than `MAP_DEFAULT_BUCKET_LEN`
+// as required by `CalculateIndex()`.
+size_t MapComputeBucketsLen(const size_t entrieslen);
+
+// Re-allocates a `Map` instance whose entries are all used, to the
+// `bucketslen` returned by `MapGrowBucketsLen()`.
 //
 // Calling this function will result in a new `Map` instance which would be
-// the exact copy of the previous `Map` instance except for the `bucketslen`.
-//
-// We want to re-allocate the `Map` instance and extend the number of buckets
-// it currently has so to combat the chances of collisions.
+// the exact copy of the previous `Map` instance except for the `bucketslen`
+// and the holes left by removals, which are dropped.
 void MapRealloc(Map* map);
 
+// Returns the `bucketslen` a `Map` instance whose entries are all used grows
+// to, with room for half as many entries again as it holds so that removals
+// followed by insertions do not re-allocate it on every insertion.
+size_t MapGrowBucketsLen(const Map* const map);
+
+// Re-allocates the buckets of a `Map` instance down to the fewest its
+// `entrieslen` needs without exceeding the `MAX_LOAD_FACTOR`, e.g. once
+// entries were taken out with `MapRemove()`, dropping the holes they left.
+//
+// Returns `FALSE` if the buckets could not be re-allocated, the `Map` instance
+// is then left untouched.
+bool_t MapShrink(Map* const map);
+
+// Moves every entry of the `Map` instance into the given `buckets`, in order.
+//
+// `buckets` must be a zeroed block of `MapBucketsSize(bucketslen)` bytes where
+// `bucketslen` is a power of two no smaller than `MAP_DEFAULT_BUCKET_LEN` and
+// large enough for every entry.  The previous block is left for the caller to
+// release, so the memory of the buckets can be owned by someone other than
+// the free-store.  A pending migration is completed first.
+void MapRehash(Map* const map, MapEntry* const buckets,
+               const size_t bucketslen);
+
 // Copies `src` to `dest`.
 //
-// This function will not make the copies of the values stored inside of the
-// `src` hash map but will create a new bucket list of pointers pointing to the
-// values inside `src` hash map.
+// This function will not make the copies of the keys and values stored inside
+// of the `src` hash map but will put entries pointing to them into `dest`,
+// which must hash its keys the way `src` does.
 //
 // This is mainly used when `src` instance is stored in the `stack` while the
 // values inside of it are stored in the `free-store` and you don't want to lose
@@ -180,30 +312,6 @@ void MapFree(Map* const map);
 // instance will be destroyed forever.
 void MapFreeDeep(Map* const map);
 
-// Private function to free up the space occupied by the entries in a bucket.
-//
-// Takes in a `MapEntry` instance but frees up all the other entries linked
-// with that map entry and leaves the map entry given intially unchanged.
-//
-// Only the neighbours are freed using this function not the head node you still
-// need to free the head node by yourself.  This function is an implementation
-// detail, you should not use it as it is not the part of the public API.
-void MapFreeEntryImpl(MapEntry* const mapentry);
-
-// Private function to free up the space occupied by the entries and their
-// respective `key-value` pairs in a bucket.
-//
-// Takes in a `MapEntry` instance but frees up all the other entries linked
-// with that map entry and leaves the map entry given intially unchanged.
-//
-// Only the neighbours are freed using this function not the head node you still
-// need to free the head node by yourself.  This function is an implementation
-// detail, you should not use it as it is not the part of the public API.
-//
-// The `key-value` pair stored inside of the initial `MapEntry` will always get
-// destroyed from the free-store but not the `MapEntry` container.
-void MapFreeEntryDeepImpl(MapEntry* const mapentry);
-
 // Returns a `Map` instance with the built-in support for hash generation and
 // key comparison.  Key must always be a string data and the value could be
 // anything.
@@ -216,16 +324,35 @@ Map MapAllocNStrAsKey(const size_t entrieslen);
 // Creates a hash from a `key` of `string` data type.
 //
 // This functionality allow us to place a `key` inside our `Map` provided that
-// the given `key` is a `string` data type.  We read `keylen` bytes from the
-// given `key` and accumulate a `hash` value.
+// the given `key` is a `string` data type.  Same as `HashN()` over the
+// `strlen(key)` bytes of `key`.
 hash_t Hash(const void* const key);
 
+// Creates a hash from the `keylen` bytes of `key`, which may hold `NULL`
+// characters.
+//
+// The bytes are consumed up to 48 at a time and mixed with 64-bit multiplies
+// in the style of wyhash.  The hash is seeded once per process, from the
+// `CJSON_HASH_SEED` environment variable if it is set or from the system's
+// entropy otherwise, so colliding keys cannot be crafted ahead of time.
+// Hashes must therefore never be persisted.
+hash_t HashN(const void* const key, const size_t keylen);
+
 // Compares the eqaulity of two `keys` of `string` data type.
 //
 // We compare `key1` with `key2` to create a result.  Key should be of `string`
-// data type and must have a `NULL` terminator character.
+// data type and must have a `NULL` terminator character.  Identical pointers,
+// e.g. keys interned by the same `KeyPool`, compare equal without reading the
+// strings.
+//
+// A `Map` instance using it as its `keycmp` stores the length of its keys and
+// compares them by length and bytes instead, see `MapEntry`.
 bool_t KeyCmp(const void* key1, const void* key2);
 
+// Returns the length `Map` instance `map` stores for `key`, `strlen(key)` if
+// its keys are compared with `KeyCmp()` and `0` otherwise.
+size_t MapKeyLen(const Map* const map, const void* const key);
+
 #ifdef __cplusplus
 }
 #endif
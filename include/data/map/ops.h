@@ -39,51 +39,105 @@ extern "C" {
 // Injects the given set of key-value pair to the given `Map` instance if
 // already exists, overrides it.
 //
-// Generates a hash value using the given key and finds the position of a new
-// `MapEntry` instance in the `buckets` linked list.  To combat collision we
-// extend the already saved `MapEntry` by hooking it up with the new `MapEntry`
-// instance while keeping the order sorted based on the hash computed.
+// Generates a hash value using the given key and appends the pair to the
+// entries, see `MapPutEntry()`.
 //
-// Resizes the `Map` instance in case the load factor exceeds the
-// `MAX_LOAD_FACTOR`.
+// Grows the `Map` instance in case every entry, holes left by removals
+// included, is used, moving its entries a few at a time once it holds more
+// than `MAP_MIGRATE_STEP` of them (see `MapMigrate()`).
 void MapPut(Map *const map, void *const key, void *const value);
 
-// Returns a `void*` to the value mapped by the given `key`.
+// Same as `MapPut()` but uses the given `hash` instead of computing one from
+// `key`, e.g. one precomputed by a `KeyPool`.  The `hash` must be the one the
+// `hash` function of the `Map` instance computes for `key`.
+void MapPutWithHash(Map *const map, void *const key, void *const value,
+                    const hash_t hash);
+
+// Same as `MapPut()` but maps the `keylen` bytes at `key`, which may hold
+// `NULL` characters, e.g. a key whose length a decoder already knows.  The
+// `Map` instance must compare its keys with `KeyCmp()`.
+void MapPutN(Map *const map, void *const key, const size_t keylen,
+             void *const value);
+
+// Same as `MapPutN()` but uses the given precomputed `hash` of `key`.
+void MapPutNWithHash(Map *const map, void *const key, const size_t keylen,
+                     void *const value, const hash_t hash);
+
+// Appends a copy of the given `mapentry` to the entries, indexed by the first
+// free bucket of the probe sequence of its hash, and returns the stored entry.
 //
-// Traverse through the entries of the bucket at the computed `idx` value and
-// searches for a `hash` value that matches the computed `hash` value.  If we
-// find a value that is greater than the `hash` computed; not equal but greater
-// than then we immediately return `NULL` as having a value greater than the
-// computed `hash` using the `key` can only be possible when we have traversed
-// long enough but did not find any `hash` value equals to the computed `hash`.
+// The `hash` of `mapentry`, and its `keylen` if the `Map` instance compares its
+// keys with `KeyCmp()`, must already be computed.  If an entry with an
+// equal key already exists only its value is overridden and that entry is
+// returned instead, keeping its place in the order, even one not moved yet out
+// of the previous buckets of a growing `Map` instance.  Returns `NULL` if every
+// entry is used.
+//
+// Unlike `MapPut()` this never allocates nor resizes the `Map` instance, which
+// lets callers own the memory of the buckets.
+MapEntry *MapPutEntry(Map *const map, MapEntry *const mapentry);
+
+// Returns a `void*` to the value mapped by the given `key`.
 //
 // This should be very reminiscent of what we are doing in function
 // `MapEntry *MapGetEntry(Map *const map, void *const key)`.
 void *MapGet(Map *const map, void *const key);
 
+// Same as `MapGet()` but uses the given precomputed `hash` of `key`.
+void *MapGetWithHash(Map *const map, void *const key, const hash_t hash);
+
+// Same as `MapGet()` but looks up the `keylen` bytes at `key`, see `MapPutN()`.
+void *MapGetN(Map *const map, void *const key, const size_t keylen);
+
+// Same as `MapGetN()` but uses the given precomputed `hash` of `key`.
+void *MapGetNWithHash(Map *const map, void *const key, const size_t keylen,
+                      const hash_t hash);
+
 // Returns a `MapEntry*` to the `MapEntry` instance that holds the given `key`.
 //
-// Traverse through the entries of the bucket at the computed `idx` value and
-// searches for a `hash` value that matches the computed `hash` value.  If we
-// find a value that is greater than the `hash` computed; not equal but greater
-// than then we immediately return `NULL` as having a value greater than the
-// computed `hash` using the `key` can only be possible when we have traversed
-// long enough but did not find any `hash` value equals to the computed `hash`.
+// The control bytes of the group the hash of `key` maps to are compared with
+// the tag of that hash at once, and only the buckets whose tag matches have
+// their keys compared.  A group with an empty bucket ends the search, a full
+// one sends it on to the next group of the probe sequence.
 MapEntry *MapGetEntry(Map *const map, void *const key);
 
-// Returns a `void*` and removes to/the value mapped by the given `key`.
+// Same as `MapGetEntry()` but uses the given precomputed `hash` of `key`.
+MapEntry *MapGetEntryWithHash(Map *const map, void *const key,
+                              const hash_t hash);
+
+// Same as `MapGetEntry()` but looks up the `keylen` bytes at `key`, see
+// `MapPutN()`.
+MapEntry *MapGetEntryN(Map *const map, void *const key, const size_t keylen);
+
+// Same as `MapGetEntryN()` but uses the given precomputed `hash` of `key`.
+MapEntry *MapGetEntryNWithHash(Map *const map, void *const key,
+                               const size_t keylen, const hash_t hash);
+
+// Moves up to `entrieslen` entries of a growing `Map` instance out of its
+// previous buckets, which are released once empty.  Returns whether entries
+// are left to move.
 //
-// `MapEntry` with the associated key i.e., `key` will be deleted from the
-// free-store while returning a `void*` to the value mapped with the given
-// `key`.
+// Every insertion already moves `MAP_MIGRATE_STEP` entries, this lets callers
+// finish the job ahead of time, e.g. while idle.
+bool_t MapMigrate(Map *const map, const size_t entrieslen);
+
+// Returns a `void*` and removes to/the value mapped by the given `key`.
 //
-// This should be very reminiscent of what we are doing in function `MapEntry
-// *MapGetEntry(Map *const map, void *const key)` except after locating the
-// entry in the `buckets` list we free the memory occupied by that `MapEntry`.
+// The bucket holding the `key` is marked empty again if its group still has an
+// empty bucket, as no probe was ever sent past that group, or deleted
+// otherwise so that probes keep going past it.  Deleted buckets are reused by
+// later insertions and cleared the next time the `Map` instance is resized.
+// The entry is left as a hole in the order, see `MapEntryRemoved()`, unless it
+// is the last one.  Entries not moved yet out of the previous buckets of a
+// growing `Map` instance are removed from there.
 // This function is not responsible to free up the free-store occupied by the
-// value inside of the `MapEntry` the caller should take care of that.
+// key or the value, the caller should take care of that.
 void *MapRemove(Map *const map, void *const key);
 
+// Same as `MapRemove()` but removes the `keylen` bytes at `key`, see
+// `MapPutN()`.
+void *MapRemoveN(Map *const map, void *const key, const size_t keylen);
+
 #ifdef __cplusplus
 }
 #endif
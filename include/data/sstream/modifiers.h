@@ -35,6 +35,9 @@
 #include "bytes.h"
 #include "data/sstream/sstream.h"
 
+#define SSTREAM_READ_SUCCESS SSTREAM_REALLOC_SUCCESS
+#define SSTREAM_READ_FAILURE SSTREAM_REALLOC_FAILURE
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -58,8 +61,11 @@ void StringStreamConcat(StringStream* const sstream, const char* format, ...);
 //
 // The `length` property will decide how many bytes to copy from `data` to
 // `sstream->data` while ignoring the `NULL` bytes on the way.
-void StringStreamRead(StringStream* const sstream, const void* data,
-                      const size_t length);
+//
+// Function returns `SSTREAM_READ_FAILURE` and copies nothing if the buffer
+// could not be re-allocated, `SSTREAM_READ_SUCCESS` otherwise.
+u_int8_t StringStreamRead(StringStream* const sstream, const void* data,
+                          const size_t length);
 
 // Impedes the position of the terminate character `\0` by `length`, or if the
 // length is greater than the data length of `StringStream` instance, places the
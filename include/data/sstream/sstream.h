@@ -32,6 +32,8 @@
 
 #include <sys/types.h>
 
+#include "allocator.h"
+
 #define SSTREAM_DEFAULT_SIZE (1 << 2)
 
 #define SSTREAM_REALLOC_FAILURE 0
@@ -57,6 +59,8 @@ typedef struct StringStream {
   //     0 <= length <= capacity
   //     data == NULL implies length == capacity == 0
   size_t capacity;
+  // Where `data` comes from.
+  const Allocator* allocator;
 } StringStream;
 
 // Returns a initialized `StringStream` instance.
@@ -75,6 +79,15 @@ StringStream StringStreamAlloc();
 // `ComputeStringStreamBufferCapacity()`.
 StringStream StringStreamNAlloc(const size_t length);
 
+// Returns a initialized `StringStream` instance of given length whose memory
+// comes from the given `allocator`, or from the process-wide allocator if
+// `allocator` is `NULL`.
+//
+// The `StringStream` instance keeps using `allocator` for every re-allocation
+// and for releasing its data.
+StringStream StringStreamNAllocWithAllocator(const size_t length,
+                                             const Allocator* const allocator);
+
 // Returns a initialized `StringStream` instance from a `const char*` C-String.
 //
 // The length of the `StringStream` instance will be the number of items from
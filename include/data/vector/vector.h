@@ -32,6 +32,8 @@
 
 #include <sys/types.h>
 
+#include "allocator.h"
+
 #define VECTOR_DEFAULT_SIZE (1 << 2)
 
 // clang-format off
@@ -60,6 +62,9 @@ typedef struct Vector {
   //     0 <= size <= capacity
   //     data == NULL implies size == capacity == 0
   size_t capacity;
+  // Where `data` comes from, the elements are released with it as well by
+  // `VectorFreeDeep()`.
+  const Allocator* allocator;
 } Vector;
 
 // Returns an initialized instance of `Vector` of length `VECTOR_DEFAULT_SIZE`.
@@ -78,6 +83,15 @@ Vector VectorDefAlloc();
 // `ComputeVectorBufferCapacity()`.
 Vector VectorAlloc(const size_t size);
 
+// Returns an initialized instance of `Vector` of `length` whose memory comes
+// from the given `allocator`, or from the process-wide allocator if
+// `allocator` is `NULL`.
+//
+// The `Vector` instance keeps using `allocator` for every re-allocation and
+// for releasing its data and its elements.
+Vector VectorAllocWithAllocator(const size_t size,
+                                const Allocator* const allocator);
+
 // Re-allocates the free store space occupied by the `Vector` container.
 //
 // This function re-allocates the `Vector` instance either by expanding the size
@@ -90,6 +104,16 @@ Vector VectorAlloc(const size_t size);
 //  * `VECTOR_RESIZE_FAILURE` if the re-allocation failed.
 u_int8_t VectorResize(Vector* const vector, const size_t size);
 
+// Re-allocates the free store space occupied by the `Vector` container down to
+// its `size`, releasing the growth slack left by earlier insertions.
+//
+// Function returns:
+//  * `VECTOR_RESIZE_NOT_REQUIRED` if the capacity already matches the size,
+//  * `VECTOR_RESIZE_SUCCESS` if the re-allocation was successful, or
+//  * `VECTOR_RESIZE_FAILURE` if the re-allocation failed, the container is
+//    then left untouched.
+u_int8_t VectorShrink(Vector* const vector);
+
 // Copies `src` to `dest`.
 //
 // This function will not make the copies of the values stored inside of the
@@ -0,0 +1,125 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_DOCUMENT_H_
+#define CJSON_INCLUDE_DOCUMENT_H_
+
+#include <sys/types.h>
+
+#include "bool.h"
+#include "cjson.h"
+#include "data/arena/arena.h"
+#include "data/map/intern.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A `JSON` tree whose nodes, map entries, bucket arrays, list buffers and
+// strings are all bump-allocated out of a single `Arena`.
+//
+// Nodes of a document are ordinary `JSON` instances and can be read with every
+// accessor, but they must only be modified with the `JSON_Document*()`
+// functions and must never be passed to `JSON_Free()`, `JSON_FreeDeep()` or
+// the `JSON_ListAdd()` and `JSON_ObjectPut()` modifiers.  The whole tree is
+// released at once by `JSON_DocumentFree()` in time proportional to the number
+// of arena blocks, not the number of nodes.
+typedef struct JSON_Document {
+  Arena arena;
+  // Not used by the document itself, a convenient place to keep the node the
+  // tree hangs from.
+  JSON* root;
+  // When set, object keys are interned in this pool instead of being copied
+  // into the arena, so documents sharing a pool share their keys.  The pool
+  // must outlive the document.  `NULL` by default.
+  KeyPool* keys;
+} JSON_Document;
+
+// Returns an empty `JSON_Document` instance.
+JSON_Document JSON_DocumentAlloc();
+
+// Releases every node of `document` at once.
+void JSON_DocumentFree(JSON_Document* const document);
+
+// Each of the following returns a new node allocated in `document`, or `NULL`
+// if the free-store is exhausted.
+JSON* JSON_DocumentNull(JSON_Document* const document);
+JSON* JSON_DocumentBool(JSON_Document* const document,
+                        const json_bool_t boolean);
+JSON* JSON_DocumentNumber(JSON_Document* const document,
+                          const json_number_t number);
+JSON* JSON_DocumentDecimal(JSON_Document* const document,
+                           const json_decimal_t decimal);
+
+// Returns a new `JSON_String` node holding a copy of `string`.
+JSON* JSON_DocumentString(JSON_Document* const document,
+                          const char* const string);
+
+// Returns a new `JSON_String` node holding a `NULL` terminated copy of the
+// `length` bytes at `string`.
+JSON* JSON_DocumentStringN(JSON_Document* const document,
+                           const char* const string, const size_t length);
+
+// Returns a new empty `JSON_List` node with room for `size` elements.
+JSON* JSON_DocumentList(JSON_Document* const document, const size_t size);
+
+// Returns a new empty `JSON_Object` node with enough buckets for `entrieslen`
+// entries.
+JSON* JSON_DocumentObject(JSON_Document* const document,
+                          const size_t entrieslen);
+
+// Appends `value` to the `JSON_List` node `list`, growing its buffer in the
+// arena.  Returns `FALSE` if the free-store is exhausted.
+bool_t JSON_DocumentListAdd(JSON_Document* const document, JSON* const list,
+                            JSON* const value);
+
+// Maps a copy of `key` to `value` in the `JSON_Object` node `object`, growing
+// its buckets in the arena.  Returns `FALSE` if the free-store is exhausted.
+//
+// If the `document` has a `KeyPool` the canonical copy of `key` is used instead
+// along with its precomputed hash.
+bool_t JSON_DocumentObjectPut(JSON_Document* const document, JSON* const object,
+                              const char* const key, JSON* const value);
+
+// Same as `JSON_DocumentObjectPut()` but maps the `keylen` bytes at `key`,
+// which may hold `NULL` characters.
+bool_t JSON_DocumentObjectPutN(JSON_Document* const document,
+                               JSON* const object, const char* const key,
+                               const size_t keylen, JSON* const value);
+
+// Returns a deep copy of `json` allocated in `document`, or `NULL` if the
+// free-store is exhausted.
+JSON* JSON_DocumentImport(JSON_Document* const document,
+                          const JSON* const json);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_DOCUMENT_H_
@@ -0,0 +1,67 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_FORMAT_H_
+#define CJSON_INCLUDE_FORMAT_H_
+
+#include <sys/types.h>
+
+#include "data/sstream/sstream.h"
+
+// Number of spaces `JSON_Reformat()` uses per nesting level when the caller
+// does not care; matches the indentation `JSON_Stringify()` produces.
+#define JSON_FORMAT_DEFAULT_INDENT 4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Appends the `JSON` text held in `src` onto `dest` with all the insignificant
+// whitespace removed.
+//
+// This works directly on the bytes of `src` without ever building a `JSON`
+// tree, string literals are copied verbatim including their escape sequences.
+// The input is not validated, malformed text is minified on a best effort
+// basis.
+void JSON_Minify(StringStream* const dest, const StringStream* const src);
+
+// Appends the `JSON` text held in `src` onto `dest` re-indented by `indent`
+// spaces per nesting level.
+//
+// Like `JSON_Minify()` this never builds a `JSON` tree.  Members are placed on
+// their own lines, keys are followed by `": "` and empty lists and objects are
+// kept as `[]` and `{}`.  An `indent` of `0` is equivalent to `JSON_Minify()`.
+void JSON_Reformat(StringStream* const dest, const StringStream* const src,
+                   const size_t indent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_FORMAT_H_
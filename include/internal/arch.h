@@ -41,4 +41,11 @@
 #define CJSON_OS_LINUX 1
 #endif
 
+// Vector instruction sets we know how to take advantage of.  These are only
+// defined when the compiler is allowed to emit them for the target, so code
+// guarded by them never needs a runtime dispatch.
+#if defined(__SSE2__)
+#define CJSON_ARCH_SSE2 1
+#endif
+
 #endif  // CJSON_INCLUDE_INTERNAL_ARCH_H_
@@ -0,0 +1,52 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_INTERNAL_ENDIAN_H_
+#define CJSON_INCLUDE_INTERNAL_ENDIAN_H_
+
+#include <sys/types.h>
+
+// Stores the low `width` bytes of `value` at `dest` most significant byte
+// first, the byte order binary formats such as CBOR and MessagePack use.
+static inline void StoreBigEndian(u_int8_t* const dest, const u_int64_t value,
+                                  const size_t width) {
+  for (size_t i = 0; i < width; ++i)
+    dest[width - 1 - i] = (u_int8_t)(value >> (i * 8));
+}
+
+// Loads `width` bytes stored most significant byte first at `src`.
+static inline u_int64_t LoadBigEndian(const u_int8_t* const src,
+                                      const size_t width) {
+  u_int64_t value = 0;
+  for (size_t i = 0; i < width; ++i)
+    value = (value << 8) | src[i];
+  return value;
+}
+
+#endif  // CJSON_INCLUDE_INTERNAL_ENDIAN_H_
@@ -36,7 +36,23 @@
 extern "C" {
 #endif
 
+// Adds the free-store allocated `value` to the end of `list`, which takes
+// ownership of it.
+//
+// A list storing its elements by value (see `JSON_FLAG_LIST_VALUES`) moves
+// `*value` into its array and releases the container `value` right away, or
+// for an attached shared tree (see `JSON_Ref`) copies it and drops `value`.
 void JSON_ListAdd(JSON* const list, JSON* const value);
+
+// Adds a copy of `*value` to the end of `list` and returns the copy, or `NULL`
+// if the free-store is exhausted.  The copy takes over whatever `*value` owns,
+// e.g. the characters of a string.
+//
+// A list storing its elements by value copies `*value` into its array, any
+// other list into a new free-store container.  The reference held by an
+// attached shared tree (see `JSON_Ref`) is dropped once the tree is copied.
+JSON* JSON_ListAppend(JSON* const list, const JSON* const value);
+
 void _JSON_ListAddNull(JSON* const list);
 void _JSON_ListAddNumber(JSON* const list, const json_number_t value);
 void _JSON_ListAddDecimal(JSON* const list, const json_decimal_t value);
@@ -50,6 +66,12 @@ void _JSON_ListAddString(JSON* const list, const json_string_t data);
 
 void JSON_ObjectPut(JSON* const object, const json_string_t key,
                     JSON* const value);
+
+// Same as `JSON_ObjectPut()` but maps the `keylen` bytes at `key`, which may
+// hold `NULL` characters.
+void JSON_ObjectPutN(JSON* const object, const json_string_t key,
+                     const size_t keylen, JSON* const value);
+
 void _JSON_ObjectPutNull(JSON* const object, const json_string_t key);
 void _JSON_ObjectPutNumber(JSON* const object, const json_string_t key,
                            const json_number_t value);
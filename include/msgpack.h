@@ -0,0 +1,81 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_MSGPACK_H_
+#define CJSON_INCLUDE_MSGPACK_H_
+
+#include "bool.h"
+#include "cjson.h"
+#include "data/sstream/sstream.h"
+
+// Deepest nesting of lists and objects `JSON_FromMsgPack()` accepts, protects
+// the decoder from exhausting the stack on hostile input.
+#define JSON_MSGPACK_MAX_DEPTH 512
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Appends the MessagePack encoding of `json` onto `msgpack`.
+//
+// Every value is written in the smallest format that holds it:
+//
+//      JSON_Null     nil
+//      JSON_Boolean  false and true
+//      JSON_Number   positive or negative fixint, uint 8 to 64 for positive
+//                    numbers and int 8 to 64 for negative ones
+//      JSON_Decimal  float 32 if lossless, float 64 otherwise
+//      JSON_String   fixstr, str 8, str 16 or str 32
+//      JSON_List     fixarray, array 16 or array 32
+//      JSON_Object   fixmap, map 16 or map 32 with string keys
+//
+// Returns `FALSE` if an argument is `NULL` or if `msgpack` could not grow to
+// hold the encoding, in which case it holds a truncated prefix of it.
+bool_t JSON_ToMsgPack(StringStream* const msgpack, const JSON* const json);
+
+// Decodes the single MessagePack object held in `msgpack` into `json`.
+//
+// If `zero_copy` is `TRUE` string values are not copied, they are decoded as
+// views (see `JSON_FLAG_STRING_VIEW`) into `msgpack->data` which then must
+// outlive the decoded tree and must not be modified.  Object keys are always
+// copied.
+//
+// Returns `TRUE` on success in which case the decoded tree lives in the
+// free-store and must be released with `JSON_FreeDeep()`.  Returns `FALSE` and
+// leaves a `JSON_Null` in `json` if `msgpack` is not well-formed, holds
+// trailing bytes, or uses something that has no `JSON` counterpart such as bin
+// and ext types, non-string or duplicate object keys.
+bool_t JSON_FromMsgPack(JSON* const json, const StringStream* const msgpack,
+                        const bool_t zero_copy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_MSGPACK_H_
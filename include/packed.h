@@ -0,0 +1,150 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CJSON_INCLUDE_PACKED_H_
+#define CJSON_INCLUDE_PACKED_H_
+
+#include <sys/types.h>
+
+#include "bool.h"
+#include "cjson.h"
+
+// Strings up to this many characters are stored inline in their node, `NULL`
+// terminated, instead of in the character buffer of the packed tree.
+#define JSON_PACKED_SHORT_STRING_CAPACITY 7
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A 16-byte node of a packed tree.
+//
+// Children are never pointed to, they are stored by value in the node array of
+// the tree: the `count` elements of a list are the `count` consecutive nodes
+// starting at `value.offset`, and the `count` entries of an object are the
+// `2 * count` consecutive nodes starting at `value.offset`, each entry being a
+// `JSON_String` key node directly followed by its value node.  Entries are
+// sorted by key so objects are searched in logarithmic time.
+//
+// `value.offset` of a string is the position of its characters in the
+// character buffer of the tree unless `flags` has `JSON_FLAG_STRING_INLINE`, in
+// which case they are in `value.shortstr`; `count` is its length either way.
+typedef struct JSON_PackedNode {
+  u_int8_t type;
+  u_int8_t flags;
+  u_int16_t reserved;
+  u_int32_t count;
+  union {
+    json_bool_t boolean;
+    json_number_t number;
+    json_decimal_t decimal;
+    u_int64_t offset;
+    char shortstr[JSON_PACKED_SHORT_STRING_CAPACITY + 1];
+  } value;
+} JSON_PackedNode;
+
+// A read-only `JSON` tree in the compact layout built by `JSON_Pack()`.
+//
+// The whole tree takes two allocations, one for `nodes` whose first node is the
+// root and one for the `NULL` terminated characters of the strings that are
+// not inline, each distinct string being stored once however many keys and
+// values hold it.  A list element costs one node and an object entry two, with
+// no per-node allocation, pointer or map entry; since nodes refer to each other
+// by position the buffers can be copied or moved freely.
+typedef struct JSON_Packed {
+  JSON_PackedNode* nodes;
+  size_t nodeslen;
+  char* chars;
+  size_t charslen;
+} JSON_Packed;
+
+// Packs the tree rooted at `json` into `packed`, which must be released with
+// `JSON_PackedFree()`.
+//
+// Returns `FALSE` if the free-store is exhausted or if a string, list or object
+// is too large for the layout (more than `UINT32_MAX` characters or elements),
+// `packed` is then left empty.
+bool_t JSON_Pack(JSON_Packed* const packed, const JSON* const json);
+
+// Unpacks the subtree of `packed` rooted at `node` into `json`, a regular tree
+// owning copies of every string and key which is released with
+// `JSON_FreeDeep()`.  Returns `FALSE` if the free-store is exhausted, `json` is
+// then left holding whatever was unpacked so far.
+bool_t JSON_Unpack(JSON* const json, const JSON_Packed* const packed,
+                   const JSON_PackedNode* const node);
+
+// Releases both buffers of `packed`.
+void JSON_PackedFree(JSON_Packed* const packed);
+
+// Returns the number of bytes held by `packed`.
+size_t JSON_PackedMemoryUsage(const JSON_Packed* const packed);
+
+// Returns the root node of `packed`, `NULL` if it is empty.
+const JSON_PackedNode* JSON_PackedRoot(const JSON_Packed* const packed);
+
+// Returns the `NULL` terminated characters of a `JSON_String` node and stores
+// their count in `length` unless it is `NULL`.  Returns `NULL` for any other
+// node.
+const char* JSON_PackedString(const JSON_Packed* const packed,
+                              const JSON_PackedNode* const node,
+                              size_t* const length);
+
+// Returns the number of elements of a `JSON_List` node or entries of a
+// `JSON_Object` node, `0` for any other node.
+size_t JSON_PackedSize(const JSON_PackedNode* const node);
+
+// Returns the element at `index` of a `JSON_List` node, `NULL` if there is
+// none.
+const JSON_PackedNode* JSON_PackedListGet(const JSON_Packed* const packed,
+                                          const JSON_PackedNode* const node,
+                                          const size_t index);
+
+// Returns the value of `key` in a `JSON_Object` node, `NULL` if there is none.
+const JSON_PackedNode* JSON_PackedObjectGet(const JSON_Packed* const packed,
+                                            const JSON_PackedNode* const node,
+                                            const char* const key);
+
+// Same as `JSON_PackedObjectGet()` but looks up the `keylen` bytes at `key`,
+// which may hold `NULL` characters.
+const JSON_PackedNode* JSON_PackedObjectGetN(const JSON_Packed* const packed,
+                                             const JSON_PackedNode* const node,
+                                             const char* const key,
+                                             const size_t keylen);
+
+// Returns the value of the entry at `index` of a `JSON_Object` node and stores
+// its key in `key` unless it is `NULL`.  Entries are sorted by key.
+const JSON_PackedNode* JSON_PackedObjectEntry(const JSON_Packed* const packed,
+                                              const JSON_PackedNode* const node,
+                                              const size_t index,
+                                              const char** const key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_PACKED_H_
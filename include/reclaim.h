@@ -0,0 +1,66 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_RECLAIM_H_
+#define CJSON_INCLUDE_RECLAIM_H_
+
+#include <sys/types.h>
+
+#include "bool.h"
+#include "cjson.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Trees waiting for the reclamation thread, beyond this many `JSON_FreeAsync()`
+// frees the tree in the calling thread instead.
+#define JSON_RECLAIM_QUEUE_DEPTH (1 << 6)
+
+// Detaches the tree `json` holds and hands it to a background reclamation
+// thread, which releases it with `JSON_FreeDeep()`.  `json` is left a
+// `JSON_Null` instance, the node itself stays with the caller.
+//
+// The reclamation thread is started on first use.  Returns `FALSE` if the tree
+// was freed in the calling thread instead, because it holds nothing worth
+// deferring, the queue is full or the thread could not be started.  The
+// process-wide allocator must be thread-safe, as libc's is, and shared trees
+// attached below `json` must have been made atomic with `JSON_RefShare()`.
+bool_t JSON_FreeAsync(JSON* const json);
+
+// Waits until every tree handed to `JSON_FreeAsync()` has been released and
+// stops the reclamation thread, typically at shutdown.  A later
+// `JSON_FreeAsync()` starts a new one.
+void JSON_FreeAsyncDrain();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_RECLAIM_H_
@@ -0,0 +1,113 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_REF_H_
+#define CJSON_INCLUDE_REF_H_
+
+#include <sys/types.h>
+
+#include "bool.h"
+#include "cjson.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A reference-counted `JSON` tree, the block holding the count and the root
+// node is private to the implementation.
+typedef struct JSON_Shared JSON_Shared;
+
+// A handle to a reference-counted `JSON` tree that any number of handles and
+// documents can share without copying it.
+//
+// The tree is immutable while shared: read it with `JSON_RefGet()` and get a
+// tree of your own to modify with `JSON_RefMut()`, which copies it first if
+// anyone else still holds a reference (copy-on-write).  The tree is released
+// with `JSON_FreeDeep()` once its last reference is dropped.
+//
+// A shared tree is attached to a pointer list or an object of another tree by
+// adding the node returned by `JSON_RefAttach()` with `JSON_ListAdd()` or
+// `JSON_ObjectPut()`; freeing that tree then drops the reference instead of
+// freeing the shared tree.  Attached nodes carry `JSON_FLAG_SHARED` and must
+// not be modified in place.
+typedef struct JSON_Ref {
+  JSON_Shared* shared;
+} JSON_Ref;
+
+// Returns a handle to a new shared tree that takes over `*json` and whatever it
+// owns, like `JSON_ListAppend()` does, or a handle to nothing if the
+// free-store is exhausted.  The container `json` itself is left to the caller.
+//
+// The count is not atomic until `JSON_RefShare()` is called.
+JSON_Ref JSON_RefNew(const JSON* const json);
+
+// Makes every later change to the count of `ref` atomic so that its handles
+// and the trees it is attached to can be released from any thread.  Must be
+// called before the tree is handed to another thread.
+void JSON_RefShare(const JSON_Ref ref);
+
+// Returns a new handle to the tree of `ref`.
+JSON_Ref JSON_RefRetain(const JSON_Ref ref);
+
+// Drops the reference held by `*ref` and resets it, the tree is released if
+// that was the last one.
+void JSON_RefRelease(JSON_Ref* const ref);
+
+// Returns the number of references to the tree of `ref`, attachments included.
+size_t JSON_RefCount(const JSON_Ref ref);
+
+// Returns the root of the tree of `ref` for reading.
+const JSON* JSON_RefGet(const JSON_Ref ref);
+
+// Returns the root of the tree of `ref` for writing, after replacing the tree
+// of `*ref` with a copy of its own if it is shared with anyone else.  Returns
+// `NULL` and leaves `*ref` unchanged if the free-store is exhausted.
+JSON* JSON_RefMut(JSON_Ref* const ref);
+
+// Takes a new reference to the tree of `ref` and returns its root node, to be
+// added to a pointer list or an object of another tree.
+JSON* JSON_RefAttach(const JSON_Ref ref);
+
+// Drops the reference held by the attached node `json`, this is what
+// `JSON_Free()` and `JSON_FreeDeep()` do with nodes carrying
+// `JSON_FLAG_SHARED`.
+void JSON_RefDetach(JSON* const json);
+
+// Copies the tree under `src` into `dest` as a tree of its own that can be
+// modified and released with `JSON_FreeDeep()`.  Shared trees attached below
+// `src` are attached to the copy rather than copied.
+//
+// Returns `FALSE` and leaves nothing allocated if the free-store is exhausted.
+bool_t JSON_RefCopy(JSON* const dest, const JSON* const src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_REF_H_
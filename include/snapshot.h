@@ -0,0 +1,156 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_SNAPSHOT_H_
+#define CJSON_INCLUDE_SNAPSHOT_H_
+
+#include <sys/types.h>
+
+#include "bool.h"
+#include "cjson.h"
+#include "data/sstream/sstream.h"
+
+// First eight bytes of every snapshot, the last byte is the format version.
+#define JSON_SNAPSHOT_MAGIC "cJSONsn\x01"
+
+// Returned in place of a node that does not exist, e.g. a missing object key
+// or an out of bounds list index.  Offset zero is always the snapshot header so
+// it can never be a node.
+#define JSON_SNAPSHOT_NONE ((JSON_SnapshotNode)0)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A node of a snapshot, i.e. the offset of the node from the beginning of the
+// snapshot.  Offsets make snapshots position-independent, the same bytes can be
+// queried wherever they are mapped.
+typedef u_int64_t JSON_SnapshotNode;
+
+// A read-only `JSON` document serialized by `JSON_SnapshotWrite()`.
+//
+// A snapshot is queried in place, it is never parsed into `JSON` instances and
+// querying it never allocates.
+typedef struct JSON_Snapshot {
+  const u_int8_t* data;
+  size_t length;
+  // `TRUE` if `data` was mapped by `JSON_SnapshotOpen()`.
+  bool_t mapped;
+} JSON_Snapshot;
+
+// Appends the snapshot of `json` onto `snapshot`.
+//
+// Every node starts at an 8-byte aligned offset and refers to its children with
+// offsets rather than pointers.  Object keys are hashed at write time into a
+// per-object open addressing index so lookups only hash the searched key.
+// Numbers are stored in native byte order, snapshots are not portable across
+// byte orders.
+//
+// Returns `FALSE` if the free-store is exhausted or if a string, list or object
+// is too large for the format (more than `UINT32_MAX` bytes or elements).
+bool_t JSON_SnapshotWrite(StringStream* const snapshot, const JSON* const json);
+
+// Initializes `snapshot` over the `length` bytes at `data`.
+//
+// `data` is not copied so it must outlive `snapshot` and must be 8-byte
+// aligned.  Returns `FALSE` if `data` does not hold a snapshot written on a
+// machine with the same byte order.
+bool_t JSON_SnapshotFromBuffer(JSON_Snapshot* const snapshot,
+                               const void* const data, const size_t length);
+
+// Maps the snapshot file at `path` read-only into memory.
+//
+// Pages are shared with every other process mapping the same file and are only
+// read from disk once touched.  Returns `FALSE` if the file cannot be mapped or
+// does not hold a snapshot, release a mapped snapshot with
+// `JSON_SnapshotClose()`.
+bool_t JSON_SnapshotOpen(JSON_Snapshot* const snapshot, const char* const path);
+
+// Unmaps a snapshot opened with `JSON_SnapshotOpen()`, does nothing more than
+// resetting `snapshot` if it was initialized with `JSON_SnapshotFromBuffer()`.
+void JSON_SnapshotClose(JSON_Snapshot* const snapshot);
+
+// Returns the root node of `snapshot`.
+JSON_SnapshotNode JSON_SnapshotRoot(const JSON_Snapshot* const snapshot);
+
+// Returns the `JSON_type` of `node`.
+//
+// Every accessor below checks that `node` lies within the snapshot, so even a
+// corrupt snapshot is never read out of bounds.  Nodes that fail the check,
+// including `JSON_SNAPSHOT_NONE`, read as `JSON_Null`.
+JSON_type JSON_SnapshotType(const JSON_Snapshot* const snapshot,
+                            const JSON_SnapshotNode node);
+
+// Returns the value of a `JSON_Boolean` node, `FALSE` for any other node.
+json_bool_t JSON_SnapshotBool(const JSON_Snapshot* const snapshot,
+                              const JSON_SnapshotNode node);
+
+// Returns the value of a `JSON_Number` node, `0` for any other node.
+json_number_t JSON_SnapshotNumber(const JSON_Snapshot* const snapshot,
+                                  const JSON_SnapshotNode node);
+
+// Returns the value of a `JSON_Decimal` node, `0.0` for any other node.
+json_decimal_t JSON_SnapshotDecimal(const JSON_Snapshot* const snapshot,
+                                    const JSON_SnapshotNode node);
+
+// Returns the `NULL` terminated characters of a `JSON_String` node and stores
+// their count in `length` unless it is `NULL`.  Returns `NULL` for any other
+// node.
+const char* JSON_SnapshotString(const JSON_Snapshot* const snapshot,
+                                const JSON_SnapshotNode node,
+                                size_t* const length);
+
+// Returns the number of elements of a `JSON_List` node or entries of a
+// `JSON_Object` node, `0` for any other node.
+size_t JSON_SnapshotSize(const JSON_Snapshot* const snapshot,
+                         const JSON_SnapshotNode node);
+
+// Returns the element at `index` of a `JSON_List` node.
+JSON_SnapshotNode JSON_SnapshotListGet(const JSON_Snapshot* const snapshot,
+                                       const JSON_SnapshotNode node,
+                                       const size_t index);
+
+// Returns the value of `key` in a `JSON_Object` node.
+JSON_SnapshotNode JSON_SnapshotObjectGet(const JSON_Snapshot* const snapshot,
+                                         const JSON_SnapshotNode node,
+                                         const char* const key);
+
+// Returns the value of the entry at `index` of a `JSON_Object` node and stores
+// its key in `key` unless it is `NULL`.  Entries are in the order the object
+// was iterated when the snapshot was written.
+JSON_SnapshotNode JSON_SnapshotObjectEntry(const JSON_Snapshot* const snapshot,
+                                           const JSON_SnapshotNode node,
+                                           const size_t index,
+                                           const char** const key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_SNAPSHOT_H_
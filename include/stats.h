@@ -0,0 +1,82 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_STATS_H_
+#define CJSON_INCLUDE_STATS_H_
+
+#include <sys/types.h>
+
+#include "cjson.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The number of `JSON_type` values, for tables indexed by type.
+#define JSON_TYPE_COUNT (JSON_Object + 1)
+
+// The free-store memory a `JSON` tree holds, in bytes by category, as reported
+// by `JSON_MemoryStats()`.
+//
+// Sizes are the ones requested from the allocator, without its own overhead.
+// Shared trees attached below the root (see `JSON_Ref`) belong to their
+// references rather than to the tree and are only counted in `shared`.
+typedef struct JSON_MemoryUsage {
+  // `JSON` nodes, the root included.  Elements of lists storing their elements
+  // by value live in the list buffer instead.
+  size_t nodes;
+  // Bucket arrays of objects, the entries stored in them included.
+  size_t buckets;
+  // The part of `buckets` holding entries.
+  size_t entries;
+  // List buffers, unused capacity included.
+  size_t vectors;
+  // The part of `vectors` beyond the size of the lists.
+  size_t unused;
+  // Owned string characters and object keys, terminators included.
+  size_t strings;
+  // The sum of the categories above.
+  size_t total;
+  // The number of attached shared trees.
+  size_t shared;
+  // The number of values of each `JSON_type`, the root included.
+  size_t types[JSON_TYPE_COUNT];
+} JSON_MemoryUsage;
+
+// Walks the tree under `json` and returns the memory it holds.
+//
+// This takes time proportional to the size of the tree; for a running total of
+// every tree of the process, see `AllocatorCounting()`.
+JSON_MemoryUsage JSON_MemoryStats(const JSON* const json);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_STATS_H_
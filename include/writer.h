@@ -0,0 +1,141 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_INCLUDE_WRITER_H_
+#define CJSON_INCLUDE_WRITER_H_
+
+#include <sys/types.h>
+
+#include "bool.h"
+#include "cjson.h"
+#include "data/sstream/sstream.h"
+
+// Deepest nesting of lists and objects a `JSON_Writer` can keep track of.  The
+// nesting state lives inside of the writer itself so that writing a document
+// never needs the free-store for anything but the output buffer.
+#define JSON_WRITER_MAX_DEPTH 256
+
+// Number of buffered bytes after which a `JSON_Writer` with a sink hands its
+// output over to the sink.
+#define JSON_WRITER_SINK_THRESHOLD (1 << 12)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Function signature for the function a `JSON_Writer` hands its output to.
+//
+// `data` is only valid for the duration of the call, the sink must copy it if
+// it wants to keep it around.
+typedef void (*JSON_WriterSink)(void* const ctx, const char* const data,
+                                const size_t length);
+
+// `JSON_Writer` emits `JSON` text straight into a `StringStream` without ever
+// building a `JSON` tree.
+//
+// The writer keeps track of the commas and of the nesting of lists and objects
+// so the caller only needs to describe the document in order, for example:
+//
+//      JSON_WriterBeginObject(&writer);
+//      JSON_WriterKey(&writer, "id");
+//      JSON_WriterNumber(&writer, 42);
+//      JSON_WriterEndObject(&writer);
+//
+// Misusing the writer, e.g. writing a value where a key is expected or closing
+// a container that was never opened, puts it into a failed state in which all
+// the subsequent calls are ignored; `JSON_WriterFinish()` reports it.
+typedef struct JSON_Writer {
+  StringStream* sstream;
+
+  // Optional sink the output is handed to whenever more than
+  // `JSON_WRITER_SINK_THRESHOLD` bytes are buffered in `sstream`.
+  JSON_WriterSink sink;
+  void* sink_ctx;
+
+  size_t depth;
+  // Bit `i` is set when the container at nesting level `i + 1` is an object.
+  u_int64_t objects[JSON_WRITER_MAX_DEPTH / 64];
+
+  // Set once a value was written in the current container, so the next one
+  // needs to be preceded by a comma.
+  bool_t needs_comma;
+  // Set after a key was written and before its value.
+  bool_t after_key;
+  // Set once the top-level value is written.
+  bool_t complete;
+  bool_t failed;
+} JSON_Writer;
+
+// Initializes a `JSON_Writer` that appends its output to `sstream`.
+void JSON_WriterInit(JSON_Writer* const writer, StringStream* const sstream);
+
+// Initializes a `JSON_Writer` that uses `sstream` as a buffer and hands its
+// content to `sink` in chunks of about `JSON_WRITER_SINK_THRESHOLD` bytes.
+//
+// `sstream` is emptied every time it is flushed to the `sink` so its capacity
+// is reused for the entire document.
+void JSON_WriterInitSink(JSON_Writer* const writer, StringStream* const sstream,
+                         JSON_WriterSink sink, void* const ctx);
+
+void JSON_WriterBeginObject(JSON_Writer* const writer);
+void JSON_WriterEndObject(JSON_Writer* const writer);
+void JSON_WriterBeginList(JSON_Writer* const writer);
+void JSON_WriterEndList(JSON_Writer* const writer);
+
+// Writes the `key` of the next member of the current object.  `key` is escaped
+// on the way.
+void JSON_WriterKey(JSON_Writer* const writer, const char* const key);
+void JSON_WriterKeyN(JSON_Writer* const writer, const char* const key,
+                     const size_t length);
+
+void JSON_WriterNull(JSON_Writer* const writer);
+void JSON_WriterNumber(JSON_Writer* const writer, const json_number_t number);
+void JSON_WriterDecimal(JSON_Writer* const writer,
+                        const json_decimal_t decimal);
+void JSON_WriterBool(JSON_Writer* const writer, const json_bool_t boolean);
+
+// Writes `string` as a `JSON` string, escaping quotes, back-slashes and control
+// characters on the way.
+void JSON_WriterString(JSON_Writer* const writer, const char* const string);
+void JSON_WriterStringN(JSON_Writer* const writer, const char* const string,
+                        const size_t length);
+
+// Hands whatever is buffered in the writer's `StringStream` to its sink, has no
+// effect on a writer without a sink.
+void JSON_WriterFlush(JSON_Writer* const writer);
+
+// Flushes the writer and returns `TRUE` if exactly one complete top-level value
+// was written without misusing the writer.
+bool_t JSON_WriterFinish(JSON_Writer* const writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CJSON_INCLUDE_WRITER_H_
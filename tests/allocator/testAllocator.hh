@@ -0,0 +1,208 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CJSON_TESTS_ALLOCATOR_TESTALLOCATOR_HH_
+#define CJSON_TESTS_ALLOCATOR_TESTALLOCATOR_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "allocator.h"
+#include "cjson.h"
+#include "data/arena/arena.h"
+#include "data/map/map.h"
+#include "data/map/ops.h"
+#include "data/sstream/sstream.h"
+#include "data/vector/vector.h"
+#include "modifiers.h"
+#include "utils.hh"
+
+TEST(AllocatorTest, TestDefaultAllocatorCanBeReplacedAndRestored) {
+  using namespace cjson::testing::allocator::utils;
+  const Allocator* libc = AllocatorGetDefault();
+  ASSERT_NE(libc, nullptr);
+  Counter counter = {0, 0, 0, 0};
+  Allocator counting = CountingAllocator(&counter);
+  AllocatorSetDefault(&counting);
+  EXPECT_EQ(AllocatorGetDefault(), &counting);
+  char* ptr = (char*)AllocatorCalloc(NULL, 4, 4);
+  ASSERT_NE(ptr, nullptr);
+  for (size_t i = 0; i < 16; ++i)
+    EXPECT_EQ(ptr[i], 0);
+  ptr = (char*)AllocatorRealloc(NULL, ptr, 64);
+  ASSERT_NE(ptr, nullptr);
+  AllocatorFree(NULL, ptr);
+  AllocatorSetDefault(NULL);
+  EXPECT_EQ(AllocatorGetDefault(), libc);
+  EXPECT_EQ(counter.mallocs, 1);
+  EXPECT_EQ(counter.live, 0);
+}
+
+TEST(AllocatorTest, TestContainersUseTheAllocatorTheyWereAllocatedWith) {
+  using namespace cjson::testing::allocator::utils;
+  Counter counter = {0, 0, 0, 0};
+  Allocator counting = CountingAllocator(&counter);
+
+  Vector vector = VectorAllocWithAllocator(2, &counting);
+  EXPECT_EQ(vector.allocator, &counting);
+  int elems[64];
+  for (size_t i = 0; i < 64; ++i)
+    VectorPush(&vector, &elems[i]);
+  EXPECT_EQ(vector.size, 64);
+  EXPECT_EQ(VectorGet(&vector, 63), &elems[63]);
+  VectorFree(&vector);
+  EXPECT_EQ(counter.live, 0);
+
+  const size_t mallocs = counter.mallocs;
+  Map map = MapAllocNBucketsWithAllocator(2, Hash, KeyCmp, &counting);
+  EXPECT_EQ(map.allocator, &counting);
+  char keys[64][4];
+  for (size_t i = 0; i < 64; ++i) {
+    std::snprintf(keys[i], sizeof(keys[i]), "%zu", i);
+    MapPut(&map, keys[i], &elems[i]);
+  }
+  EXPECT_EQ(map.entrieslen, 64);
+  EXPECT_EQ(MapGet(&map, (void*)"42"), &elems[42]);
+  EXPECT_EQ(MapRemove(&map, (void*)"42"), &elems[42]);
+  // The buckets, with the entries stored in them, and the larger ones of every
+  // re-allocation, moved at once as the map never holds more entries than a
+  // migration step.
+  EXPECT_EQ(counter.mallocs - mallocs, 5);
+  MapFree(&map);
+  EXPECT_EQ(counter.live, 0);
+
+  StringStream sstream = StringStreamNAllocWithAllocator(1, &counting);
+  EXPECT_EQ(sstream.allocator, &counting);
+  StringStreamConcat(&sstream, "%s-%d", "allocator", 33);
+  EXPECT_STREQ(StringStreamBegin(&sstream), "allocator-33");
+  StringStreamDealloc(&sstream);
+  EXPECT_EQ(counter.live, 0);
+}
+
+TEST(AllocatorTest, TestJSONNodesUseTheDefaultAllocator) {
+  using namespace cjson::testing::allocator::utils;
+  Counter counter = {0, 0, 0, 0};
+  Allocator counting = CountingAllocator(&counter);
+  AllocatorSetDefault(&counting);
+  JSON list = JSON_INIT_TYPE(List);
+  JSON_LIST_ADD_VAL(Number, &list, 1);
+  JSON_LIST_ADD_VAL(Decimal, &list, 1.5);
+  JSON_LIST_ADD_VAL(String, &list, (json_string_t) "allocated by the hooks");
+  EXPECT_GE(counter.mallocs, 5);
+  JSON_FreeDeep(&list);
+  AllocatorSetDefault(NULL);
+  EXPECT_EQ(counter.live, 0);
+}
+
+TEST(AllocatorTest, TestArenaAllocatorServesContainersOutOfTheArena) {
+  Arena arena = ArenaNAlloc(1024);
+  Allocator allocator = ArenaAllocator(&arena);
+  Vector vector = VectorAllocWithAllocator(1, &allocator);
+  int elems[128];
+  for (size_t i = 0; i < 128; ++i)
+    VectorPush(&vector, &elems[i]);
+  ASSERT_EQ(vector.size, 128);
+  for (size_t i = 0; i < 128; ++i)
+    EXPECT_EQ(VectorGet(&vector, i), &elems[i]);
+  EXPECT_EQ((uintptr_t)vector.data % ARENA_ALIGNMENT, 0);
+  // Freeing through the arena allocator is a no-op, the arena owns the bytes.
+  VectorFree(&vector);
+  EXPECT_NE(arena.blocks, nullptr);
+  ArenaFree(&arena);
+  EXPECT_EQ(arena.blocks, nullptr);
+}
+
+TEST(AllocatorCacheTest, TestReleasedBlocksAreReusedBySize) {
+  AllocatorCacheFlush();
+  void* block = AllocatorCacheMalloc(NULL, 40);
+  ASSERT_NE(block, nullptr);
+  AllocatorCacheFree(NULL, block, 40);
+  EXPECT_EQ(AllocatorCacheSize(), 40);
+  // Sizes rounding up to the same multiple of eight share the free-list.
+  EXPECT_EQ(AllocatorCacheMalloc(NULL, 33), block);
+  EXPECT_EQ(AllocatorCacheSize(), 0);
+  AllocatorCacheFree(NULL, block, 40);
+  void* other = AllocatorCacheMalloc(NULL, 48);
+  EXPECT_NE(other, block);
+  AllocatorCacheFree(NULL, other, 48);
+  EXPECT_EQ(AllocatorCacheSize(), 88);
+  AllocatorCacheFlush();
+  EXPECT_EQ(AllocatorCacheSize(), 0);
+}
+
+TEST(AllocatorCacheTest, TestLargeBlocksAreNotCached) {
+  AllocatorCacheFlush();
+  void* block = AllocatorCacheMalloc(NULL, ALLOCATOR_CACHE_MAX_BLOCK_SIZE + 1);
+  ASSERT_NE(block, nullptr);
+  AllocatorCacheFree(NULL, block, ALLOCATOR_CACHE_MAX_BLOCK_SIZE + 1);
+  EXPECT_EQ(AllocatorCacheSize(), 0);
+}
+
+TEST(AllocatorCacheTest, TestCustomAllocatorsBypassTheCache) {
+  using namespace cjson::testing::allocator::utils;
+  Counter counter = {0, 0, 0, 0};
+  Allocator counting = CountingAllocator(&counter);
+  AllocatorCacheFlush();
+  void* block = AllocatorCacheMalloc(&counting, 32);
+  AllocatorCacheFree(&counting, block, 32);
+  EXPECT_EQ(counter.mallocs, 1);
+  EXPECT_EQ(counter.frees, 1);
+  EXPECT_EQ(AllocatorCacheSize(), 0);
+}
+
+TEST(AllocatorCacheTest, TestFreedTreesAreRecycledWithinTheThread) {
+  AllocatorCacheFlush();
+  JSON list = JSON_INIT_TYPE(List);
+  for (json_number_t i = 0; i < 8; ++i) {
+    JSON* object = JSON_AllocType(JSON_Object);
+    JSON_OBJECT_PUT_VAL(Number, object, strdup("id"), i);
+    JSON_ListAdd(&list, object);
+  }
+  JSON_FreeDeep(&list);
+  const size_t cached = AllocatorCacheSize();
+  EXPECT_GE(cached, 16 * sizeof(JSON));
+
+  // Another thread has a cache of its own.
+  std::thread([] {
+    EXPECT_EQ(AllocatorCacheSize(), 0);
+    AllocatorCacheFree(NULL, AllocatorCacheMalloc(NULL, 64), 64);
+    EXPECT_EQ(AllocatorCacheSize(), 64);
+  }).join();
+  EXPECT_EQ(AllocatorCacheSize(), cached);
+
+  JSON* json = JSON_AllocType(JSON_Null);
+  EXPECT_LT(AllocatorCacheSize(), cached);
+  AllocatorCacheFree(NULL, json, sizeof(JSON));
+  AllocatorCacheFlush();
+}
+
+#endif  // CJSON_TESTS_ALLOCATOR_TESTALLOCATOR_HH_
@@ -0,0 +1,128 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_TESTS_ALLOCATOR_UTILS_HH_
+#define CJSON_TESTS_ALLOCATOR_UTILS_HH_
+
+#include <cstdlib>
+#include <cstring>
+
+#include "allocator.h"
+#include "cjson.h"
+
+namespace cjson {
+namespace testing {
+namespace allocator {
+namespace utils {
+// Counts the calls made through an `Allocator`, and the bytes they requested,
+// while forwarding them to libc.
+struct Counter {
+  std::size_t mallocs;
+  std::size_t frees;
+  std::size_t live;
+  std::size_t bytes;
+};
+
+static void* CountingMalloc(void* ctx, std::size_t size) {
+  Counter* counter = (Counter*)ctx;
+  ++counter->mallocs;
+  ++counter->live;
+  counter->bytes += size;
+  return std::malloc(size);
+}
+
+static void* CountingRealloc(void* ctx, void* ptr, std::size_t size) {
+  Counter* counter = (Counter*)ctx;
+  if (ptr == nullptr) {
+    ++counter->mallocs;
+    ++counter->live;
+  }
+  counter->bytes += size;
+  return std::realloc(ptr, size);
+}
+
+static void CountingFree(void* ctx, void* ptr) {
+  Counter* counter = (Counter*)ctx;
+  if (ptr) {
+    ++counter->frees;
+    --counter->live;
+  }
+  std::free(ptr);
+}
+
+static Allocator CountingAllocator(Counter* const counter) {
+  Allocator allocator = {.malloc = CountingMalloc,
+                         .realloc = CountingRealloc,
+                         .free = CountingFree,
+                         .ctx = counter};
+  return allocator;
+}
+
+// Refuses every request larger than the `size_t` limit at `ctx` and forwards
+// the others to libc.
+static void* LimitedMalloc(void* ctx, std::size_t size) {
+  return size > *(std::size_t*)ctx ? nullptr : std::malloc(size);
+}
+
+static void* LimitedRealloc(void* ctx, void* ptr, std::size_t size) {
+  return size > *(std::size_t*)ctx ? nullptr : std::realloc(ptr, size);
+}
+
+static void LimitedFree(void*, void* ptr) { std::free(ptr); }
+
+static Allocator LimitedAllocator(std::size_t* const limit) {
+  Allocator allocator = {.malloc = LimitedMalloc,
+                         .realloc = LimitedRealloc,
+                         .free = LimitedFree,
+                         .ctx = limit};
+  return allocator;
+}
+
+// Returns a copy of `key` from the process-wide allocator, to be released with
+// the tree it is put in.
+json_string_t Key(const char* const key) {
+  char* copy = (char*)AllocatorMalloc(NULL, std::strlen(key) + 1);
+  std::strcpy(copy, key);
+  return copy;
+}
+
+// Same as `Key()` but copies the `keylen` bytes at `key`, which may hold `NULL`
+// characters, and terminates the copy.
+json_string_t Key(const char* const key, const std::size_t keylen) {
+  char* copy = (char*)AllocatorMalloc(NULL, keylen + 1);
+  std::memcpy(copy, key, keylen);
+  copy[keylen] = '\0';
+  return copy;
+}
+}  // namespace utils
+}  // namespace allocator
+}  // namespace testing
+}  // namespace cjson
+
+#endif  // CJSON_TESTS_ALLOCATOR_UTILS_HH_
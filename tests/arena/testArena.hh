@@ -0,0 +1,100 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CJSON_TESTS_ARENA_TESTARENA_HH_
+#define CJSON_TESTS_ARENA_TESTARENA_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "data/arena/arena.h"
+
+TEST(ArenaMacrosTest, TestMacrosToHaveCorrectValues) {
+  EXPECT_EQ(ARENA_DEFAULT_BLOCK_SIZE, (1 << 16));
+  EXPECT_EQ(ARENA_ALIGNMENT, (1 << 4));
+}
+
+TEST(ArenaAllocTest, TestNoBlockIsAllocatedUpFront) {
+  Arena arena = ArenaAlloc();
+  EXPECT_EQ(arena.blocks, nullptr);
+  EXPECT_EQ(arena.blocksize, ARENA_DEFAULT_BLOCK_SIZE);
+  arena = ArenaNAlloc(100);
+  EXPECT_EQ(arena.blocksize, 112);
+}
+
+TEST(ArenaMallocTest, TestAllocationsAreAlignedAndBumpedOutOfOneBlock) {
+  Arena arena = ArenaNAlloc(1024);
+  char* first = (char*)ArenaMalloc(&arena, 3);
+  char* second = (char*)ArenaMalloc(&arena, 17);
+  char* third = (char*)ArenaMalloc(&arena, 1);
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+  ASSERT_NE(third, nullptr);
+  EXPECT_EQ((uintptr_t)first % ARENA_ALIGNMENT, 0);
+  EXPECT_EQ(second - first, 16);
+  EXPECT_EQ(third - second, 32);
+  EXPECT_EQ(arena.blocks->next, nullptr);
+  EXPECT_EQ(arena.blocks->used, 64);
+  ArenaFree(&arena);
+  EXPECT_EQ(arena.blocks, nullptr);
+}
+
+TEST(ArenaMallocTest, TestLargeAllocationsGetADedicatedBlock) {
+  Arena arena = ArenaNAlloc(1024);
+  ASSERT_NE(ArenaMalloc(&arena, 16), nullptr);
+  ArenaBlock* current = arena.blocks;
+  char* large = (char*)ArenaMalloc(&arena, 4096);
+  ASSERT_NE(large, nullptr);
+  std::memset(large, 0xAB, 4096);
+  // The current block keeps being bumped.
+  EXPECT_EQ(arena.blocks, current);
+  ASSERT_NE(current->next, nullptr);
+  EXPECT_EQ(current->next->size, 4096);
+
+  for (int i = 0; i < 100; ++i)
+    ASSERT_NE(ArenaMalloc(&arena, 200), nullptr);
+  size_t blocks = 0;
+  for (ArenaBlock* block = arena.blocks; block; block = block->next)
+    ++blocks;
+  // Four 208 bytes allocations fit in a block, plus the dedicated block.
+  EXPECT_EQ(blocks, 25 + 1);
+  ArenaFree(&arena);
+}
+
+TEST(ArenaCallocTest, TestBytesAreZeroed) {
+  Arena arena = ArenaNAlloc(64);
+  unsigned char* bytes = (unsigned char*)ArenaCalloc(&arena, 48);
+  ASSERT_NE(bytes, nullptr);
+  for (int i = 0; i < 48; ++i)
+    EXPECT_EQ(bytes[i], 0);
+  ArenaFree(&arena);
+}
+
+#endif  // CJSON_TESTS_ARENA_TESTARENA_HH_
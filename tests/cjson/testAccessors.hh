@@ -35,6 +35,7 @@
 #include "bool.h"
 #include "cjson.h"
 #include "data/sstream/sstream.h"
+#include "modifiers.h"
 
 class CJSONTest : public testing::Test {
  protected:
@@ -84,4 +85,31 @@ TEST_F(CJSONTest, JSONStringifiyTestWithAListAndAObjectInstance) {
   ASSERT_STREQ(json_actual_data.data, json_expected_output);
 }
 
+TEST(JSON_StringifyTest, TestWhenObjectValuesAreStringifiedInTurn) {
+  JSON object = JSON_INIT_TYPE(Object);
+  JSON* const nested = JSON_AllocType(JSON_Object);
+  JSON_OBJECT_PUT(Null, nested, strdup("b"));
+  JSON_ObjectPut(&object, strdup("a"), nested);
+  // The stream holding each stringified value is released once it has been
+  // copied, none of them is left behind.
+  StringStream sstream = JSON_Stringify(&object, FALSE, 0, TRUE);
+  EXPECT_STREQ(sstream.data, "{\"a\":{\"b\":null}}");
+  StringStreamDealloc(&sstream);
+  JSON_FreeDeep(&object);
+}
+
+TEST(JSON_StringifyTest, TestWhenKeysAreNotTerminated) {
+  JSON object = JSON_INIT_TYPE(Object);
+  // The key is exactly `keylen` bytes long, a `NUL` byte included.
+  char* const key = (char*)malloc(3);
+  std::memcpy(key, "k\0y", 3);
+  JSON_ObjectPutN(&object, key, 3, JSON_AllocType(JSON_Null));
+  StringStream sstream = JSON_Stringify(&object, FALSE, 0, TRUE);
+  const char expected[] = "{\"k\0y\":null}";
+  ASSERT_EQ(sstream.length, sizeof(expected) - 1);
+  EXPECT_EQ(std::memcmp(sstream.data, expected, sizeof(expected) - 1), 0);
+  StringStreamDealloc(&sstream);
+  JSON_FreeDeep(&object);
+}
+
 #endif  // CJSON_TESTS_TESTACCESSORS_HH_
@@ -0,0 +1,218 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_TESTS_CJSON_TESTCBOR_HH_
+#define CJSON_TESTS_CJSON_TESTCBOR_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "../allocator/utils.hh"
+#include "bool.h"
+#include "cbor.h"
+#include "cjson.h"
+#include "data/sstream/sstream.h"
+
+namespace cjson {
+namespace testing {
+namespace cbor {
+// Returns the CBOR encoding of `json` as a `std::string` of raw bytes.
+std::string Encode(const JSON& json) {
+  StringStream sstream = StringStreamAlloc();
+  JSON_ToCBOR(&sstream, &json);
+  std::string bytes(sstream.data, sstream.length);
+  StringStreamDealloc(&sstream);
+  return bytes;
+}
+
+// Decodes the raw CBOR `bytes` into `json`.
+bool_t Decode(JSON& json, const std::string& bytes) {
+  StringStream sstream = StringStreamStrNAlloc(bytes.data(), bytes.size());
+  bool_t decoded = JSON_FromCBOR(&json, &sstream);
+  StringStreamDealloc(&sstream);
+  return decoded;
+}
+}  // namespace cbor
+}  // namespace testing
+}  // namespace cjson
+
+TEST(JSON_ToCBORTest, EncodesScalarsInTheSmallestWidth) {
+  using cjson::testing::cbor::Encode;
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, 0)), std::string("\x00", 1));
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, 23)), "\x17");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, 24)), "\x18\x18");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, 1000)), "\x19\x03\xe8");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, -1)), "\x20");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, -1000)), "\x39\x03\xe7");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, INT64_MIN)),
+            "\x3b\x7f\xff\xff\xff\xff\xff\xff\xff");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Decimal, 1.5)),
+            std::string("\xfa\x3f\xc0\x00\x00", 5));
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Decimal, 1.1)),
+            "\xfb\x3f\xf1\x99\x99\x99\x99\x99\x9a");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Bool, TRUE)), "\xf5");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Bool, FALSE)), "\xf4");
+  EXPECT_EQ(Encode(JSON_INIT(Null)), "\xf6");
+
+  JSON string = JSON_INIT_VAL(String, JSON_CONST_STRINGIFY("IETF"));
+  EXPECT_EQ(Encode(string), "\x64IETF");
+  JSON_Free(&string);
+}
+
+TEST(JSON_ToCBORTest, EncodesContainersWithDefiniteLengths) {
+  JSON list = JSON_INIT_TYPE(List);
+  JSON_LIST_ADD_VAL(Number, &list, 1);
+  JSON* nested = JSON_AllocType(JSON_List);
+  JSON_LIST_ADD_VAL(Number, nested, 2);
+  JSON_LIST_ADD_VAL(Number, nested, 3);
+  JSON_ListAdd(&list, nested);
+  EXPECT_EQ(cjson::testing::cbor::Encode(list), "\x82\x01\x82\x02\x03");
+  JSON_FreeDeep(&list);
+
+  JSON object = JSON_INIT_TYPE(Object);
+  JSON_OBJECT_PUT_VAL(Number, &object, strdup("a"), 1);
+  EXPECT_EQ(cjson::testing::cbor::Encode(object), "\xa1\x61\x61\x01");
+  JSON_FreeDeep(&object);
+}
+
+TEST(JSON_ToCBORTest, EncodesListsStoredByValue) {
+  JSON list = JSON_InitValueListImpl(0);
+  JSON_LIST_ADD_VAL(Number, &list, 1);
+  JSON_LIST_ADD_VAL(String, &list, JSON_STRINGIFY("IETF"));
+  EXPECT_EQ(cjson::testing::cbor::Encode(list), "\x82\x01\x64IETF");
+  JSON_FreeDeep(&list);
+}
+
+TEST(JSON_ToCBORTest, FailsWhenTheStreamCanNotGrow) {
+  std::size_t limit = 64;
+  const Allocator limited =
+      cjson::testing::allocator::utils::LimitedAllocator(&limit);
+  StringStream sstream = StringStreamNAllocWithAllocator(16, &limited);
+  std::string text(200, 'a');
+  JSON string = JSON_InitStringViewImpl(&text[0], text.size());
+  EXPECT_EQ(JSON_ToCBOR(&sstream, &string), FALSE);
+  EXPECT_LE(sstream.length, sstream.capacity);
+  StringStreamDealloc(&sstream);
+}
+
+TEST(JSON_FromCBORTest, DecodesNestedDocuments) {
+  JSON json;
+  const std::string bytes(
+      "\xa2\x61\x61\x82\x01\xf9\x3c\x00\x63key\x64IETF", 17);
+  ASSERT_EQ(cjson::testing::cbor::Decode(json, bytes), TRUE);
+  ASSERT_EQ(json.type, JSON_Object);
+  EXPECT_EQ(json.value.object.entrieslen, 2);
+
+  JSON* list = (JSON*)MapGet(&json.value.object, (void*)"a");
+  ASSERT_NE(list, nullptr);
+  ASSERT_EQ(list->type, JSON_List);
+  ASSERT_EQ(list->value.list.size, 2);
+  EXPECT_EQ(((const JSON*)VectorGet(&list->value.list, 0))->value.number, 1);
+  EXPECT_EQ(((const JSON*)VectorGet(&list->value.list, 1))->value.decimal,
+            1.0);
+
+  JSON* string = (JSON*)MapGet(&json.value.object, (void*)"key");
+  ASSERT_NE(string, nullptr);
+  ASSERT_EQ(string->type, JSON_String);
+  EXPECT_STREQ(JSON_StringData(string), "IETF");
+  JSON_FreeDeep(&json);
+}
+
+TEST(JSON_FromCBORTest, DecodesWhatWasEncoded) {
+  JSON json;
+  const std::string bytes =
+      "\x83\x3b\x7f\xff\xff\xff\xff\xff\xff\xff\xfb\x3f\xf1\x99\x99\x99\x99"
+      "\x99\x9a\xa1\x61\x61\xf6";
+  ASSERT_EQ(cjson::testing::cbor::Decode(json, bytes), TRUE);
+  EXPECT_EQ(cjson::testing::cbor::Encode(json), bytes);
+  JSON_FreeDeep(&json);
+}
+
+TEST(JSON_FromCBORTest, KeepsKeysHoldingNulCharacters) {
+  JSON json;
+  const std::string bytes("\xa2\x63k\x00" "a\x01\x63k\x00" "b\x02", 11);
+  ASSERT_EQ(cjson::testing::cbor::Decode(json, bytes), TRUE);
+  ASSERT_EQ(json.value.object.entrieslen, 2);
+  const JSON* const a =
+      (const JSON*)MapGetN(&json.value.object, (void*)"k\0a", 3);
+  ASSERT_NE(a, nullptr);
+  EXPECT_EQ(a->value.number, 1);
+  EXPECT_EQ(MapGet(&json.value.object, (void*)"k"), nullptr);
+  JSON_FreeDeep(&json);
+}
+
+TEST(JSON_FromCBORTest, KeepsTheOrderOfObjectKeys) {
+  // Twenty keys in reverse order grow the object past its first buckets.
+  std::string bytes = "\xb4";
+  for (char key = 't'; key >= 'a'; --key)
+    bytes += std::string("\x61") + key + '\x01';
+  JSON json;
+  ASSERT_EQ(cjson::testing::cbor::Decode(json, bytes), TRUE);
+  EXPECT_EQ(cjson::testing::cbor::Encode(json), bytes);
+  JSON_FreeDeep(&json);
+}
+
+TEST(JSON_FromCBORTest, SkipsTags) {
+  JSON json;
+  ASSERT_EQ(cjson::testing::cbor::Decode(json, "\xc1\x1a\x51\x4b\x67\xb0"),
+            TRUE);
+  ASSERT_EQ(json.type, JSON_Number);
+  EXPECT_EQ(json.value.number, 1363896240);
+}
+
+TEST(JSON_FromCBORTest, RejectsMalformedInput) {
+  JSON json;
+  // Truncated argument.
+  EXPECT_EQ(cjson::testing::cbor::Decode(json, "\x19\x03"), FALSE);
+  EXPECT_EQ(json.type, JSON_Null);
+  // Trailing bytes.
+  EXPECT_EQ(cjson::testing::cbor::Decode(json, std::string("\x00\x00", 2)),
+            FALSE);
+  // Indefinite length list.
+  EXPECT_EQ(cjson::testing::cbor::Decode(json, "\x9f\x01\xff"), FALSE);
+  // Byte string.
+  EXPECT_EQ(cjson::testing::cbor::Decode(json, "\x41\x01"), FALSE);
+  // Duplicate and non-string keys.
+  EXPECT_EQ(cjson::testing::cbor::Decode(json, "\xa2\x61\x61\x01\x61\x61\x02"),
+            FALSE);
+  EXPECT_EQ(cjson::testing::cbor::Decode(json, "\xa1\x01\x02"), FALSE);
+  // A list claiming more items than there are bytes.
+  EXPECT_EQ(cjson::testing::cbor::Decode(json, "\x9a\xff\xff\xff\xff\x01"),
+            FALSE);
+  // Nesting deeper than `JSON_CBOR_MAX_DEPTH`.
+  EXPECT_EQ(cjson::testing::cbor::Decode(
+                json, std::string(JSON_CBOR_MAX_DEPTH + 1, '\x81') + "\x01"),
+            FALSE);
+  EXPECT_EQ(json.type, JSON_Null);
+}
+
+#endif  // CJSON_TESTS_CJSON_TESTCBOR_HH_
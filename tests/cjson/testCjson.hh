@@ -33,14 +33,17 @@
 #include <gtest/gtest.h>
 
 #include <cstdio>
+#include <cstring>
 #include <limits>
 
 #include "../vector/utils.hh"
+#include "allocator.h"
 #include "bool.h"
 #include "bytes.h"
 #include "cjson.h"
 #include "data/map/map.h"
 #include "data/vector/vector.h"
+#include "modifiers.h"
 
 TEST(JSON_InitTypeTest, TestWhenJSON_NullIsUsed) {
   JSON json = JSON_INIT_TYPE(Null);
@@ -69,7 +72,10 @@ TEST(JSON_InitTypeTest, TestWhenJSON_DecimalIsUsed) {
 TEST(JSON_InitTypeTest, TestWhenJSON_StringIsUsed) {
   JSON json = JSON_INIT_TYPE(String);
   EXPECT_EQ(json.type, JSON_String);
-  EXPECT_EQ(*json.value.string, '\0');
+  EXPECT_STREQ(JSON_StringData(&json), "");
+  EXPECT_EQ(JSON_StringLength(&json), 0);
+  // The empty string is inline, releasing it must not free a literal.
+  JSON_Free(&json);
 }
 
 TEST(JSON_InitTypeTest, TestWhenJSON_ListIsUsedWithNoCapacityGiven) {
@@ -80,6 +86,7 @@ TEST(JSON_InitTypeTest, TestWhenJSON_ListIsUsedWithNoCapacityGiven) {
   size_t capacity;
   cjson::testing::vector::utils::ComputeVectorBufferCapacity(0, capacity);
   EXPECT_EQ(json.value.list.capacity, capacity);
+  JSON_Free(&json);
 }
 
 TEST(JSON_InitTypeTest, TestWhenJSON_ListIsUsedWithCapacityGiven) {
@@ -90,6 +97,7 @@ TEST(JSON_InitTypeTest, TestWhenJSON_ListIsUsedWithCapacityGiven) {
   size_t capacity;
   cjson::testing::vector::utils::ComputeVectorBufferCapacity(10, capacity);
   EXPECT_EQ(json.value.list.capacity, capacity);
+  JSON_Free(&json);
 }
 
 TEST(JSON_InitTypeTest, TestWhenJSON_ObjectIsUsedWithNoEntriesGiven) {
@@ -100,16 +108,18 @@ TEST(JSON_InitTypeTest, TestWhenJSON_ObjectIsUsedWithNoEntriesGiven) {
   EXPECT_EQ(json.value.object.entrieslen, 0);
   EXPECT_EQ(json.value.object.hash, Hash);
   EXPECT_EQ(json.value.object.keycmp, KeyCmp);
+  JSON_Free(&json);
 }
 
 TEST(JSON_InitTypeTest, TestWhenJSON_ObjectIsUsedWhenLessEntriesAreGiven) {
   JSON json = JSON_INIT_TYPE_SIZE(Object, 10);
   EXPECT_EQ(json.type, JSON_Object);
   EXPECT_NE(json.value.object.buckets, nullptr);
-  EXPECT_EQ(json.value.object.bucketslen, MAP_DEFAULT_BUCKET_LEN);
+  EXPECT_EQ(json.value.object.bucketslen, MapComputeBucketsLen(10));
   EXPECT_EQ(json.value.object.entrieslen, 0);
   EXPECT_EQ(json.value.object.hash, Hash);
   EXPECT_EQ(json.value.object.keycmp, KeyCmp);
+  JSON_Free(&json);
 }
 
 TEST(JSON_InitTypeTest, TestWhenJSON_ObjectIsUsedWhenHighEntriesAreGiven) {
@@ -120,6 +130,7 @@ TEST(JSON_InitTypeTest, TestWhenJSON_ObjectIsUsedWhenHighEntriesAreGiven) {
   EXPECT_EQ(json.value.object.entrieslen, 0);
   EXPECT_EQ(json.value.object.hash, Hash);
   EXPECT_EQ(json.value.object.keycmp, KeyCmp);
+  JSON_Free(&json);
 }
 
 TEST(JSON_InitTypeSizeTest, TestWhenJSON_NullIsUsed) {
@@ -149,7 +160,9 @@ TEST(JSON_InitTypeSizeTest, TestWhenJSON_DecimalIsUsed) {
 TEST(JSON_InitTypeSizeTest, TestWhenJSON_StringIsUsed) {
   JSON json = JSON_INIT_TYPE_SIZE(String, 0);
   EXPECT_EQ(json.type, JSON_String);
-  EXPECT_EQ(*json.value.string, '\0');
+  EXPECT_STREQ(JSON_StringData(&json), "");
+  EXPECT_EQ(JSON_StringLength(&json), 0);
+  JSON_Free(&json);
 }
 
 TEST(JSON_InitTypeSizeTest, TestWhenJSON_ListIsUsedWhenCapacityZeroIsGiven) {
@@ -160,6 +173,7 @@ TEST(JSON_InitTypeSizeTest, TestWhenJSON_ListIsUsedWhenCapacityZeroIsGiven) {
   size_t capacity;
   cjson::testing::vector::utils::ComputeVectorBufferCapacity(0, capacity);
   EXPECT_EQ(json.value.list.capacity, capacity);
+  JSON_Free(&json);
 }
 
 TEST(JSON_InitTypeSizeTest, TestWhenJSON_ListIsUsedWhenCapacityTenIsGiven) {
@@ -170,6 +184,7 @@ TEST(JSON_InitTypeSizeTest, TestWhenJSON_ListIsUsedWhenCapacityTenIsGiven) {
   size_t capacity;
   cjson::testing::vector::utils::ComputeVectorBufferCapacity(10, capacity);
   EXPECT_EQ(json.value.list.capacity, capacity);
+  JSON_Free(&json);
 }
 
 TEST(JSON_InitTypeSizeTest, TestWhenJSON_ObjectIsUsedWhenZeroEntriesAreGiven) {
@@ -180,16 +195,18 @@ TEST(JSON_InitTypeSizeTest, TestWhenJSON_ObjectIsUsedWhenZeroEntriesAreGiven) {
   EXPECT_EQ(json.value.object.entrieslen, 0);
   EXPECT_EQ(json.value.object.hash, Hash);
   EXPECT_EQ(json.value.object.keycmp, KeyCmp);
+  JSON_Free(&json);
 }
 
 TEST(JSON_InitTypeSizeTest, TestWhenJSON_ObjectIsUsedWhenTenEntriesAreGiven) {
   JSON json = JSON_INIT_TYPE_SIZE(Object, 10);
   EXPECT_EQ(json.type, JSON_Object);
   EXPECT_NE(json.value.object.buckets, nullptr);
-  EXPECT_EQ(json.value.object.bucketslen, MAP_DEFAULT_BUCKET_LEN);
+  EXPECT_EQ(json.value.object.bucketslen, MapComputeBucketsLen(10));
   EXPECT_EQ(json.value.object.entrieslen, 0);
   EXPECT_EQ(json.value.object.hash, Hash);
   EXPECT_EQ(json.value.object.keycmp, KeyCmp);
+  JSON_Free(&json);
 }
 
 TEST(JSON_InitTypeSizeTest, TestWhenJSON_ObjectIsUsedWhenHighEntriesAreGiven) {
@@ -200,6 +217,7 @@ TEST(JSON_InitTypeSizeTest, TestWhenJSON_ObjectIsUsedWhenHighEntriesAreGiven) {
   EXPECT_EQ(json.value.object.entrieslen, 0);
   EXPECT_EQ(json.value.object.hash, Hash);
   EXPECT_EQ(json.value.object.keycmp, KeyCmp);
+  JSON_Free(&json);
 }
 
 TEST(JSON_InitNullImplTest, TestFunctionJSON_InitNullImpl) {
@@ -211,13 +229,55 @@ TEST(JSON_InitNullImplTest, TestFunctionJSON_InitNullImpl) {
 TEST(JSON_InitStringImplTest, TestWhenStringIsEmpty) {
   JSON json = JSON_InitStringImpl(JSON_CONST_STRINGIFY(""));
   EXPECT_EQ(json.type, JSON_String);
-  EXPECT_EQ(*json.value.string, '\0');
+  EXPECT_EQ(*JSON_StringData(&json), '\0');
+  EXPECT_EQ(JSON_StringLength(&json), 0);
 }
 
 TEST(JSON_InitStringImplTest, TestWhenStringIsNotEmpty) {
   JSON json = JSON_InitStringImpl(JSON_CONST_STRINGIFY("foo"));
   EXPECT_EQ(json.type, JSON_String);
-  EXPECT_STREQ(json.value.string, "foo");
+  EXPECT_STREQ(JSON_StringData(&json), "foo");
+  JSON_Free(&json);
+}
+
+TEST(JSON_InitStringImplTest, TestWhenStringIsShortItIsStoredInline) {
+  EXPECT_EQ(JSON_SHORT_STRING_CAPACITY, 15);
+  JSON json = JSON_InitStringImpl(JSON_CONST_STRINGIFY("fifteen-chars!!"));
+  EXPECT_TRUE(json.flags & JSON_FLAG_STRING_INLINE);
+  EXPECT_EQ(json.length, 15);
+  EXPECT_EQ(JSON_StringData(&json), json.value.shortstr);
+  EXPECT_STREQ(JSON_StringData(&json), "fifteen-chars!!");
+  EXPECT_EQ(JSON_StringLength(&json), 15);
+  // Copies carry their own characters.
+  JSON copy = json;
+  EXPECT_STREQ(JSON_StringData(&copy), "fifteen-chars!!");
+  EXPECT_NE(JSON_StringData(&copy), JSON_StringData(&json));
+  JSON_Free(&json);
+  JSON_Free(&copy);
+}
+
+TEST(JSON_InitStringImplTest, TestWhenStringIsLongItIsStoredInTheFreeStore) {
+  JSON json = JSON_InitStringImpl(JSON_CONST_STRINGIFY("sixteen-chars!!!"));
+  EXPECT_FALSE(json.flags & JSON_FLAG_STRING_INLINE);
+  EXPECT_STREQ(json.value.string, "sixteen-chars!!!");
+  EXPECT_EQ(JSON_StringLength(&json), 16);
+  JSON_Free(&json);
+}
+
+TEST(JSON_InitStringImplTest, TestInlineStringsAreStringified) {
+  JSON list = JSON_INIT_TYPE(List);
+  JSON_LIST_ADD_VAL(String, &list, JSON_STRINGIFY("GET"));
+  JSON_LIST_ADD_VAL(String, &list, JSON_STRINGIFY("a longer string value"));
+  StringStream sstream = JSON_Stringify(&list, FALSE, 0, TRUE);
+  EXPECT_STREQ(sstream.data, "[\"GET\",\"a longer string value\"]");
+  StringStreamDealloc(&sstream);
+  JSON_FreeDeep(&list);
+}
+
+TEST(JSON_InitStringNImplTest, TestOnlyLengthBytesAreCopied) {
+  JSON json = JSON_InitStringNImpl(JSON_STRINGIFY("US-ASCII"), 2);
+  EXPECT_STREQ(JSON_StringData(&json), "US");
+  EXPECT_EQ(JSON_StringLength(&json), 2);
 }
 
 TEST(JSON_InitNumberImplTest, TestWhenINT64_MINIsUsed) {
@@ -264,6 +324,7 @@ TEST(JSON_InitListImplTest, TestWhenNullIsGiven) {
   size_t capacity;
   cjson::testing::vector::utils::ComputeVectorBufferCapacity(0, capacity);
   EXPECT_EQ(json.value.list.capacity, capacity);
+  JSON_Free(&json);
 }
 
 TEST(JSON_InitListImplTest, TestWhenAEmptyVectorInstanceIsGiven) {
@@ -275,6 +336,8 @@ TEST(JSON_InitListImplTest, TestWhenAEmptyVectorInstanceIsGiven) {
   size_t capacity;
   cjson::testing::vector::utils::ComputeVectorBufferCapacity(0, capacity);
   EXPECT_EQ(json.value.list.capacity, capacity);
+  VectorFree(&json.value.list);
+  VectorFree(&vec);
 }
 
 TEST(JSON_InitListImplTest, TestWhenAVectorInstanceIsGiven) {
@@ -298,6 +361,99 @@ TEST(JSON_InitListImplTest, TestWhenAVectorInstanceIsGiven) {
   size_t capacity;
   cjson::testing::vector::utils::ComputeVectorBufferCapacity(0, capacity);
   EXPECT_EQ(json.value.list.capacity, capacity);
+  VectorFree(&json.value.list);
+  VectorFree(&vec);
+}
+
+TEST(JSON_FreeDeepTest, TestWhenAnObjectHoldsNestedValues) {
+  JSON object = JSON_INIT_TYPE(Object);
+  JSON* list = (JSON*)malloc(sizeof(JSON));
+  *list = JSON_INIT_TYPE(List);
+  JSON_LIST_ADD_VAL(Number, list, 1);
+  JSON_ObjectPut(&object, strdup("list"), list);
+  JSON_OBJECT_PUT_VAL(Number, &object, strdup("number"), 2);
+  // The values of the entries are freed, not the entries themselves.
+  JSON_FreeDeep(&object);
+  EXPECT_EQ(object.value.object.bucketslen, 0);
+  EXPECT_EQ(object.value.object.entrieslen, 0);
+}
+
+TEST(JSON_InitValueListImplTest, TestElementsAreStoredContiguously) {
+  JSON list = JSON_InitValueListImpl(0);
+  EXPECT_EQ(list.type, JSON_List);
+  EXPECT_TRUE(list.flags & JSON_FLAG_LIST_VALUES);
+  EXPECT_EQ(JSON_ListSize(&list), 0);
+  EXPECT_EQ(JSON_ListGet(&list, 0), nullptr);
+  for (json_number_t i = 0; i < 100; ++i)
+    JSON_LIST_ADD_VAL(Number, &list, i);
+  ASSERT_EQ(JSON_ListSize(&list), 100);
+  for (size_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(JSON_ListGet(&list, i), list.value.values.data + i);
+    EXPECT_EQ(JSON_ListGet(&list, i)->value.number, (json_number_t)i);
+  }
+  EXPECT_EQ(JSON_ListGet(&list, 100), nullptr);
+  JSON_FreeDeep(&list);
+  EXPECT_EQ(list.value.values.data, nullptr);
+  EXPECT_EQ(JSON_ListSize(&list), 0);
+}
+
+TEST(JSON_InitValueListImplTest, TestListAddMovesTheValueIntoTheList) {
+  JSON list = JSON_InitValueListImpl(1);
+  JSON* const nested = JSON_AllocType(JSON_List);
+  JSON_LIST_ADD_VAL(String, nested, JSON_STRINGIFY("a longer string value"));
+  JSON_ListAdd(&list, nested);
+  JSON string = JSON_INIT_VAL(String, JSON_STRINGIFY("another long string"));
+  JSON_ListAppend(&list, &string);
+  JSON_LIST_ADD(Null, &list);
+  ASSERT_EQ(JSON_ListSize(&list), 3);
+  EXPECT_EQ(JSON_ListSize(JSON_ListGet(&list, 0)), 1);
+  StringStream sstream = JSON_Stringify(&list, FALSE, 0, TRUE);
+  EXPECT_STREQ(sstream.data,
+               "[[\"a longer string value\"],\"another long string\",null]");
+  StringStreamDealloc(&sstream);
+  JSON_FreeDeep(&list);
+}
+
+TEST(JSON_FreeDeepTest, TestDeeplyNestedTreesDoNotExhaustTheCallStack) {
+  // Deep enough to overflow the call stack if freeing recursed per level.
+  JSON root = JSON_INIT_TYPE(List);
+  JSON* parent = &root;
+  for (size_t depth = 0; depth < 1000000; ++depth) {
+    JSON* child = (JSON*)malloc(sizeof(JSON));
+    if (depth % 3 == 0) {
+      *child = JSON_INIT_TYPE(Object);
+      JSON_ListAdd(parent, child);
+      JSON* list = (JSON*)malloc(sizeof(JSON));
+      *list = JSON_INIT_TYPE(List);
+      JSON_ObjectPut(child, strdup("next"), list);
+      child = list;
+    } else {
+      *child = JSON_INIT_TYPE(List);
+      JSON_ListAdd(parent, child);
+    }
+    JSON_LIST_ADD_VAL(String, child, JSON_STRINGIFY("a string that is long"));
+    parent = child;
+  }
+  JSON_FreeDeep(&root);
+  EXPECT_EQ(root.value.list.size, 0);
+  EXPECT_EQ(root.value.list.data, nullptr);
+}
+
+TEST(JSON_FreeTest, TestChildNodesAreLeftToTheCaller) {
+  JSON root = JSON_InitValueListImpl(0);
+  JSON child = JSON_INIT_TYPE(List);
+  JSON grandchild = JSON_INIT_TYPE(List);
+  JSON_LIST_ADD_VAL(Number, &grandchild, 1);
+  JSON* number = JSON_ListGet(&grandchild, 0);
+  JSON_ListAdd(&child, &grandchild);
+  JSON_ListAppend(&root, &child);
+  JSON_Free(&root);
+  EXPECT_EQ(JSON_ListSize(&root), 0);
+  // What the nodes below hold is released, the nodes are left alone.
+  EXPECT_EQ(grandchild.type, JSON_List);
+  EXPECT_EQ(grandchild.value.list.data, nullptr);
+  EXPECT_EQ(number->type, JSON_Number);
+  AllocatorCacheFree(NULL, number, sizeof(JSON));
 }
 
 #endif
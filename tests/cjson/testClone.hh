@@ -0,0 +1,134 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CJSON_TESTS_CJSON_TESTCLONE_HH_
+#define CJSON_TESTS_CJSON_TESTCLONE_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "../allocator/utils.hh"
+#include "accessors.h"
+#include "allocator.h"
+#include "bool.h"
+#include "cjson.h"
+#include "clone.h"
+#include "modifiers.h"
+#include "ref.h"
+
+namespace cjson {
+namespace testing {
+namespace clone {
+// Returns the compact text of `json`.
+std::string Text(JSON* const json) {
+  StringStream sstream = JSON_Stringify(json, FALSE, 0, TRUE);
+  std::string text(sstream.data, sstream.length);
+  StringStreamDealloc(&sstream);
+  return text;
+}
+}  // namespace clone
+}  // namespace testing
+}  // namespace cjson
+
+TEST(JSON_CloneTest, CopiesEveryKindOfNode) {
+  static const char kView[] = "a string viewed rather than owned";
+  JSON list = JSON_InitValueListImpl(0);
+  JSON_LIST_ADD_VAL(Number, &list, 1);
+  JSON_LIST_ADD_VAL(String, &list, JSON_STRINGIFY("two"));
+  JSON_LIST_ADD(Null, &list);
+  JSON shared = JSON_INIT_TYPE(List);
+  JSON_LIST_ADD_VAL(Bool, &shared, TRUE);
+  JSON_Ref ref = JSON_RefNew(&shared);
+
+  JSON root = JSON_INIT_TYPE(Object);
+  JSON_OBJECT_PUT_VAL(String, &root, strdup("name"),
+                      JSON_STRINGIFY("a name longer than sixteen bytes"));
+  JSON_OBJECT_PUT_VAL(Decimal, &root, strdup("ratio"), 0.5);
+  JSON* view = JSON_AllocType(JSON_Null);
+  *view = JSON_InitStringViewImpl((json_string_t)kView, std::strlen(kView));
+  JSON_ObjectPut(&root, strdup("view"), view);
+  JSON* values = JSON_AllocType(JSON_Null);
+  *values = list;
+  JSON_ObjectPut(&root, strdup("values"), values);
+  JSON_ObjectPut(&root, strdup("shared"), JSON_RefAttach(ref));
+
+  const std::string text = cjson::testing::clone::Text(&root);
+  JSON* clone = JSON_Clone(&root);
+  ASSERT_NE(clone, nullptr);
+  JSON_FreeDeep(&root);
+  JSON_RefRelease(&ref);
+
+  EXPECT_EQ(cjson::testing::clone::Text(clone), text);
+  const JSON* cloned_view =
+      (const JSON*)MapGet(&clone->value.object, (void*)"view");
+  EXPECT_FALSE(cloned_view->flags & JSON_FLAG_STRING_VIEW);
+  EXPECT_NE(JSON_StringData(cloned_view), kView);
+  const JSON* cloned_shared =
+      (const JSON*)MapGet(&clone->value.object, (void*)"shared");
+  EXPECT_FALSE(cloned_shared->flags & JSON_FLAG_SHARED);
+  JSON_CloneFree(clone);
+}
+
+TEST(JSON_CloneTest, AllocatesOneBlock) {
+  JSON root = JSON_INIT_TYPE(List);
+  for (int i = 0; i < 100; ++i) {
+    JSON* object = JSON_AllocType(JSON_Object);
+    for (int j = 0; j < 10; ++j) {
+      const std::string key = "key" + std::to_string(j);
+      JSON_OBJECT_PUT_VAL(Number, object, strdup(key.c_str()), i * j);
+    }
+    JSON_ListAdd(&root, object);
+  }
+
+  using namespace cjson::testing::allocator::utils;
+  Counter counter = {0, 0, 0, 0};
+  Allocator counting = CountingAllocator(&counter);
+  AllocatorSetDefault(&counting);
+  JSON* clone = JSON_Clone(&root);
+  EXPECT_EQ(counter.mallocs, 1);
+  JSON_CloneFree(clone);
+  EXPECT_EQ(counter.frees, 1);
+  AllocatorSetDefault(NULL);
+
+  clone = JSON_Clone(&root);
+  ASSERT_EQ(JSON_ListSize(clone), 100);
+  const Map* object = &JSON_ListGet(clone, 99)->value.object;
+  EXPECT_EQ(object->entrieslen, 10);
+  EXPECT_EQ(object->bucketslen, MapComputeBucketsLen(10));
+  const JSON* value = (const JSON*)MapGet((Map*)object, (void*)"key7");
+  ASSERT_NE(value, nullptr);
+  EXPECT_EQ(value->value.number, 99 * 7);
+  EXPECT_EQ(cjson::testing::clone::Text(clone),
+            cjson::testing::clone::Text(&root));
+  JSON_CloneFree(clone);
+  JSON_FreeDeep(&root);
+}
+
+#endif  // CJSON_TESTS_CJSON_TESTCLONE_HH_
@@ -0,0 +1,198 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CJSON_TESTS_CJSON_TESTCOLUMNS_HH_
+#define CJSON_TESTS_CJSON_TESTCOLUMNS_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "../allocator/utils.hh"
+#include "bool.h"
+#include "cbor.h"
+#include "cjson.h"
+#include "columns.h"
+#include "data/map/map.h"
+#include "data/sstream/sstream.h"
+#include "utils.hh"
+
+namespace cjson {
+namespace testing {
+namespace columns {
+using allocator::utils::Key;
+
+// Puts `{"id": i, "score": i / 2, "name": "row<i>", "ok": i is even}` into
+// `record`, leaving every third `score` null and every fourth `name` out.
+void Fields(JSON* const record, const size_t i) {
+  JSON_OBJECT_PUT_VAL(Number, record, Key("id"), (json_number_t)i);
+  if (i % 3 == 0)
+    JSON_OBJECT_PUT(Null, record, Key("score"));
+  else
+    JSON_OBJECT_PUT_VAL(Decimal, record, Key("score"), i / 2.0);
+  if (i % 4 != 0)
+    JSON_OBJECT_PUT_VAL(String, record, Key("name"),
+                        (json_string_t)("row" + std::to_string(i)).c_str());
+  JSON_OBJECT_PUT_VAL(Bool, record, Key("ok"), i % 2 == 0);
+}
+
+// Returns a list of `rows` records shaped by `Fields()`.
+JSON Records(const size_t rows) { return cjson::utils::Records(rows, Fields); }
+
+// Puts `{"k\0a": i, "k\0b": -i}` into `record`, two keys that only differ
+// after a `NULL` character.
+void NullCharacterFields(JSON* const record, const size_t i) {
+  const char* const keys[] = {"k\0a", "k\0b"};
+  for (size_t k = 0; k < 2; ++k) {
+    JSON* value = JSON_AllocType(JSON_Number);
+    value->value.number = k ? -(json_number_t)i : (json_number_t)i;
+    JSON_ObjectPutN(record, Key(keys[k], 3), 3, value);
+  }
+}
+}  // namespace columns
+}  // namespace testing
+}  // namespace cjson
+
+TEST(JSON_ColumnsTest, ShredsRecordsIntoTypedColumns) {
+  JSON list = cjson::testing::columns::Records(10);
+  JSON_Columns columns;
+  ASSERT_EQ(JSON_ColumnsFromList(&columns, &list), TRUE);
+  EXPECT_EQ(columns.rows, 10);
+  EXPECT_EQ(columns.ncolumns, 4);
+
+  const JSON_Column* id = JSON_ColumnsFind(&columns, "id");
+  ASSERT_NE(id, nullptr);
+  ASSERT_EQ(id->type, JSON_Number);
+  json_number_t sum = 0;
+  for (size_t row = 0; row < columns.rows; ++row)
+    sum += id->values.numbers[row];
+  EXPECT_EQ(sum, 45);
+
+  const JSON_Column* score = JSON_ColumnsFind(&columns, "score");
+  ASSERT_NE(score, nullptr);
+  ASSERT_EQ(score->type, JSON_Decimal);
+  EXPECT_EQ(JSON_ColumnIsNull(score, 3), TRUE);
+  EXPECT_EQ(JSON_ColumnIsNull(score, 5), FALSE);
+  EXPECT_EQ(score->values.decimals[5], 2.5);
+
+  const JSON_Column* name = JSON_ColumnsFind(&columns, "name");
+  ASSERT_NE(name, nullptr);
+  ASSERT_EQ(name->type, JSON_String);
+  EXPECT_EQ(JSON_ColumnIsNull(name, 4), TRUE);
+  const u_int64_t* offsets = name->values.strings.offsets;
+  EXPECT_EQ(std::string(name->values.strings.chars + offsets[5],
+                        offsets[6] - offsets[5]),
+            "row5");
+
+  const JSON_Column* ok = JSON_ColumnsFind(&columns, "ok");
+  ASSERT_NE(ok, nullptr);
+  ASSERT_EQ(ok->type, JSON_Boolean);
+  EXPECT_EQ(ok->values.booleans[2], 1);
+  EXPECT_EQ(ok->values.booleans[3], 0);
+
+  EXPECT_EQ(JSON_ColumnsFind(&columns, "missing"), nullptr);
+  JSON_ColumnsFree(&columns);
+  JSON_FreeDeep(&list);
+}
+
+TEST(JSON_ColumnsTest, ConvertsBackToTheSameRecords) {
+  JSON list = cjson::testing::columns::Records(25);
+  JSON_Columns columns;
+  ASSERT_EQ(JSON_ColumnsFromList(&columns, &list), TRUE);
+  JSON rebuilt;
+  ASSERT_EQ(JSON_ColumnsToList(&rebuilt, &columns), TRUE);
+  ASSERT_EQ(rebuilt.type, JSON_List);
+  ASSERT_EQ(rebuilt.value.list.size, 25);
+  for (size_t row = 0; row < 25; ++row) {
+    JSON* original = (JSON*)VectorGet(&list.value.list, row);
+    JSON* record = (JSON*)VectorGet(&rebuilt.value.list, row);
+    // The columns are rebuilt in the order they were first seen, which is not
+    // the order every record was built in, so the fields are compared by key.
+    ASSERT_EQ(record->value.object.entrieslen,
+              original->value.object.entrieslen);
+    MapEntry* current = NULL;
+    MapIterator original_it = MapIteratorNew(&original->value.object);
+    while ((current = MapIteratorNext(&original_it))) {
+      JSON* field = (JSON*)MapGet(&record->value.object, current->key);
+      ASSERT_NE(field, nullptr) << (const char*)current->key;
+      EXPECT_EQ(cjson::testing::cbor::Encode(*field),
+                cjson::testing::cbor::Encode(*(JSON*)current->value));
+    }
+  }
+  JSON_FreeDeep(&rebuilt);
+  JSON_ColumnsFree(&columns);
+  JSON_FreeDeep(&list);
+}
+
+TEST(JSON_ColumnsTest, KeepsKeysHoldingNullCharactersApart) {
+  JSON list = cjson::testing::cjson::utils::Records(
+      3, cjson::testing::columns::NullCharacterFields);
+  JSON_Columns columns;
+  ASSERT_EQ(JSON_ColumnsFromList(&columns, &list), TRUE);
+  ASSERT_EQ(columns.ncolumns, 2);
+  EXPECT_EQ(columns.columns[1].keylen, 3);
+  EXPECT_EQ(std::memcmp(columns.columns[1].key, "k\0b", 3), 0);
+  JSON rebuilt;
+  ASSERT_EQ(JSON_ColumnsToList(&rebuilt, &columns), TRUE);
+  JSON* record = (JSON*)VectorGet(&rebuilt.value.list, 2);
+  ASSERT_EQ(record->value.object.entrieslen, 2);
+  JSON* value = (JSON*)MapGetN(&record->value.object, (void*)"k\0b", 3);
+  ASSERT_NE(value, nullptr);
+  EXPECT_EQ(value->value.number, -2);
+  JSON_FreeDeep(&rebuilt);
+  JSON_ColumnsFree(&columns);
+  JSON_FreeDeep(&list);
+}
+
+TEST(JSON_ColumnsTest, RejectsWhatCannotBeShredded) {
+  JSON_Columns columns;
+  JSON number = JSON_INIT_VAL(Number, 1);
+  EXPECT_EQ(JSON_ColumnsFromList(&columns, &number), FALSE);
+
+  JSON list = JSON_INIT_TYPE(List);
+  JSON_LIST_ADD_VAL(Number, &list, 1);
+  EXPECT_EQ(JSON_ColumnsFromList(&columns, &list), FALSE);
+  EXPECT_EQ(columns.ncolumns, 0);
+  JSON_FreeDeep(&list);
+
+  JSON* first = (JSON*)malloc(sizeof(JSON));
+  *first = JSON_INIT_TYPE_SIZE(Object, 1);
+  JSON_OBJECT_PUT_VAL(Number, first, strdup("a"), 1);
+  JSON* second = (JSON*)malloc(sizeof(JSON));
+  *second = JSON_INIT_TYPE_SIZE(Object, 1);
+  JSON_OBJECT_PUT_VAL(Bool, second, strdup("a"), TRUE);
+  JSON records = JSON_INIT_TYPE(List);
+  JSON_ListAdd(&records, first);
+  JSON_ListAdd(&records, second);
+  EXPECT_EQ(JSON_ColumnsFromList(&columns, &records), FALSE);
+  EXPECT_EQ(columns.columns, nullptr);
+  JSON_FreeDeep(&records);
+}
+
+#endif  // CJSON_TESTS_CJSON_TESTCOLUMNS_HH_
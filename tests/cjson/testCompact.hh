@@ -0,0 +1,126 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CJSON_TESTS_CJSON_TESTCOMPACT_HH_
+#define CJSON_TESTS_CJSON_TESTCOMPACT_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "accessors.h"
+#include "allocator.h"
+#include "bool.h"
+#include "cjson.h"
+#include "clone.h"
+#include "compact.h"
+#include "data/map/ops.h"
+#include "modifiers.h"
+#include "stats.h"
+
+namespace cjson {
+namespace testing {
+namespace compact {
+// Returns the compact text of `json`.
+std::string Text(JSON* const json) {
+  StringStream sstream = JSON_Stringify(json, FALSE, 0, TRUE);
+  std::string text(sstream.data, sstream.length);
+  StringStreamDealloc(&sstream);
+  return text;
+}
+
+// Fills `json` with an object of `fields` numbers, of which all but the
+// first `kept` are then removed, plus a list and a list of values with slack.
+void Document(JSON* const json, const int fields, const int kept) {
+  *json = JSON_INIT_TYPE(Object);
+  JSON* object = JSON_AllocType(JSON_Object);
+  for (int i = 0; i < fields; ++i)
+    JSON_OBJECT_PUT_VAL(Number, object,
+                        strdup(("field" + std::to_string(i)).c_str()), i);
+  for (int i = kept; i < fields; ++i) {
+    const std::string key = "field" + std::to_string(i);
+    void* owned = MapGetEntry(&object->value.object, (void*)key.c_str())->key;
+    void* value = MapRemove(&object->value.object, (void*)key.c_str());
+    AllocatorCacheFree(NULL, value, sizeof(JSON));
+    std::free(owned);
+  }
+  JSON_ObjectPut(json, strdup("object"), object);
+  JSON* list = JSON_AllocType(JSON_List);
+  for (int i = 0; i < 5; ++i)
+    JSON_LIST_ADD_VAL(Number, list, i);
+  JSON_ObjectPut(json, strdup("list"), list);
+  JSON* values = JSON_AllocType(JSON_Null);
+  *values = JSON_InitValueListImpl(32);
+  for (int i = 0; i < 3; ++i)
+    JSON_LIST_ADD_VAL(Number, values, i);
+  JSON_ObjectPut(json, strdup("values"), values);
+}
+}  // namespace compact
+}  // namespace testing
+}  // namespace cjson
+
+TEST(JSON_CompactTest, TrimsListsAndObjectsInPlace) {
+  JSON json;
+  cjson::testing::compact::Document(&json, 200, 3);
+  const std::string text = cjson::testing::compact::Text(&json);
+  const JSON_MemoryUsage before = JSON_MemoryStats(&json);
+  EXPECT_GT(before.unused, 0u);
+
+  JSON_Compact(&json);
+  const JSON_MemoryUsage after = JSON_MemoryStats(&json);
+  EXPECT_EQ(after.unused, 0u);
+  EXPECT_LT(after.buckets, before.buckets);
+  EXPECT_LT(after.total, before.total);
+  EXPECT_EQ(cjson::testing::compact::Text(&json), text);
+
+  // The compacted tree is still mutable.
+  JSON* list = (JSON*)MapGet(&json.value.object, (void*)"list");
+  JSON_LIST_ADD_VAL(Number, list, 5);
+  EXPECT_EQ(JSON_ListSize(list), 6u);
+  JSON_FreeDeep(&json);
+}
+
+TEST(JSON_CompactTest, RelocatesTheTreeIntoOneBlock) {
+  JSON json;
+  cjson::testing::compact::Document(&json, 20, 20);
+  // Trimmed first so that the buckets, and thus the order of the keys, match
+  // the ones of the relocated tree.
+  JSON_Compact(&json);
+  const std::string text = cjson::testing::compact::Text(&json);
+  JSON* relocated = JSON_CompactRelocate(&json);
+  ASSERT_NE(relocated, nullptr);
+  EXPECT_EQ(json.type, JSON_Null);
+  EXPECT_EQ(cjson::testing::compact::Text(relocated), text);
+  const JSON_MemoryUsage usage = JSON_MemoryStats(relocated);
+  EXPECT_EQ(usage.unused, 0u);
+  JSON_CloneFree(relocated);
+}
+
+#endif  // CJSON_TESTS_CJSON_TESTCOMPACT_HH_
@@ -0,0 +1,161 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CJSON_TESTS_CJSON_TESTDOCUMENT_HH_
+#define CJSON_TESTS_CJSON_TESTDOCUMENT_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "allocator.h"
+#include "bool.h"
+#include "cbor.h"
+#include "cjson.h"
+#include "document.h"
+#include "modifiers.h"
+
+TEST(JSON_DocumentTest, BuildsTreesOutOfTheArena) {
+  JSON_Document document = JSON_DocumentAlloc();
+  JSON* root = JSON_DocumentObject(&document, 0);
+  ASSERT_NE(root, nullptr);
+  document.root = root;
+
+  JSON* list = JSON_DocumentList(&document, 0);
+  ASSERT_NE(list, nullptr);
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_EQ(JSON_DocumentListAdd(&document, list,
+                                   JSON_DocumentNumber(&document, i)),
+              TRUE);
+  ASSERT_EQ(JSON_DocumentObjectPut(&document, root, "list", list), TRUE);
+
+  for (int i = 0; i < 1000; ++i) {
+    const std::string key = "key" + std::to_string(i);
+    ASSERT_EQ(JSON_DocumentObjectPut(&document, root, key.c_str(),
+                                     JSON_DocumentString(&document,
+                                                         key.c_str())),
+              TRUE);
+  }
+  ASSERT_EQ(JSON_DocumentObjectPut(&document, root, "key7",
+                                   JSON_DocumentBool(&document, TRUE)),
+            TRUE);
+
+  EXPECT_EQ(root->value.object.entrieslen, 1001);
+  EXPECT_EQ(root->value.object.bucketslen, MapComputeBucketsLen(1001));
+  ASSERT_EQ(list->value.list.size, 1000);
+  EXPECT_EQ(((JSON*)list->value.list.data[999])->value.number, 999);
+  JSON* string = (JSON*)MapGet(&root->value.object, (void*)"key999");
+  ASSERT_NE(string, nullptr);
+  EXPECT_STREQ(string->value.string, "key999");
+  JSON* boolean = (JSON*)MapGet(&root->value.object, (void*)"key7");
+  ASSERT_NE(boolean, nullptr);
+  EXPECT_EQ(boolean->type, JSON_Boolean);
+
+  JSON_DocumentFree(&document);
+  EXPECT_EQ(document.arena.blocks, nullptr);
+  EXPECT_EQ(document.root, nullptr);
+}
+
+TEST(JSON_DocumentTest, ImportsHeapTrees) {
+  JSON json;
+  const std::string bytes(
+      "\xa3\x61\x61\x82\x01\xf9\x3c\x00\x63key\x64IETF\x61z\xf6", 20);
+  ASSERT_EQ(cjson::testing::cbor::Decode(json, bytes), TRUE);
+
+  JSON_Document document = JSON_DocumentAlloc();
+  JSON* imported = JSON_DocumentImport(&document, &json);
+  ASSERT_NE(imported, nullptr);
+  EXPECT_EQ(cjson::testing::cbor::Encode(*imported),
+            cjson::testing::cbor::Encode(json));
+  JSON_FreeDeep(&json);
+  JSON_DocumentFree(&document);
+}
+
+TEST(JSON_DocumentTest, ImportsKeysHoldingNullCharacters) {
+  JSON json = JSON_INIT_TYPE(Object);
+  const char* const keys[] = {"k\0a", "k\0b"};
+  for (json_number_t i = 0; i < 2; ++i) {
+    char* key = (char*)AllocatorMalloc(NULL, 3);
+    std::memcpy(key, keys[i], 3);
+    JSON* value = JSON_AllocType(JSON_Number);
+    value->value.number = i;
+    JSON_ObjectPutN(&json, key, 3, value);
+  }
+
+  // The keys are neither truncated nor merged, with or without a pool.
+  KeyPool pool = KeyPoolAlloc();
+  JSON_Document document = JSON_DocumentAlloc();
+  for (int pass = 0; pass < 2; ++pass) {
+    document.keys = pass ? &pool : NULL;
+    JSON* imported = JSON_DocumentImport(&document, &json);
+    ASSERT_NE(imported, nullptr);
+    EXPECT_EQ(imported->value.object.entrieslen, 2);
+    JSON* value =
+        (JSON*)MapGetN(&imported->value.object, (void*)keys[1], 3);
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(value->value.number, 1);
+  }
+  JSON_DocumentFree(&document);
+  KeyPoolFree(&pool);
+  JSON_FreeDeep(&json);
+}
+
+TEST(JSON_DocumentTest, SharesKeysThroughAKeyPool) {
+  KeyPool keys = KeyPoolAlloc();
+  JSON_Document first = JSON_DocumentAlloc();
+  JSON_Document second = JSON_DocumentAlloc();
+  first.keys = second.keys = &keys;
+  JSON* a = JSON_DocumentObject(&first, 1);
+  JSON* b = JSON_DocumentObject(&second, 1);
+  ASSERT_EQ(JSON_DocumentObjectPut(&first, a, "status",
+                                   JSON_DocumentString(&first, "ok")),
+            TRUE);
+  ASSERT_EQ(JSON_DocumentObjectPut(&second, b, "status",
+                                   JSON_DocumentNumber(&second, 200)),
+            TRUE);
+  MapEntry* entry_a = MapGetEntry(&a->value.object, (void*)"status");
+  MapEntry* entry_b = MapGetEntry(&b->value.object, (void*)"status");
+  ASSERT_NE(entry_a, nullptr);
+  ASSERT_NE(entry_b, nullptr);
+  EXPECT_EQ(entry_a->key, entry_b->key);
+  EXPECT_EQ(entry_a->key, KeyPoolFind(&keys, "status"));
+  JSON_DocumentFree(&first);
+  JSON_DocumentFree(&second);
+  KeyPoolFree(&keys);
+}
+
+TEST(JSON_DocumentTest, RejectsNodesOfTheWrongType) {
+  JSON_Document document = JSON_DocumentAlloc();
+  JSON* number = JSON_DocumentNumber(&document, 1);
+  EXPECT_EQ(JSON_DocumentListAdd(&document, number, number), FALSE);
+  EXPECT_EQ(JSON_DocumentObjectPut(&document, number, "a", number), FALSE);
+  JSON_DocumentFree(&document);
+}
+
+#endif  // CJSON_TESTS_CJSON_TESTDOCUMENT_HH_
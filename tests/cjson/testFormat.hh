@@ -0,0 +1,121 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_TESTS_CJSON_TESTFORMAT_HH_
+#define CJSON_TESTS_CJSON_TESTFORMAT_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "data/sstream/sstream.h"
+#include "format.h"
+
+class JSON_FormatTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    StringStreamDealloc(&src);
+    StringStreamDealloc(&dest);
+  }
+
+ protected:
+  StringStream src;
+  StringStream dest;
+};
+
+TEST_F(JSON_FormatTest, MinifyStripsWhitespaceOutsideOfStrings) {
+  src = StringStreamStrAlloc(
+      "{\n  \"a\" : [ 1 ,\t2 ],\r\n  \"b c\" : \"x  y\\\" } z\" ,"
+      "\n  \"d\":{ }  }\n");
+  dest = StringStreamAlloc();
+  JSON_Minify(&dest, &src);
+  EXPECT_STREQ(dest.data, "{\"a\":[1,2],\"b c\":\"x  y\\\" } z\",\"d\":{}}");
+  EXPECT_EQ(dest.length, std::strlen(dest.data));
+}
+
+TEST_F(JSON_FormatTest, MinifyAppendsOntoTheDestination) {
+  src = StringStreamStrAlloc("[ true, false, null ]");
+  dest = StringStreamStrAlloc("prefix:");
+  JSON_Minify(&dest, &src);
+  EXPECT_STREQ(dest.data, "prefix:[true,false,null]");
+}
+
+TEST_F(JSON_FormatTest, MinifyHandlesInputsLongerThanAVectorRegister) {
+  std::string input = "[";
+  std::string expected = "[";
+  for (int i = 0; i < 64; ++i) {
+    input += "   \"long string value with spaces \\\\\" ,\n";
+    expected += "\"long string value with spaces \\\\\",";
+  }
+  input += "  0  ]";
+  expected += "0]";
+  src = StringStreamStrAlloc(input.c_str());
+  dest = StringStreamAlloc();
+  JSON_Minify(&dest, &src);
+  EXPECT_EQ(std::string(dest.data, dest.length), expected);
+}
+
+TEST_F(JSON_FormatTest, ReformatIndentsNestedContainers) {
+  src = StringStreamStrAlloc(
+      "{\"list\":[1,2.5,\"a,b\"],\"object\":{\"key\":null,\"empty\":[ ]}}");
+  dest = StringStreamAlloc();
+  JSON_Reformat(&dest, &src, JSON_FORMAT_DEFAULT_INDENT);
+  EXPECT_STREQ(dest.data,
+               "{\n"
+               "    \"list\": [\n"
+               "        1,\n"
+               "        2.5,\n"
+               "        \"a,b\"\n"
+               "    ],\n"
+               "    \"object\": {\n"
+               "        \"key\": null,\n"
+               "        \"empty\": []\n"
+               "    }\n"
+               "}");
+}
+
+TEST_F(JSON_FormatTest, ReformatIsReversedByMinify) {
+  src = StringStreamStrAlloc("{\"a\":[[[[{\"b\":\"c d\"}]]]],\"e\":{}}");
+  dest = StringStreamAlloc();
+  JSON_Reformat(&dest, &src, 200);
+  StringStream minified = StringStreamAlloc();
+  JSON_Minify(&minified, &dest);
+  EXPECT_STREQ(minified.data, src.data);
+  StringStreamDealloc(&minified);
+}
+
+TEST_F(JSON_FormatTest, ReformatWithZeroIndentMinifies) {
+  src = StringStreamStrAlloc("[ 1, { \"a\" : 2 } ]");
+  dest = StringStreamAlloc();
+  JSON_Reformat(&dest, &src, 0);
+  EXPECT_STREQ(dest.data, "[1,{\"a\":2}]");
+}
+
+#endif  // CJSON_TESTS_CJSON_TESTFORMAT_HH_
@@ -0,0 +1,193 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CJSON_TESTS_CJSON_TESTMSGPACK_HH_
+#define CJSON_TESTS_CJSON_TESTMSGPACK_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "../allocator/utils.hh"
+#include "accessors.h"
+#include "bool.h"
+#include "cjson.h"
+#include "data/sstream/sstream.h"
+#include "msgpack.h"
+
+namespace cjson {
+namespace testing {
+namespace msgpack {
+// Returns the MessagePack encoding of `json` as a `std::string` of raw bytes.
+std::string Encode(const JSON& json) {
+  StringStream sstream = StringStreamAlloc();
+  JSON_ToMsgPack(&sstream, &json);
+  std::string bytes(sstream.data, sstream.length);
+  StringStreamDealloc(&sstream);
+  return bytes;
+}
+
+// Decodes the raw MessagePack `bytes` into `json` copying every string.
+bool_t Decode(JSON& json, const std::string& bytes) {
+  StringStream sstream = StringStreamStrNAlloc(bytes.data(), bytes.size());
+  bool_t decoded = JSON_FromMsgPack(&json, &sstream, FALSE);
+  StringStreamDealloc(&sstream);
+  return decoded;
+}
+}  // namespace msgpack
+}  // namespace testing
+}  // namespace cjson
+
+TEST(JSON_ToMsgPackTest, EncodesNumbersInTheSmallestWidth) {
+  using cjson::testing::msgpack::Encode;
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, 0)), std::string("\x00", 1));
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, 127)), "\x7f");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, 128)), "\xcc\x80");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, 65535)), "\xcd\xff\xff");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, 65536)),
+            std::string("\xce\x00\x01\x00\x00", 5));
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, 4294967296)),
+            std::string("\xcf\x00\x00\x00\x01\x00\x00\x00\x00", 9));
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, -1)), "\xff");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, -32)), "\xe0");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, -33)), "\xd0\xdf");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, -129)), "\xd1\xff\x7f");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Number, INT64_MIN)),
+            std::string("\xd3\x80\x00\x00\x00\x00\x00\x00\x00", 9));
+}
+
+TEST(JSON_ToMsgPackTest, EncodesScalars) {
+  using cjson::testing::msgpack::Encode;
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Decimal, 1.5)),
+            std::string("\xca\x3f\xc0\x00\x00", 5));
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Decimal, 1.1)),
+            "\xcb\x3f\xf1\x99\x99\x99\x99\x99\x9a");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Bool, TRUE)), "\xc3");
+  EXPECT_EQ(Encode(JSON_INIT_VAL(Bool, FALSE)), "\xc2");
+  EXPECT_EQ(Encode(JSON_INIT(Null)), "\xc0");
+
+  JSON string = JSON_INIT_VAL(String, JSON_CONST_STRINGIFY("IETF"));
+  EXPECT_EQ(Encode(string), "\xa4IETF");
+  JSON_Free(&string);
+
+  const std::string chars(40, 'x');
+  JSON view = JSON_InitStringViewImpl((json_string_t)chars.data(), 40);
+  EXPECT_EQ(Encode(view), "\xd9\x28" + chars);
+}
+
+TEST(JSON_ToMsgPackTest, EncodesContainers) {
+  JSON list = JSON_INIT_TYPE(List);
+  JSON_LIST_ADD_VAL(Number, &list, 1);
+  JSON* nested = JSON_AllocType(JSON_List);
+  JSON_LIST_ADD_VAL(Number, nested, 2);
+  JSON_LIST_ADD_VAL(Number, nested, 3);
+  JSON_ListAdd(&list, nested);
+  EXPECT_EQ(cjson::testing::msgpack::Encode(list), "\x92\x01\x92\x02\x03");
+  JSON_FreeDeep(&list);
+
+  JSON object = JSON_INIT_TYPE(Object);
+  JSON_OBJECT_PUT_VAL(Number, &object, strdup("a"), 1);
+  EXPECT_EQ(cjson::testing::msgpack::Encode(object), "\x81\xa1\x61\x01");
+  JSON_FreeDeep(&object);
+}
+
+TEST(JSON_ToMsgPackTest, FailsWhenTheStreamCanNotGrow) {
+  std::size_t limit = 64;
+  const Allocator limited =
+      cjson::testing::allocator::utils::LimitedAllocator(&limit);
+  StringStream sstream = StringStreamNAllocWithAllocator(16, &limited);
+  std::string text(200, 'a');
+  JSON string = JSON_InitStringViewImpl(&text[0], text.size());
+  EXPECT_EQ(JSON_ToMsgPack(&sstream, &string), FALSE);
+  EXPECT_LE(sstream.length, sstream.capacity);
+  StringStreamDealloc(&sstream);
+}
+
+TEST(JSON_FromMsgPackTest, DecodesWhatWasEncoded) {
+  JSON json;
+  const std::string bytes(
+      "\x93\xd3\x80\x00\x00\x00\x00\x00\x00\x00\xcb\x3f\xf1\x99\x99\x99\x99"
+      "\x99\x9a\x81\xa1\x61\xc0",
+      23);
+  ASSERT_EQ(cjson::testing::msgpack::Decode(json, bytes), TRUE);
+  ASSERT_EQ(json.type, JSON_List);
+  EXPECT_EQ(((const JSON*)VectorGet(&json.value.list, 0))->value.number,
+            INT64_MIN);
+  EXPECT_EQ(cjson::testing::msgpack::Encode(json), bytes);
+  JSON_FreeDeep(&json);
+}
+
+TEST(JSON_FromMsgPackTest, DecodesStringsAsViewsIntoTheInput) {
+  const std::string bytes("\x82\xa1\x61\xa4IETF\xa1\x62\xd9\x03key", 15);
+  StringStream sstream = StringStreamStrNAlloc(bytes.data(), bytes.size());
+  JSON json;
+  ASSERT_EQ(JSON_FromMsgPack(&json, &sstream, TRUE), TRUE);
+  ASSERT_EQ(json.type, JSON_Object);
+
+  JSON* string = (JSON*)MapGet(&json.value.object, (void*)"a");
+  ASSERT_NE(string, nullptr);
+  ASSERT_EQ(string->type, JSON_String);
+  EXPECT_TRUE(string->flags & JSON_FLAG_STRING_VIEW);
+  EXPECT_EQ(JSON_StringData(string), sstream.data + 4);
+  EXPECT_EQ(JSON_StringLength(string), 4);
+
+  string = (JSON*)MapGet(&json.value.object, (void*)"b");
+  ASSERT_NE(string, nullptr);
+  EXPECT_EQ(std::string(JSON_StringData(string), JSON_StringLength(string)),
+            "key");
+  JSON_FreeDeep(&json);
+  StringStreamDealloc(&sstream);
+}
+
+TEST(JSON_FromMsgPackTest, RejectsMalformedInput) {
+  using cjson::testing::msgpack::Decode;
+  JSON json;
+  // Truncated argument.
+  EXPECT_EQ(Decode(json, "\xcd\x03"), FALSE);
+  EXPECT_EQ(json.type, JSON_Null);
+  // Trailing bytes.
+  EXPECT_EQ(Decode(json, std::string("\x00\x00", 2)), FALSE);
+  // Never used, bin and ext types.
+  EXPECT_EQ(Decode(json, "\xc1"), FALSE);
+  EXPECT_EQ(Decode(json, "\xc4\x01\x01"), FALSE);
+  EXPECT_EQ(Decode(json, "\xd4\x01\x01"), FALSE);
+  // Duplicate and non-string keys.
+  EXPECT_EQ(Decode(json, "\x82\xa1\x61\x01\xa1\x61\x02"), FALSE);
+  EXPECT_EQ(Decode(json, "\x81\x01\x02"), FALSE);
+  // A list claiming more items than there are bytes.
+  EXPECT_EQ(Decode(json, "\xdd\xff\xff\xff\xff\x01"), FALSE);
+  // Nesting deeper than `JSON_MSGPACK_MAX_DEPTH`.
+  EXPECT_EQ(Decode(json, std::string(JSON_MSGPACK_MAX_DEPTH + 1, '\x91') +
+                             "\x01"),
+            FALSE);
+  EXPECT_EQ(json.type, JSON_Null);
+}
+
+#endif  // CJSON_TESTS_CJSON_TESTMSGPACK_HH_
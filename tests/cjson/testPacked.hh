@@ -0,0 +1,228 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_TESTS_CJSON_TESTPACKED_HH_
+#define CJSON_TESTS_CJSON_TESTPACKED_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "../allocator/utils.hh"
+#include "allocator.h"
+#include "bool.h"
+#include "cjson.h"
+#include "packed.h"
+#include "utils.hh"
+
+namespace cjson {
+namespace testing {
+namespace packed {
+using allocator::utils::Key;
+
+// Puts `{"id": i, "name": <a long string>, "active": i is even,
+// "parent": null}` into `record`.
+void Fields(JSON* const record, const size_t i) {
+  JSON_OBJECT_PUT_VAL(Number, record, Key("id"), (json_number_t)i);
+  JSON_OBJECT_PUT_VAL(String, record, Key("name"),
+                      JSON_STRINGIFY("a name longer than inline"));
+  JSON_OBJECT_PUT_VAL(Bool, record, Key("active"), i % 2 == 0);
+  JSON_OBJECT_PUT(Null, record, Key("parent"));
+}
+
+// Returns a list of `count` records shaped by `Fields()`.
+JSON Records(const size_t count) {
+  return cjson::utils::Records(count, Fields);
+}
+}  // namespace packed
+}  // namespace testing
+}  // namespace cjson
+
+TEST(JSON_PackTest, NodesAreSixteenBytes) {
+  EXPECT_EQ(sizeof(JSON_PackedNode), 16);
+}
+
+TEST(JSON_PackTest, PacksScalarsAndStrings) {
+  JSON_Packed packed;
+  JSON number = JSON_INIT_VAL(Number, -42);
+  ASSERT_EQ(JSON_Pack(&packed, &number), TRUE);
+  EXPECT_EQ(packed.nodeslen, 1);
+  EXPECT_EQ(JSON_PackedRoot(&packed)->type, JSON_Number);
+  EXPECT_EQ(JSON_PackedRoot(&packed)->value.number, -42);
+  JSON_PackedFree(&packed);
+
+  size_t length;
+  JSON inline_ = JSON_INIT_VAL(String, JSON_STRINGIFY("GET"));
+  ASSERT_EQ(JSON_Pack(&packed, &inline_), TRUE);
+  EXPECT_EQ(packed.charslen, 0);
+  EXPECT_STREQ(JSON_PackedString(&packed, JSON_PackedRoot(&packed), &length),
+               "GET");
+  EXPECT_EQ(length, 3);
+  JSON_PackedFree(&packed);
+
+  JSON string = JSON_INIT_VAL(String, JSON_STRINGIFY("eight ch"));
+  ASSERT_EQ(JSON_Pack(&packed, &string), TRUE);
+  EXPECT_EQ(packed.charslen, 9);
+  EXPECT_STREQ(JSON_PackedString(&packed, JSON_PackedRoot(&packed), &length),
+               "eight ch");
+  EXPECT_EQ(length, 8);
+  EXPECT_EQ(JSON_PackedString(&packed, nullptr, nullptr), nullptr);
+  JSON_PackedFree(&packed);
+  EXPECT_EQ(packed.nodes, nullptr);
+  JSON_Free(&string);
+}
+
+TEST(JSON_PackTest, StoresChildrenByValueAndSortsEntries) {
+  JSON_Packed packed;
+  JSON list = cjson::testing::packed::Records(3);
+  ASSERT_EQ(JSON_Pack(&packed, &list), TRUE);
+  // The list, three records and four entries of two nodes per record.
+  EXPECT_EQ(packed.nodeslen, 1 + 3 + 3 * 4 * 2);
+
+  const JSON_PackedNode* root = JSON_PackedRoot(&packed);
+  ASSERT_EQ(JSON_PackedSize(root), 3);
+  EXPECT_EQ(JSON_PackedListGet(&packed, root, 3), nullptr);
+  const JSON_PackedNode* first = JSON_PackedListGet(&packed, root, 0);
+  const JSON_PackedNode* second = JSON_PackedListGet(&packed, root, 1);
+  EXPECT_EQ(second, first + 1);
+  ASSERT_EQ(JSON_PackedSize(second), 4);
+
+  const char* keys[] = {"active", "id", "name", "parent"};
+  for (size_t i = 0; i < 4; ++i) {
+    const char* key = nullptr;
+    const JSON_PackedNode* value =
+        JSON_PackedObjectEntry(&packed, second, i, &key);
+    EXPECT_STREQ(key, keys[i]);
+    EXPECT_EQ(JSON_PackedObjectGet(&packed, second, keys[i]), value);
+  }
+  EXPECT_EQ(JSON_PackedObjectGet(&packed, second, "id")->value.number, 1);
+  EXPECT_EQ(JSON_PackedObjectGet(&packed, second, "active")->value.boolean,
+            FALSE);
+  EXPECT_EQ(JSON_PackedObjectGet(&packed, second, "parent")->type, JSON_Null);
+  EXPECT_STREQ(JSON_PackedString(&packed,
+                                 JSON_PackedObjectGet(&packed, second, "name"),
+                                 nullptr),
+               "a name longer than inline");
+  EXPECT_EQ(JSON_PackedObjectGet(&packed, second, "missing"), nullptr);
+  EXPECT_EQ(JSON_PackedObjectGet(&packed, root, "id"), nullptr);
+  JSON_PackedFree(&packed);
+  JSON_FreeDeep(&list);
+}
+
+TEST(JSON_PackTest, StoresRepeatedStringsOnce) {
+  JSON_Packed packed;
+  JSON list = cjson::testing::packed::Records(3);
+  ASSERT_EQ(JSON_Pack(&packed, &list), TRUE);
+  EXPECT_EQ(packed.charslen, sizeof("a name longer than inline"));
+  const JSON_PackedNode* root = JSON_PackedRoot(&packed);
+  EXPECT_EQ(JSON_PackedString(&packed,
+                              JSON_PackedObjectGet(
+                                  &packed, JSON_PackedListGet(&packed, root, 0),
+                                  "name"),
+                              nullptr),
+            JSON_PackedString(&packed,
+                              JSON_PackedObjectGet(
+                                  &packed, JSON_PackedListGet(&packed, root, 2),
+                                  "name"),
+                              nullptr));
+  JSON_PackedFree(&packed);
+  JSON_FreeDeep(&list);
+}
+
+TEST(JSON_PackTest, UsesAThirdOfTheMemoryOfTheHeapTree) {
+  using namespace cjson::testing::allocator::utils;
+  // Bytes requested for the heap tree, not counting the overhead of malloc.
+  Counter counter = {0, 0, 0, 0};
+  const Allocator summing = CountingAllocator(&counter);
+  AllocatorSetDefault(&summing);
+  JSON list = cjson::testing::packed::Records(1000);
+  AllocatorSetDefault(NULL);
+  const size_t heap = counter.bytes;
+
+  JSON_Packed packed;
+  ASSERT_EQ(JSON_Pack(&packed, &list), TRUE);
+  EXPECT_LE(3 * JSON_PackedMemoryUsage(&packed), heap);
+  JSON_PackedFree(&packed);
+  JSON_FreeDeep(&list);
+}
+
+TEST(JSON_PackTest, FindsAndUnpacksKeysHoldingNullCharacters) {
+  using cjson::testing::allocator::utils::Key;
+  const char* const keys[] = {"k\0b", "k", "k\0a"};
+  const size_t keylens[] = {3, 1, 3};
+  JSON object = JSON_INIT_TYPE(Object);
+  for (size_t i = 0; i < 3; ++i) {
+    JSON* value = JSON_AllocType(JSON_Number);
+    value->value.number = (json_number_t)i;
+    JSON_ObjectPutN(&object, Key(keys[i], keylens[i]), keylens[i], value);
+  }
+
+  JSON_Packed packed;
+  ASSERT_EQ(JSON_Pack(&packed, &object), TRUE);
+  const JSON_PackedNode* root = JSON_PackedRoot(&packed);
+  for (size_t i = 0; i < 3; ++i) {
+    const JSON_PackedNode* value =
+        JSON_PackedObjectGetN(&packed, root, keys[i], keylens[i]);
+    ASSERT_NE(value, nullptr) << i;
+    EXPECT_EQ(value->value.number, (json_number_t)i);
+  }
+  EXPECT_EQ(JSON_PackedObjectGetN(&packed, root, "k\0c", 3), nullptr);
+  EXPECT_EQ(JSON_PackedObjectGet(&packed, root, "k")->value.number, 1);
+
+  JSON unpacked;
+  ASSERT_EQ(JSON_Unpack(&unpacked, &packed, root), TRUE);
+  EXPECT_EQ(unpacked.value.object.entrieslen, 3);
+  JSON* value = (JSON*)MapGetN(&unpacked.value.object, (void*)keys[2], 3);
+  ASSERT_NE(value, nullptr);
+  EXPECT_EQ(value->value.number, 2);
+  JSON_FreeDeep(&unpacked);
+  JSON_PackedFree(&packed);
+  JSON_FreeDeep(&object);
+}
+
+TEST(JSON_UnpackTest, RoundTripsThroughTheHeapLayout) {
+  JSON_Packed packed, repacked;
+  JSON list = cjson::testing::packed::Records(100);
+  ASSERT_EQ(JSON_Pack(&packed, &list), TRUE);
+  JSON unpacked;
+  ASSERT_EQ(JSON_Unpack(&unpacked, &packed, JSON_PackedRoot(&packed)), TRUE);
+  ASSERT_EQ(JSON_Pack(&repacked, &unpacked), TRUE);
+  ASSERT_EQ(repacked.nodeslen, packed.nodeslen);
+  ASSERT_EQ(repacked.charslen, packed.charslen);
+  EXPECT_EQ(std::memcmp(repacked.nodes, packed.nodes,
+                        packed.nodeslen * sizeof(JSON_PackedNode)),
+            0);
+  EXPECT_EQ(std::memcmp(repacked.chars, packed.chars, packed.charslen), 0);
+  JSON_PackedFree(&packed);
+  JSON_PackedFree(&repacked);
+  JSON_FreeDeep(&unpacked);
+  JSON_FreeDeep(&list);
+}
+
+#endif  // CJSON_TESTS_CJSON_TESTPACKED_HH_
@@ -0,0 +1,92 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CJSON_TESTS_CJSON_TESTRECLAIM_HH_
+#define CJSON_TESTS_CJSON_TESTRECLAIM_HH_
+
+#include <gtest/gtest.h>
+
+#include "../allocator/utils.hh"
+#include "allocator.h"
+#include "bool.h"
+#include "cjson.h"
+#include "modifiers.h"
+#include "reclaim.h"
+#include "utils.hh"
+
+namespace cjson {
+namespace testing {
+namespace reclaim {
+using allocator::utils::Key;
+
+// Puts `{"id": i, "name": <a long string>}` into `record`.
+void Fields(JSON* const record, const size_t i) {
+  JSON_OBJECT_PUT_VAL(Number, record, Key("id"), (json_number_t)i);
+  JSON_OBJECT_PUT_VAL(String, record, Key("name"),
+                      JSON_STRINGIFY("a name longer than sixteen bytes"));
+}
+
+// Fills `json` with `records` objects shaped by `Fields()`.
+void Records(JSON* const json, const size_t records) {
+  *json = cjson::utils::Records(records, Fields);
+}
+}  // namespace reclaim
+}  // namespace testing
+}  // namespace cjson
+
+TEST(JSON_FreeAsyncTest, ReleasesTreesInTheBackground) {
+  using namespace cjson::testing::reclaim;
+  AllocatorCounter counter;
+  Allocator counting = AllocatorCounting(&counter, NULL);
+  AllocatorSetDefault(&counting);
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < 4 * JSON_RECLAIM_QUEUE_DEPTH; ++i) {
+      JSON json;
+      Records(&json, 100);
+      JSON_FreeAsync(&json);
+      EXPECT_EQ(json.type, JSON_Null);
+    }
+    // Draining stops the thread, the next round starts a new one.
+    JSON_FreeAsyncDrain();
+    EXPECT_EQ(AllocatorCounterBlocks(&counter), 0u);
+  }
+  AllocatorSetDefault(NULL);
+}
+
+TEST(JSON_FreeAsyncTest, FreesScalarsInTheCallingThread) {
+  JSON json = JSON_INIT_VAL(String, JSON_STRINGIFY("a string, not a tree"));
+  EXPECT_EQ(JSON_FreeAsync(&json), FALSE);
+  EXPECT_EQ(json.type, JSON_Null);
+
+  cjson::testing::reclaim::Records(&json, 1);
+  EXPECT_EQ(JSON_FreeAsync(&json), TRUE);
+  JSON_FreeAsyncDrain();
+  JSON_FreeAsyncDrain();
+}
+
+#endif  // CJSON_TESTS_CJSON_TESTRECLAIM_HH_
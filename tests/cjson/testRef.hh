@@ -0,0 +1,180 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CJSON_TESTS_CJSON_TESTREF_HH_
+#define CJSON_TESTS_CJSON_TESTREF_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "accessors.h"
+#include "bool.h"
+#include "cjson.h"
+#include "modifiers.h"
+#include "ref.h"
+
+namespace cjson {
+namespace testing {
+namespace ref {
+// Returns a handle to `{"hosts": ["db-primary-000", ...], "port": 5432}`.
+JSON_Ref Config(const size_t hosts) {
+  JSON config = JSON_INIT_TYPE(Object);
+  JSON* list = JSON_AllocType(JSON_List);
+  for (size_t i = 0; i < hosts; ++i) {
+    char host[32];
+    std::snprintf(host, sizeof(host), "db-primary-%03zu", i);
+    JSON_LIST_ADD_VAL(String, list, host);
+  }
+  JSON_ObjectPut(&config, strdup("hosts"), list);
+  JSON_OBJECT_PUT_VAL(Number, &config, strdup("port"), 5432);
+  return JSON_RefNew(&config);
+}
+}  // namespace ref
+}  // namespace testing
+}  // namespace cjson
+
+TEST(JSON_RefTest, ReleasesTheTreeWithTheLastReference) {
+  JSON_Ref config = cjson::testing::ref::Config(4);
+  ASSERT_NE(JSON_RefGet(config), nullptr);
+  EXPECT_EQ(JSON_RefCount(config), 1);
+  JSON_Ref other = JSON_RefRetain(config);
+  EXPECT_EQ(JSON_RefGet(other), JSON_RefGet(config));
+  EXPECT_EQ(JSON_RefCount(config), 2);
+  JSON_RefRelease(&config);
+  EXPECT_EQ(config.shared, nullptr);
+  EXPECT_EQ(JSON_RefCount(other), 1);
+  const JSON* port =
+      (const JSON*)MapGet((Map*)&JSON_RefGet(other)->value.object,
+                          (void*)"port");
+  ASSERT_NE(port, nullptr);
+  EXPECT_EQ(port->value.number, 5432);
+  JSON_RefRelease(&other);
+}
+
+TEST(JSON_RefTest, AttachedTreesOutliveTheDocumentsSharingThem) {
+  JSON_Ref config = cjson::testing::ref::Config(64);
+  JSON first = JSON_INIT_TYPE(Object);
+  JSON_ObjectPut(&first, strdup("config"), JSON_RefAttach(config));
+  JSON second = JSON_INIT_TYPE(List);
+  JSON_ListAdd(&second, JSON_RefAttach(config));
+  JSON_ListAdd(&second, JSON_RefAttach(config));
+  EXPECT_EQ(JSON_RefCount(config), 4);
+  EXPECT_EQ(JSON_ListGet(&second, 0), JSON_RefGet(config));
+  EXPECT_EQ(MapGet(&first.value.object, (void*)"config"), JSON_RefGet(config));
+
+  JSON_FreeDeep(&second);
+  EXPECT_EQ(JSON_RefCount(config), 2);
+  JSON_RefRelease(&config);
+  // The document holds the last reference.
+  StringStream sstream =
+      JSON_Stringify((JSON*)MapGet(&first.value.object, (void*)"config"),
+                     FALSE, 0, TRUE);
+  EXPECT_NE(std::strstr(sstream.data, "db-primary-063"), nullptr);
+  StringStreamDealloc(&sstream);
+  JSON_FreeDeep(&first);
+}
+
+TEST(JSON_RefTest, MutationCopiesOnlySharedTrees) {
+  JSON_Ref config = cjson::testing::ref::Config(2);
+  const JSON* original = JSON_RefGet(config);
+  // Nobody else holds it, no copy is made.
+  EXPECT_EQ(JSON_RefMut(&config), original);
+
+  JSON_Ref other = JSON_RefRetain(config);
+  JSON* mine = JSON_RefMut(&other);
+  ASSERT_NE(mine, nullptr);
+  EXPECT_NE(mine, original);
+  EXPECT_EQ(JSON_RefCount(config), 1);
+  EXPECT_EQ(JSON_RefCount(other), 1);
+  JSON_OBJECT_PUT_VAL(Number, mine, strdup("timeout"), 30);
+  JSON* hosts = (JSON*)MapGet(&mine->value.object, (void*)"hosts");
+  JSON_LIST_ADD_VAL(String, hosts, JSON_STRINGIFY("db-replica"));
+
+  EXPECT_EQ(MapGet((Map*)&original->value.object, (void*)"timeout"), nullptr);
+  const JSON* original_hosts =
+      (const JSON*)MapGet((Map*)&original->value.object, (void*)"hosts");
+  EXPECT_EQ(JSON_ListSize(original_hosts), 2);
+  EXPECT_EQ(JSON_ListSize(hosts), 3);
+  EXPECT_STREQ(JSON_StringData(JSON_ListGet(hosts, 1)),
+               JSON_StringData(JSON_ListGet(original_hosts, 1)));
+  JSON_RefRelease(&config);
+  JSON_RefRelease(&other);
+}
+
+TEST(JSON_RefTest, CopiesKeepNestedSharedTreesShared) {
+  JSON_Ref config = cjson::testing::ref::Config(2);
+  JSON request = JSON_INIT_TYPE(List);
+  JSON_ListAdd(&request, JSON_RefAttach(config));
+  JSON_LIST_ADD_VAL(Number, &request, 7);
+
+  JSON copy;
+  ASSERT_EQ(JSON_RefCopy(&copy, &request), TRUE);
+  EXPECT_EQ(JSON_ListGet(&copy, 0), JSON_RefGet(config));
+  EXPECT_NE(JSON_ListGet(&copy, 1), JSON_ListGet(&request, 1));
+  EXPECT_EQ(JSON_RefCount(config), 3);
+
+  // Lists storing their elements by value take a copy of their own.
+  JSON values = JSON_InitValueListImpl(0);
+  JSON_ListAdd(&values, JSON_RefAttach(config));
+  EXPECT_EQ(JSON_RefCount(config), 3);
+  EXPECT_NE(JSON_ListGet(&values, 0), JSON_RefGet(config));
+  EXPECT_EQ(JSON_ListGet(&values, 0)->value.object.entrieslen, 2);
+
+  JSON_FreeDeep(&values);
+  JSON_FreeDeep(&copy);
+  JSON_FreeDeep(&request);
+  EXPECT_EQ(JSON_RefCount(config), 1);
+  JSON_RefRelease(&config);
+}
+
+TEST(JSON_RefTest, SharedCountsAreAtomic) {
+  JSON_Ref config = cjson::testing::ref::Config(8);
+  JSON_RefShare(config);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([config] {
+      for (int j = 0; j < 10000; ++j) {
+        JSON_Ref ref = JSON_RefRetain(config);
+        JSON_RefRelease(&ref);
+        JSON request = JSON_INIT_TYPE(List);
+        JSON_ListAdd(&request, JSON_RefAttach(config));
+        JSON_FreeDeep(&request);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  EXPECT_EQ(JSON_RefCount(config), 1);
+  JSON_RefRelease(&config);
+}
+
+#endif  // CJSON_TESTS_CJSON_TESTREF_HH_
@@ -0,0 +1,187 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CJSON_TESTS_CJSON_TESTSNAPSHOT_HH_
+#define CJSON_TESTS_CJSON_TESTSNAPSHOT_HH_
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "../allocator/utils.hh"
+#include "bool.h"
+#include "cjson.h"
+#include "data/sstream/sstream.h"
+#include "snapshot.h"
+
+class JSON_SnapshotTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    JSON document = JSON_INIT_TYPE_SIZE(Object, 8);
+    JSON_OBJECT_PUT_VAL(Number, &document, strdup("id"), -42);
+    JSON_OBJECT_PUT_VAL(Decimal, &document, strdup("pi"), 3.25);
+    JSON_OBJECT_PUT_VAL(Bool, &document, strdup("ok"), TRUE);
+    JSON_OBJECT_PUT(Null, &document, strdup("none"));
+    JSON_OBJECT_PUT_VAL(String, &document, strdup("name"),
+                        JSON_STRINGIFY("cjson"));
+    JSON* list = JSON_AllocType(JSON_List);
+    JSON_LIST_ADD_VAL(Number, list, 1);
+    JSON_LIST_ADD_VAL(Number, list, 2);
+    JSON_ObjectPut(&document, strdup("list"), list);
+
+    snapshot = StringStreamAlloc();
+    const bool_t written = JSON_SnapshotWrite(&snapshot, &document);
+    JSON_FreeDeep(&document);
+    ASSERT_EQ(written, TRUE);
+  }
+
+  void TearDown() override { StringStreamDealloc(&snapshot); }
+
+  StringStream snapshot;
+};
+
+TEST_F(JSON_SnapshotTest, QueriesTheDocumentInPlace) {
+  JSON_Snapshot view;
+  ASSERT_EQ(JSON_SnapshotFromBuffer(&view, snapshot.data, snapshot.length),
+            TRUE);
+  const JSON_SnapshotNode root = JSON_SnapshotRoot(&view);
+  ASSERT_EQ(JSON_SnapshotType(&view, root), JSON_Object);
+  EXPECT_EQ(JSON_SnapshotSize(&view, root), 6);
+
+  EXPECT_EQ(
+      JSON_SnapshotNumber(&view, JSON_SnapshotObjectGet(&view, root, "id")),
+      -42);
+  EXPECT_EQ(
+      JSON_SnapshotDecimal(&view, JSON_SnapshotObjectGet(&view, root, "pi")),
+      3.25);
+  EXPECT_EQ(JSON_SnapshotBool(&view, JSON_SnapshotObjectGet(&view, root, "ok")),
+            TRUE);
+  EXPECT_EQ(
+      JSON_SnapshotType(&view, JSON_SnapshotObjectGet(&view, root, "none")),
+      JSON_Null);
+
+  size_t length = 0;
+  EXPECT_STREQ(JSON_SnapshotString(
+                   &view, JSON_SnapshotObjectGet(&view, root, "name"), &length),
+               "cjson");
+  EXPECT_EQ(length, 5);
+
+  const JSON_SnapshotNode list = JSON_SnapshotObjectGet(&view, root, "list");
+  ASSERT_EQ(JSON_SnapshotType(&view, list), JSON_List);
+  ASSERT_EQ(JSON_SnapshotSize(&view, list), 2);
+  EXPECT_EQ(JSON_SnapshotNumber(&view, JSON_SnapshotListGet(&view, list, 1)),
+            2);
+  EXPECT_EQ(JSON_SnapshotListGet(&view, list, 2), JSON_SNAPSHOT_NONE);
+
+  EXPECT_EQ(JSON_SnapshotObjectGet(&view, root, "missing"),
+            JSON_SNAPSHOT_NONE);
+  EXPECT_EQ(JSON_SnapshotObjectGet(&view, list, "id"), JSON_SNAPSHOT_NONE);
+
+  for (size_t i = 0; i < JSON_SnapshotSize(&view, root); ++i) {
+    const char* key = NULL;
+    const JSON_SnapshotNode value =
+        JSON_SnapshotObjectEntry(&view, root, i, &key);
+    ASSERT_NE(key, nullptr);
+    EXPECT_EQ(JSON_SnapshotObjectGet(&view, root, key), value);
+  }
+  JSON_SnapshotClose(&view);
+}
+
+TEST_F(JSON_SnapshotTest, MapsSnapshotFiles) {
+  char path[] = "/tmp/cjson-snapshot-XXXXXX";
+  const int fd = mkstemp(path);
+  ASSERT_NE(fd, -1);
+  ASSERT_EQ(write(fd, snapshot.data, snapshot.length),
+            (ssize_t)snapshot.length);
+  close(fd);
+
+  JSON_Snapshot mapped;
+  ASSERT_EQ(JSON_SnapshotOpen(&mapped, path), TRUE);
+  EXPECT_EQ(mapped.mapped, TRUE);
+  const JSON_SnapshotNode root = JSON_SnapshotRoot(&mapped);
+  EXPECT_EQ(
+      JSON_SnapshotNumber(&mapped, JSON_SnapshotObjectGet(&mapped, root, "id")),
+      -42);
+  JSON_SnapshotClose(&mapped);
+  EXPECT_EQ(mapped.data, nullptr);
+  unlink(path);
+
+  EXPECT_EQ(JSON_SnapshotOpen(&mapped, path), FALSE);
+}
+
+TEST_F(JSON_SnapshotTest, RejectsCorruptSnapshots) {
+  JSON_Snapshot view;
+  EXPECT_EQ(JSON_SnapshotFromBuffer(&view, snapshot.data, 16), FALSE);
+  EXPECT_EQ(JSON_SnapshotFromBuffer(&view, snapshot.data, snapshot.length - 8),
+            FALSE);
+  snapshot.data[0] = 'C';
+  EXPECT_EQ(JSON_SnapshotFromBuffer(&view, snapshot.data, snapshot.length),
+            FALSE);
+  snapshot.data[0] = 'c';
+  // A header whose length leaves no room for the root node.
+  u_int64_t length = 16;
+  std::memcpy(snapshot.data + 16, &length, sizeof(length));
+  EXPECT_EQ(JSON_SnapshotFromBuffer(&view, snapshot.data, snapshot.length),
+            FALSE);
+  length = snapshot.length;
+  std::memcpy(snapshot.data + 16, &length, sizeof(length));
+
+  // Offsets pointing outside the snapshot read as missing nodes.
+  ASSERT_EQ(JSON_SnapshotFromBuffer(&view, snapshot.data, snapshot.length),
+            TRUE);
+  EXPECT_EQ(JSON_SnapshotType(&view, snapshot.length), JSON_Null);
+  EXPECT_EQ(JSON_SnapshotType(&view, 12), JSON_Null);
+  EXPECT_EQ(JSON_SnapshotString(&view, JSON_SNAPSHOT_NONE, NULL), nullptr);
+  const u_int64_t root = JSON_SnapshotRoot(&view) + 2 * snapshot.length;
+  std::memcpy(snapshot.data + 24, &root, sizeof(root));
+  EXPECT_EQ(JSON_SnapshotType(&view, JSON_SnapshotRoot(&view)), JSON_Null);
+  EXPECT_EQ(JSON_SnapshotObjectGet(&view, JSON_SnapshotRoot(&view), "id"),
+            JSON_SNAPSHOT_NONE);
+}
+
+TEST(JSON_SnapshotWriteTest, FailsWhenTheStreamCanNotGrow) {
+  std::size_t limit = 16;
+  const Allocator limited =
+      cjson::testing::allocator::utils::LimitedAllocator(&limit);
+  StringStream sstream = StringStreamNAllocWithAllocator(0, &limited);
+  std::string text(200, 'a');
+  JSON string = JSON_InitStringViewImpl(&text[0], text.size());
+  // Neither the header nor, once it fits, the string fits the stream.
+  EXPECT_EQ(JSON_SnapshotWrite(&sstream, &string), FALSE);
+  EXPECT_EQ(sstream.length, 0);
+  limit = 128;
+  EXPECT_EQ(JSON_SnapshotWrite(&sstream, &string), FALSE);
+  EXPECT_EQ(sstream.length, 0);
+  StringStreamDealloc(&sstream);
+}
+
+#endif  // CJSON_TESTS_CJSON_TESTSNAPSHOT_HH_
@@ -0,0 +1,121 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CJSON_TESTS_CJSON_TESTSTATS_HH_
+#define CJSON_TESTS_CJSON_TESTSTATS_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "allocator.h"
+#include "bool.h"
+#include "cjson.h"
+#include "modifiers.h"
+#include "ref.h"
+#include "stats.h"
+
+TEST(JSON_MemoryStatsTest, CountsEveryCategory) {
+  static const char kName[] = "a name longer than sixteen bytes";
+  JSON list = JSON_INIT_TYPE(List);
+  JSON_LIST_ADD_VAL(Number, &list, 1);
+  JSON_LIST_ADD_VAL(Bool, &list, TRUE);
+  JSON values = JSON_InitValueListImpl(4);
+  JSON_LIST_ADD_VAL(Number, &values, 1);
+  JSON_LIST_ADD(Null, &values);
+  JSON shared = JSON_INIT_TYPE(List);
+  JSON_LIST_ADD_VAL(Bool, &shared, TRUE);
+  JSON_Ref ref = JSON_RefNew(&shared);
+
+  JSON root = JSON_INIT_TYPE(Object);
+  JSON_OBJECT_PUT_VAL(String, &root, strdup("name"), JSON_STRINGIFY(kName));
+  JSON* node = JSON_AllocType(JSON_Null);
+  *node = list;
+  JSON_ObjectPut(&root, strdup("list"), node);
+  node = JSON_AllocType(JSON_Null);
+  *node = values;
+  JSON_ObjectPut(&root, strdup("values"), node);
+  JSON_ObjectPut(&root, strdup("shared"), JSON_RefAttach(ref));
+
+  const JSON_MemoryUsage usage = JSON_MemoryStats(&root);
+  // The root, the three unshared object values and the two pointer list
+  // elements.
+  EXPECT_EQ(usage.nodes, 6 * sizeof(JSON));
+  EXPECT_EQ(usage.entries, 4 * sizeof(MapEntry));
+  EXPECT_EQ(usage.buckets, MapBucketsSize(root.value.object.bucketslen));
+  EXPECT_EQ(usage.vectors, list.value.list.capacity * sizeof(void*) +
+                               4 * sizeof(JSON));
+  EXPECT_EQ(usage.unused, (list.value.list.capacity - 2) * sizeof(void*) +
+                              2 * sizeof(JSON));
+  EXPECT_EQ(usage.strings, sizeof(kName) + sizeof("name") + sizeof("list") +
+                               sizeof("values") + sizeof("shared"));
+  EXPECT_EQ(usage.total,
+            usage.nodes + usage.buckets + usage.vectors + usage.strings);
+  EXPECT_EQ(usage.shared, 1u);
+  EXPECT_EQ(usage.types[JSON_Object], 1u);
+  EXPECT_EQ(usage.types[JSON_List], 2u);
+  EXPECT_EQ(usage.types[JSON_Number], 2u);
+  EXPECT_EQ(usage.types[JSON_Boolean], 1u);
+  EXPECT_EQ(usage.types[JSON_Null], 1u);
+  EXPECT_EQ(usage.types[JSON_String], 1u);
+
+  JSON_FreeDeep(&root);
+  JSON_RefRelease(&ref);
+}
+
+TEST(JSON_MemoryStatsTest, ScalarsHoldNoMemoryOfTheirOwn) {
+  JSON json = JSON_INIT_VAL(Number, 42);
+  const JSON_MemoryUsage usage = JSON_MemoryStats(&json);
+  EXPECT_EQ(usage.total, sizeof(JSON));
+  EXPECT_EQ(usage.types[JSON_Number], 1u);
+  EXPECT_EQ(JSON_MemoryStats(NULL).total, 0u);
+}
+
+TEST(AllocatorCountingTest, TracksTheBytesOfLiveTrees) {
+  AllocatorCounter counter;
+  Allocator counting = AllocatorCounting(&counter, NULL);
+  AllocatorSetDefault(&counting);
+  JSON json = JSON_INIT_TYPE(List);
+  for (int i = 0; i < 100; ++i) {
+    JSON* record = JSON_AllocType(JSON_Object);
+    char* key = (char*)AllocatorMalloc(NULL, sizeof("id"));
+    std::strcpy(key, "id");
+    JSON_OBJECT_PUT_VAL(Number, record, key, i);
+    JSON_ListAdd(&json, record);
+  }
+  // The root lives on the stack, everything under it went through `counting`.
+  EXPECT_EQ(AllocatorCounterBytes(&counter) + sizeof(JSON),
+            JSON_MemoryStats(&json).total);
+  EXPECT_GT(AllocatorCounterBlocks(&counter), 100u);
+  JSON_FreeDeep(&json);
+  EXPECT_EQ(AllocatorCounterBytes(&counter), 0u);
+  EXPECT_EQ(AllocatorCounterBlocks(&counter), 0u);
+  AllocatorSetDefault(NULL);
+}
+
+#endif  // CJSON_TESTS_CJSON_TESTSTATS_HH_
@@ -0,0 +1,150 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_TESTS_CJSON_TESTWRITER_HH_
+#define CJSON_TESTS_CJSON_TESTWRITER_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "../allocator/utils.hh"
+#include "allocator.h"
+#include "bool.h"
+#include "data/sstream/sstream.h"
+#include "writer.h"
+
+class JSON_WriterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    sstream = StringStreamAlloc();
+    JSON_WriterInit(&writer, &sstream);
+  }
+
+  void TearDown() override { StringStreamDealloc(&sstream); }
+
+ protected:
+  StringStream sstream;
+  JSON_Writer writer;
+};
+
+TEST_F(JSON_WriterTest, WritesNestedContainersWithCommas) {
+  JSON_WriterBeginObject(&writer);
+  JSON_WriterKey(&writer, "id");
+  JSON_WriterNumber(&writer, INT64_MIN);
+  JSON_WriterKey(&writer, "tags");
+  JSON_WriterBeginList(&writer);
+  JSON_WriterString(&writer, "a");
+  JSON_WriterBool(&writer, TRUE);
+  JSON_WriterNull(&writer);
+  JSON_WriterBeginList(&writer);
+  JSON_WriterEndList(&writer);
+  JSON_WriterEndList(&writer);
+  JSON_WriterKey(&writer, "ratio");
+  JSON_WriterDecimal(&writer, 0.5);
+  JSON_WriterKey(&writer, "empty");
+  JSON_WriterBeginObject(&writer);
+  JSON_WriterEndObject(&writer);
+  JSON_WriterEndObject(&writer);
+  ASSERT_EQ(JSON_WriterFinish(&writer), TRUE);
+  EXPECT_STREQ(sstream.data,
+               "{\"id\":-9223372036854775808,\"tags\":[\"a\",true,null,[]],"
+               "\"ratio\":0.5,\"empty\":{}}");
+}
+
+TEST_F(JSON_WriterTest, EscapesKeysAndStrings) {
+  JSON_WriterBeginObject(&writer);
+  JSON_WriterKey(&writer, "a\"b");
+  JSON_WriterString(&writer, "line\nbreak\t\\ \x01");
+  JSON_WriterEndObject(&writer);
+  ASSERT_EQ(JSON_WriterFinish(&writer), TRUE);
+  EXPECT_STREQ(sstream.data,
+               "{\"a\\\"b\":\"line\\nbreak\\t\\\\ \\u0001\"}");
+}
+
+TEST_F(JSON_WriterTest, KeepsIntegralDecimalsDecimal) {
+  JSON_WriterDecimal(&writer, 3.0);
+  ASSERT_EQ(JSON_WriterFinish(&writer), TRUE);
+  EXPECT_STREQ(sstream.data, "3.0");
+}
+
+TEST_F(JSON_WriterTest, FailsWhenAValueIsWrittenWithoutAKey) {
+  JSON_WriterBeginObject(&writer);
+  JSON_WriterNumber(&writer, 1);
+  JSON_WriterEndObject(&writer);
+  EXPECT_EQ(JSON_WriterFinish(&writer), FALSE);
+}
+
+TEST_F(JSON_WriterTest, FailsOnMismatchedContainers) {
+  JSON_WriterBeginList(&writer);
+  JSON_WriterEndObject(&writer);
+  EXPECT_EQ(JSON_WriterFinish(&writer), FALSE);
+}
+
+TEST_F(JSON_WriterTest, FailsWhenTheDocumentIsIncomplete) {
+  JSON_WriterBeginList(&writer);
+  EXPECT_EQ(JSON_WriterFinish(&writer), FALSE);
+}
+
+TEST_F(JSON_WriterTest, FailsWhenTheStreamCanNotGrow) {
+  size_t limit = 64;
+  const Allocator limited =
+      cjson::testing::allocator::utils::LimitedAllocator(&limit);
+  StringStream small = StringStreamNAllocWithAllocator(16, &limited);
+  JSON_WriterInit(&writer, &small);
+  JSON_WriterString(&writer, std::string(200, 'a').c_str());
+  EXPECT_EQ(JSON_WriterFinish(&writer), FALSE);
+  EXPECT_LE(small.length, small.capacity);
+  StringStreamDealloc(&small);
+}
+
+static void AppendToString(void* const ctx, const char* const data,
+                           const size_t length) {
+  static_cast<std::string*>(ctx)->append(data, length);
+}
+
+TEST_F(JSON_WriterTest, HandsTheOutputToTheSink) {
+  std::string output;
+  JSON_WriterInitSink(&writer, &sstream, AppendToString, &output);
+  std::string expected = "[";
+  JSON_WriterBeginList(&writer);
+  for (int i = 0; i < 2000; ++i) {
+    JSON_WriterNumber(&writer, i);
+    expected += std::to_string(i) + ",";
+  }
+  expected.back() = ']';
+  JSON_WriterEndList(&writer);
+  ASSERT_EQ(JSON_WriterFinish(&writer), TRUE);
+  EXPECT_EQ(output, expected);
+  EXPECT_LT(sstream.capacity, output.size());
+}
+
+#endif  // CJSON_TESTS_CJSON_TESTWRITER_HH_
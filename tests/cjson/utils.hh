@@ -0,0 +1,65 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_TESTS_CJSON_UTILS_HH_
+#define CJSON_TESTS_CJSON_UTILS_HH_
+
+#include <cstddef>
+
+#include "allocator.h"
+#include "cjson.h"
+#include "modifiers.h"
+
+namespace cjson {
+namespace testing {
+namespace cjson {
+namespace utils {
+// Puts the fields of the `i`th record into the empty object `record`.
+typedef void (*RecordFields)(JSON* const record, const std::size_t i);
+
+// Returns a list of `rows` objects whose fields are put by `fields`.
+//
+// Records come from the process-wide allocator, as should the keys `fields`
+// puts, so the list is released with `JSON_FreeDeep()`.
+JSON Records(const std::size_t rows, const RecordFields fields) {
+  JSON list = JSON_INIT_TYPE_SIZE(List, rows);
+  for (std::size_t i = 0; i < rows; ++i) {
+    JSON* record = (JSON*)AllocatorMalloc(NULL, sizeof(JSON));
+    *record = JSON_INIT_TYPE(Object);
+    fields(record, i);
+    JSON_ListAdd(&list, record);
+  }
+  return list;
+}
+}  // namespace utils
+}  // namespace cjson
+}  // namespace testing
+}  // namespace cjson
+
+#endif  // CJSON_TESTS_CJSON_UTILS_HH_
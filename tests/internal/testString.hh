@@ -61,6 +61,16 @@ TEST(SplitStrFunctionTest, WhenMultipleCharactersAreUsedAsSeparator) {
   std::free(comps);
 }
 
+TEST(SplitStrFunctionTest, WhenComponentsAndTheArrayAreTerminated) {
+  char** comps = SplitStr("/foo/bar/", "/");
+  EXPECT_STREQ(comps[0], "foo");
+  EXPECT_STREQ(comps[1], "bar");
+  EXPECT_EQ(comps[2], nullptr);
+  for (size_t i = 0; comps[i]; ++i)
+    std::free(comps[i]);
+  std::free(comps);
+}
+
 TEST(JoinStrFunctionTest, WhenSingleCharacterIsUsedAsSeparator) {
   char joined_str[100];
   const char* const comps[] = {"foo", "bar", "foo", "buzz"};
@@ -0,0 +1,133 @@
+// Copyright 2021, The cjson authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of The cjson authors. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CJSON_TESTS_MAP_TESTINTERN_HH_
+#define CJSON_TESTS_MAP_TESTINTERN_HH_
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "bool.h"
+#include "data/map/intern.h"
+#include "data/map/map.h"
+#include "data/map/ops.h"
+
+TEST(KeyPoolTest, TestEqualKeysShareOneCanonicalCopy) {
+  KeyPool pool = KeyPoolAlloc();
+  EXPECT_EQ(pool.slots, nullptr);
+  std::string first("country"), second("country");
+  const char* canonical = KeyPoolIntern(&pool, first.c_str());
+  ASSERT_NE(canonical, nullptr);
+  EXPECT_NE(canonical, first.c_str());
+  EXPECT_STREQ(canonical, "country");
+  EXPECT_EQ(KeyPoolIntern(&pool, second.c_str()), canonical);
+  EXPECT_EQ(KeyPoolInternN(&pool, "country-code", 7), canonical);
+  EXPECT_EQ(KeyPoolIntern(&pool, canonical), canonical);
+  EXPECT_EQ(pool.length, 1);
+  EXPECT_EQ(KeyPoolKeyHash(canonical), Hash("country"));
+  EXPECT_EQ(KeyPoolKeyLength(canonical), 7);
+  KeyPoolFree(&pool);
+  EXPECT_EQ(pool.slots, nullptr);
+  EXPECT_EQ(pool.length, 0);
+}
+
+TEST(KeyPoolTest, TestFindNeverInterns) {
+  KeyPool pool = KeyPoolAlloc();
+  EXPECT_EQ(KeyPoolFind(&pool, "id"), nullptr);
+  const char* canonical = KeyPoolIntern(&pool, "id");
+  EXPECT_EQ(KeyPoolFind(&pool, "id"), canonical);
+  EXPECT_EQ(KeyPoolFind(&pool, "name"), nullptr);
+  EXPECT_EQ(pool.length, 1);
+  KeyPoolFree(&pool);
+}
+
+TEST(KeyPoolTest, TestKeysSurviveTheTableGrowing) {
+  KeyPool pool = KeyPoolAlloc();
+  const char* canonicals[1000];
+  char key[16];
+  for (size_t i = 0; i < 1000; ++i) {
+    std::snprintf(key, sizeof(key), "key%zu", i);
+    ASSERT_NE((canonicals[i] = KeyPoolIntern(&pool, key)), nullptr);
+  }
+  EXPECT_EQ(pool.length, 1000);
+  EXPECT_GT(pool.capacity, 1000);
+  for (size_t i = 0; i < 1000; ++i) {
+    std::snprintf(key, sizeof(key), "key%zu", i);
+    EXPECT_EQ(KeyPoolIntern(&pool, key), canonicals[i]);
+  }
+  EXPECT_EQ(pool.length, 1000);
+  KeyPoolFree(&pool);
+}
+
+TEST(KeyPoolTest, TestInternedKeysWorkWithPrecomputedHashes) {
+  KeyPool pool = KeyPoolAlloc();
+  Map map = MapAllocStrAsKey();
+  int values[2] = {1, 2};
+  const char* id = KeyPoolIntern(&pool, "id");
+  const char* name = KeyPoolIntern(&pool, "name");
+  MapPutWithHash(&map, (void*)id, &values[0], KeyPoolKeyHash(id));
+  MapPutWithHash(&map, (void*)name, &values[1], KeyPoolKeyHash(name));
+  EXPECT_EQ(MapGetWithHash(&map, (void*)id, KeyPoolKeyHash(id)), &values[0]);
+  EXPECT_EQ(MapGetEntryWithHash(&map, (void*)name, KeyPoolKeyHash(name))->key,
+            name);
+  // Plain keys still find the interned ones.
+  EXPECT_EQ(MapGet(&map, (void*)"name"), &values[1]);
+  MapFree(&map);
+  KeyPoolFree(&pool);
+}
+
+TEST(KeyPoolTest, TestInternedKeysWorkWithPrecomputedLengths) {
+  KeyPool pool = KeyPoolAlloc();
+  Map map = MapAllocStrAsKey();
+  int values[2] = {1, 2};
+  const char* id = KeyPoolIntern(&pool, "id");
+  const char* name = KeyPoolInternN(&pool, "na\0me", 5);
+  MapPutNWithHash(&map, (void*)id, KeyPoolKeyLength(id), &values[0],
+                  KeyPoolKeyHash(id));
+  MapPutNWithHash(&map, (void*)name, KeyPoolKeyLength(name), &values[1],
+                  KeyPoolKeyHash(name));
+  EXPECT_EQ(MapGetNWithHash(&map, (void*)id, KeyPoolKeyLength(id),
+                            KeyPoolKeyHash(id)),
+            &values[0]);
+  const MapEntry* entry = MapGetEntryNWithHash(
+      &map, (void*)name, KeyPoolKeyLength(name), KeyPoolKeyHash(name));
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->key, name);
+  EXPECT_EQ(entry->keylen, 5);
+  // The key holds a `NULL` character, a plain lookup stops short of it.
+  EXPECT_EQ(MapGet(&map, (void*)"na"), nullptr);
+  EXPECT_EQ(MapGetN(&map, (void*)"na\0me", 5), &values[1]);
+  MapFree(&map);
+  KeyPoolFree(&pool);
+}
+
+#endif  // CJSON_TESTS_MAP_TESTINTERN_HH_
@@ -32,9 +32,14 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdio>
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include "bool.h"
+#include "data/map/group.h"
+#include "data/map/iterators.h"
 #include "data/map/map.h"
 #include "data/map/ops.h"
 #include "utils.hh"
@@ -53,7 +58,7 @@ static bool_t CustomKeyCmp(const void* key1, const void* key2) { return TRUE; }
 TEST(MapMacrosTest,
      TestIfAnyExternalFlagWhileBuildingLibraryDidChangeTheValues) {
   EXPECT_EQ(MAX_LOAD_FACTOR, 0.75f);
-  EXPECT_EQ(MAP_DEFAULT_BUCKET_LEN, (1 << 4));
+  EXPECT_EQ(MAP_DEFAULT_BUCKET_LEN, (1 << 2));
 }
 
 TEST(MapEntryStructTest, TestSizeOfMapEntry) {
@@ -62,7 +67,7 @@ TEST(MapEntryStructTest, TestSizeOfMapEntry) {
 }
 
 TEST(MapTestStructTest, TestSizeOfMap) {
-  EXPECT_EQ(sizeof(Map), 40UL) << "Error: sizeof(Map) = " << sizeof(Map);
+  EXPECT_EQ(sizeof(Map), 48UL) << "Error: sizeof(Map) = " << sizeof(Map);
 }
 
 TEST(MapAllocEntryWithHashTest, TestWhenA16DigitsHashIsUsed) {
@@ -75,11 +80,10 @@ TEST(MapAllocEntryWithHashTest, TestWhenA16DigitsHashIsUsed) {
   EXPECT_STREQ((const char*)mapentry->key, key);
   EXPECT_STREQ((const char*)mapentry->value, value);
   EXPECT_EQ(mapentry->hash, 0xbabe7cee878d3e62);
-  EXPECT_EQ(mapentry->next, nullptr);
   delete mapentry;
 }
 
-TEST(MapAllocEntryWithHashTest, TestWhenMultipleEntriesAreLinkedTogether) {
+TEST(MapAllocEntryWithHashTest, TestWhenMultipleEntriesAreAllocated) {
   char key1[5], key2[5], key3[5];
   std::strcpy(key1, "key1");
   std::strcpy(key2, "key2");
@@ -98,9 +102,6 @@ TEST(MapAllocEntryWithHashTest, TestWhenMultipleEntriesAreLinkedTogether) {
   ASSERT_NE(mapentry2, nullptr);
   ASSERT_NE(mapentry3, nullptr);
 
-  mapentry1->next = mapentry2;
-  mapentry2->next = mapentry3;
-
   EXPECT_STREQ((const char*)mapentry1->key, key1);
   EXPECT_STREQ((const char*)mapentry1->value, value1);
 
@@ -114,10 +115,6 @@ TEST(MapAllocEntryWithHashTest, TestWhenMultipleEntriesAreLinkedTogether) {
   EXPECT_EQ(mapentry2->hash, 0x280f93cdf26cf053);
   EXPECT_EQ(mapentry3->hash, 0xd53239e006c95f4a);
 
-  EXPECT_EQ(mapentry1->next, mapentry2);
-  EXPECT_EQ(mapentry2->next, mapentry3);
-  EXPECT_EQ(mapentry3->next, nullptr);
-
   delete mapentry1;
   delete mapentry2;
   delete mapentry3;
@@ -131,8 +128,8 @@ TEST(MapAllocTest, TestWhenNullIsGivenAsArguments) {
   EXPECT_EQ(map.hash, Hash);
   EXPECT_EQ(map.keycmp, KeyCmp);
   for (size_t i = 0; i < map.bucketslen; ++i)
-    EXPECT_EQ(map.buckets[i], nullptr)
-        << "Bucket at index: " << i << " is not nullptr";
+    EXPECT_EQ(MapCtrl(&map)[i], MAP_CTRL_EMPTY)
+        << "Bucket at index: " << i << " is not empty";
   MapFree(&map);
 }
 
@@ -144,8 +141,8 @@ TEST(MapAllocTest, TestWhenDefaultFunctionsAreGivenAsArguments) {
   EXPECT_EQ(map.hash, Hash);
   EXPECT_EQ(map.keycmp, KeyCmp);
   for (size_t i = 0; i < map.bucketslen; ++i)
-    EXPECT_EQ(map.buckets[i], nullptr)
-        << "Bucket at index: " << i << " is not nullptr";
+    EXPECT_EQ(MapCtrl(&map)[i], MAP_CTRL_EMPTY)
+        << "Bucket at index: " << i << " is not empty";
   MapFree(&map);
 }
 
@@ -157,8 +154,8 @@ TEST(MapAllocTest, TestWhenCustomFunctionsAreGivenAsArguments) {
   EXPECT_EQ(map.hash, CustomHash);
   EXPECT_EQ(map.keycmp, CustomKeyCmp);
   for (size_t i = 0; i < map.bucketslen; ++i)
-    EXPECT_EQ(map.buckets[i], nullptr)
-        << "Bucket at index: " << i << " is not nullptr";
+    EXPECT_EQ(MapCtrl(&map)[i], MAP_CTRL_EMPTY)
+        << "Bucket at index: " << i << " is not empty";
   MapFree(&map);
 }
 
@@ -170,8 +167,8 @@ TEST(MapAllocNBucketsTest, TestWhenBucketsLenIsZeroAndFunctionsAreNull) {
   EXPECT_EQ(map.hash, Hash);
   EXPECT_EQ(map.keycmp, KeyCmp);
   for (size_t i = 0; i < map.bucketslen; ++i)
-    EXPECT_EQ(map.buckets[i], nullptr)
-        << "Bucket at index: " << i << " is not nullptr";
+    EXPECT_EQ(MapCtrl(&map)[i], MAP_CTRL_EMPTY)
+        << "Bucket at index: " << i << " is not empty";
   MapFree(&map);
 }
 
@@ -184,8 +181,8 @@ TEST(MapAllocNBucketsTest,
   EXPECT_EQ(map.hash, Hash);
   EXPECT_EQ(map.keycmp, KeyCmp);
   for (size_t i = 0; i < map.bucketslen; ++i)
-    EXPECT_EQ(map.buckets[i], nullptr)
-        << "Bucket at index: " << i << " is not nullptr";
+    EXPECT_EQ(MapCtrl(&map)[i], MAP_CTRL_EMPTY)
+        << "Bucket at index: " << i << " is not empty";
   MapFree(&map);
 }
 
@@ -197,8 +194,8 @@ TEST(MapAllocNBucketsTest, TestWhenBucketsLenIsGivenAndFunctionsAreCustomOnes) {
   EXPECT_EQ(map.hash, CustomHash);
   EXPECT_EQ(map.keycmp, CustomKeyCmp);
   for (size_t i = 0; i < map.bucketslen; ++i)
-    EXPECT_EQ(map.buckets[i], nullptr)
-        << "Bucket at index: " << i << " is not nullptr";
+    EXPECT_EQ(MapCtrl(&map)[i], MAP_CTRL_EMPTY)
+        << "Bucket at index: " << i << " is not empty";
   MapFree(&map);
 }
 
@@ -210,8 +207,8 @@ TEST(MapAllocNEntriesTest, TestWhenEntriesLenGivenIsZero) {
   EXPECT_EQ(map.hash, Hash);
   EXPECT_EQ(map.keycmp, KeyCmp);
   for (size_t i = 0; i < map.bucketslen; ++i)
-    EXPECT_EQ(map.buckets[i], nullptr)
-        << "Bucket at index: " << i << " is not nullptr";
+    EXPECT_EQ(MapCtrl(&map)[i], MAP_CTRL_EMPTY)
+        << "Bucket at index: " << i << " is not empty";
   MapFree(&map);
 }
 
@@ -226,8 +223,8 @@ TEST(MapAllocNEntriesTest,
   EXPECT_EQ(map.hash, Hash);
   EXPECT_EQ(map.keycmp, KeyCmp);
   for (size_t i = 0; i < map.bucketslen; ++i)
-    EXPECT_EQ(map.buckets[i], nullptr)
-        << "Bucket at index: " << i << " is not nullptr";
+    EXPECT_EQ(MapCtrl(&map)[i], MAP_CTRL_EMPTY)
+        << "Bucket at index: " << i << " is not empty";
   MapFree(&map);
 }
 
@@ -286,4 +283,333 @@ TEST_F(MapTest, TestMapRemoveFunctionWhenAllocatedWithMapAllocStrAsKey) {
   ASSERT_EQ(MapGet(&map, ayush), (void*)0);
 }
 
+TEST_F(MapTest, TestMapIteratorStopsAfterTheLastBucket) {
+  map = MapAllocNBuckets(MAP_DEFAULT_BUCKET_LEN, CustomHash, KeyCmp);
+
+  // `CustomHash()` maps "o" to the last of the default buckets.
+  char first[2] = "a", last[2] = "o";
+  MapPut(&map, first, first);
+  MapPut(&map, last, last);
+
+  size_t count = 0;
+  MapIterator map_it = MapIteratorNew(&map);
+  while (MapIteratorNext(&map_it))
+    ++count;
+  EXPECT_EQ(count, 2);
+  EXPECT_EQ(MapIteratorNext(&map_it), nullptr);
+}
+
+TEST_F(MapTest, TestMapPutKeepsCollidingEntriesSortedByHash) {
+  map = MapAllocNBuckets(MAP_DEFAULT_BUCKET_LEN, CustomHash, KeyCmp);
+
+  // `CustomHash()` maps every key to the same bucket, with decreasing hashes.
+  char key1[2] = "q", key2[2] = "a", key3[2] = "A";
+  MapPut(&map, key1, key1);
+  MapPut(&map, key2, key2);
+  MapPut(&map, key3, key3);
+
+  EXPECT_EQ(map.entrieslen, 3);
+  EXPECT_EQ(MapGet(&map, key1), key1);
+  EXPECT_EQ(MapGet(&map, key2), key2);
+  EXPECT_EQ(MapGet(&map, key3), key3);
+}
+
+TEST_F(MapTest, TestMapPutOverridesTheValueOfAnExistingKey) {
+  map = MapAllocStrAsKey();
+
+  // Overriding allocates no entry, none is left behind for `MapFree()`.
+  char key[4] = "key", value1[2] = "1", value2[2] = "2";
+  for (int i = 0; i < 10; ++i)
+    MapPut(&map, key, i % 2 ? value1 : value2);
+
+  EXPECT_EQ(map.entrieslen, 1);
+  EXPECT_EQ(MapGet(&map, key), value1);
+}
+
+TEST_F(MapTest, TestMapPutWhenTheLoadFactorIsExceeded) {
+  map = MapAllocStrAsKey();
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < 100; ++i)
+    keys.push_back("key" + std::to_string(i));
+  for (std::string& key : keys)
+    MapPut(&map, (void*)key.c_str(), (void*)key.c_str());
+
+  EXPECT_EQ(map.entrieslen, 100);
+  EXPECT_EQ(map.bucketslen, MapComputeBucketsLen(100));
+  for (std::string& key : keys)
+    ASSERT_EQ(MapGet(&map, (void*)key.c_str()), key.c_str()) << key;
+}
+
+TEST_F(MapTest, TestMapPutEntryStoresCollidingEntries) {
+  map = MapAllocStrAsKey();
+
+  char key1[2] = "a", key2[2] = "b", key3[2] = "c";
+  MapEntry entry1 = {.key = key1, .value = key1, .hash = 0x30, .keylen = 1};
+  MapEntry entry2 = {.key = key2, .value = key2, .hash = 0x10, .keylen = 1};
+  MapEntry entry3 = {.key = key3, .value = key3, .hash = 0x20, .keylen = 1};
+  // Every hash maps to the first group, the entries are copied into it.
+  MapEntry* stored1 = MapPutEntry(&map, &entry1);
+  MapEntry* stored2 = MapPutEntry(&map, &entry2);
+  MapEntry* stored3 = MapPutEntry(&map, &entry3);
+  ASSERT_NE(stored1, nullptr);
+  ASSERT_NE(stored2, nullptr);
+  ASSERT_NE(stored3, nullptr);
+  EXPECT_NE(stored1, &entry1);
+  EXPECT_EQ(MapGetEntryWithHash(&map, key1, 0x30), stored1);
+  EXPECT_EQ(MapGetEntryWithHash(&map, key2, 0x10), stored2);
+  EXPECT_EQ(MapGetEntryWithHash(&map, key3, 0x20), stored3);
+  EXPECT_EQ(MapGetEntryWithHash(&map, key3, 0x30), nullptr);
+
+  MapEntry duplicate = {.key = key3, .value = key1, .hash = 0x20, .keylen = 1};
+  EXPECT_EQ(MapPutEntry(&map, &duplicate), stored3);
+  EXPECT_EQ(stored3->value, key1);
+  EXPECT_EQ(map.entrieslen, 3);
+}
+
+TEST_F(MapTest, TestMapPutNKeepsKeysHoldingNulCharacters) {
+  map = MapAllocStrAsKey();
+
+  // Every key starts with the same `NULL` terminated string.
+  const char keys[] = "key\0one\0key\0two";
+  char value1[] = "value1", value2[] = "value2", value3[] = "value3";
+  MapPutN(&map, (void*)keys, 7, value1);
+  MapPutN(&map, (void*)(keys + 8), 7, value2);
+  MapPut(&map, (void*)keys, value3);
+  EXPECT_EQ(map.entrieslen, 3);
+
+  EXPECT_EQ(MapGetN(&map, (void*)keys, 7), value1);
+  EXPECT_EQ(MapGetN(&map, (void*)(keys + 8), 7), value2);
+  EXPECT_EQ(MapGet(&map, (void*)"key"), value3);
+  EXPECT_EQ(MapGetN(&map, (void*)"key\0one", 8), nullptr);
+  EXPECT_EQ(MapGetEntryN(&map, (void*)"key\0one", 7)->keylen, 7);
+  EXPECT_EQ(MapGetEntry(&map, (void*)"key")->keylen, 3);
+
+  EXPECT_EQ(MapRemoveN(&map, (void*)"key\0one", 7), value1);
+  EXPECT_EQ(MapGetN(&map, (void*)keys, 7), nullptr);
+  EXPECT_EQ(MapGet(&map, (void*)"key"), value3);
+  EXPECT_EQ(map.entrieslen, 2);
+}
+
+static hash_t ZeroHash(const void* const) { return 0; }
+
+TEST_F(MapTest, TestMapRemoveKeepsProbesGoingPastFullGroups) {
+  map = MapAllocNBuckets(4 * MAP_GROUP_WIDTH, ZeroHash, KeyCmp);
+  std::vector<std::string> keys;
+  for (int i = 0; i < MAP_GROUP_WIDTH + 4; ++i)
+    keys.push_back("key" + std::to_string(i));
+  // Every key hashes to the first group, the last ones spill into the next.
+  for (std::string& key : keys)
+    MapPut(&map, &key[0], &key[0]);
+  ASSERT_EQ(map.bucketslen, 4 * MAP_GROUP_WIDTH);
+
+  // The first group is full, the bucket is only marked deleted.
+  EXPECT_EQ(MapRemove(&map, &keys[0][0]), &keys[0][0]);
+  EXPECT_EQ(MapCtrl(&map)[0], MAP_CTRL_DELETED);
+  for (size_t i = 1; i < keys.size(); ++i)
+    EXPECT_EQ(MapGet(&map, &keys[i][0]), &keys[i][0]);
+  EXPECT_EQ(MapGet(&map, &keys[0][0]), nullptr);
+
+  // The second group has empty buckets left, the bucket becomes empty again.
+  const std::string last = keys.back();
+  EXPECT_EQ(MapRemove(&map, &keys.back()[0]), &keys.back()[0]);
+  EXPECT_EQ(MapGet(&map, (void*)last.c_str()), nullptr);
+
+  // The deleted bucket is the first free one of the probe sequence.
+  char key[] = "new";
+  MapPut(&map, key, key);
+  EXPECT_EQ(map.buckets[MapIndexGet(&map, 0)].key, key);
+  EXPECT_EQ(MapCtrl(&map)[0] & MAP_CTRL_FULL, MAP_CTRL_FULL);
+  EXPECT_EQ(map.entrieslen, keys.size() - 1);
+}
+
+TEST_F(MapTest, TestMapIteratesInTheOrderOfInsertion) {
+  map = MapAllocStrAsKey();
+  std::vector<std::string> keys;
+  for (int i = 0; i < 100; ++i)
+    keys.push_back("key" + std::to_string(i));
+  for (std::string& key : keys)
+    MapPut(&map, &key[0], &key[0]);
+  ASSERT_GT(map.bucketslen, MAP_DEFAULT_BUCKET_LEN);
+
+  // Overriding a value keeps the place of its key, a key put back after its
+  // removal goes last.
+  std::vector<std::string*> order;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (i % 3 == 1)
+      EXPECT_EQ(MapRemove(&map, &keys[i][0]), &keys[i][0]);
+    else
+      order.push_back(&keys[i]);
+  }
+  MapPut(&map, &keys[0][0], &keys[1][0]);
+  MapPut(&map, &keys[1][0], &keys[1][0]);
+  order.push_back(&keys[1]);
+
+  MapEntry* current = NULL;
+  MapIterator map_it = MapIteratorNew(&map);
+  for (std::string* key : order) {
+    ASSERT_NE(current = MapIteratorNext(&map_it), nullptr);
+    EXPECT_EQ(current->key, &(*key)[0]);
+  }
+  EXPECT_EQ(MapIteratorNext(&map_it), nullptr);
+  EXPECT_EQ(MapGet(&map, &keys[0][0]), &keys[1][0]);
+
+  // Shrinking drops the holes and keeps the order.
+  EXPECT_EQ(MapShrink(&map), TRUE);
+  EXPECT_EQ(*MapEntriesUsed(&map), map.entrieslen);
+  map_it = MapIteratorNew(&map);
+  for (std::string* key : order)
+    EXPECT_EQ(MapIteratorNext(&map_it)->key, &(*key)[0]);
+}
+
+TEST_F(MapTest, TestMapKeepsFewEntriesInASmallMapUntilItOutgrowsIt) {
+  map = MapAllocStrAsKey();
+  char keys[MAP_GROUP_WIDTH / 2 + 1][4];
+  for (size_t i = 0; i < MAP_GROUP_WIDTH / 2; ++i) {
+    std::snprintf(keys[i], sizeof(keys[i]), "k%zu", i);
+    MapPut(&map, keys[i], keys[i]);
+  }
+  // Every bucket of a small map holds the entry of the same place.
+  ASSERT_EQ(map.bucketslen, MAP_GROUP_WIDTH / 2);
+  EXPECT_EQ(MapIndexWidth(map.bucketslen), 0);
+  EXPECT_EQ(MapBucketsSize(map.bucketslen),
+            MAP_GROUP_WIDTH / 2 * sizeof(MapEntry) + MAP_GROUP_WIDTH +
+                sizeof(size_t) + sizeof(MapMigration*));
+  for (size_t i = 0; i < MAP_GROUP_WIDTH / 2; ++i) {
+    EXPECT_EQ(MapGet(&map, (void*)keys[i]), keys[i]);
+    EXPECT_EQ(MapCtrl(&map)[i], MapCtrlTag(map.buckets[i].hash));
+  }
+  EXPECT_EQ(MapGet(&map, (void*)"k8"), nullptr);
+
+  // A removal leaves a hole whose control byte no lookup matches.
+  EXPECT_EQ(MapRemove(&map, keys[2]), keys[2]);
+  EXPECT_EQ(MapCtrl(&map)[2], MAP_CTRL_EMPTY);
+  EXPECT_EQ(MapGet(&map, keys[2]), nullptr);
+
+  // The next key finds no entry left and turns it into a hash table, dropping
+  // the hole and keeping the order.
+  std::snprintf(keys[MAP_GROUP_WIDTH / 2], sizeof(keys[0]), "k%d",
+                MAP_GROUP_WIDTH / 2);
+  MapPut(&map, keys[MAP_GROUP_WIDTH / 2], keys[MAP_GROUP_WIDTH / 2]);
+  EXPECT_GE(map.bucketslen, MAP_GROUP_WIDTH);
+  EXPECT_EQ(*MapMigrationOf(&map), nullptr);
+  EXPECT_EQ(*MapEntriesUsed(&map), MAP_GROUP_WIDTH / 2);
+  size_t order[] = {0, 1, 3, 4, 5, 6, 7, 8};
+  MapIterator map_it = MapIteratorNew(&map);
+  for (size_t i : order) {
+    EXPECT_EQ(MapIteratorNext(&map_it)->key, keys[i]);
+    EXPECT_EQ(MapGet(&map, keys[i]), keys[i]);
+  }
+}
+
+TEST_F(MapTest, TestMapPutMovesTheEntriesOfGrowingMapsIncrementally) {
+  map = MapAllocStrAsKey();
+  std::vector<std::string> keys;
+  for (int i = 0; i < 97; ++i)
+    keys.push_back("key" + std::to_string(i));
+  for (std::string& key : keys)
+    MapPut(&map, &key[0], &key[0]);
+
+  // The last key outgrew the buckets, only the first entries were moved.
+  const MapMigration* const migration = *MapMigrationOf(&map);
+  ASSERT_NE(migration, nullptr);
+  EXPECT_EQ(migration->moved, MAP_MIGRATE_STEP);
+  EXPECT_EQ(migration->reserved, keys.size() - 1);
+  EXPECT_EQ(MapAllocatedSize(&map), MapBucketsSize(map.bucketslen) +
+                                        MapBucketsSize(migration->bucketslen) +
+                                        sizeof(MapMigration));
+  for (std::string& key : keys)
+    EXPECT_EQ(MapGet(&map, &key[0]), &key[0]) << key;
+
+  // Keys are removed from either buckets, the order is kept across both.
+  EXPECT_EQ(MapRemove(&map, &keys[10][0]), &keys[10][0]);
+  EXPECT_EQ(MapRemove(&map, &keys[80][0]), &keys[80][0]);
+  EXPECT_EQ(MapGet(&map, &keys[80][0]), nullptr);
+  std::vector<std::string*> order;
+  for (size_t i = 0; i < keys.size(); ++i)
+    if (i != 10 && i != 80)
+      order.push_back(&keys[i]);
+  MapIterator map_it = MapIteratorNew(&map);
+  for (std::string* key : order)
+    EXPECT_EQ(MapIteratorNext(&map_it)->key, &(*key)[0]);
+  EXPECT_EQ(MapIteratorNext(&map_it), nullptr);
+
+  EXPECT_EQ(MapMigrate(&map, 1), TRUE);
+  EXPECT_EQ(MapMigrate(&map, (size_t)-1), FALSE);
+  EXPECT_EQ(*MapMigrationOf(&map), nullptr);
+  EXPECT_EQ(MapAllocatedSize(&map), MapBucketsSize(map.bucketslen));
+  EXPECT_EQ(map.entrieslen, order.size());
+  map_it = MapIteratorNew(&map);
+  for (std::string* key : order) {
+    EXPECT_EQ(MapIteratorNext(&map_it)->key, &(*key)[0]);
+    EXPECT_EQ(MapGet(&map, &(*key)[0]), &(*key)[0]);
+  }
+  EXPECT_EQ(MapIteratorNext(&map_it), nullptr);
+}
+
+TEST_F(MapTest, TestMapShrinkReleasesTheBucketsLeftByRemovals) {
+  map = MapAllocStrAsKey();
+  std::vector<std::string> keys;
+  for (int i = 0; i < 100; ++i)
+    keys.push_back("key" + std::to_string(i));
+  for (std::string& key : keys)
+    MapPut(&map, &key[0], &key[0]);
+  const size_t peak = map.bucketslen;
+  ASSERT_GT(peak, MAP_DEFAULT_BUCKET_LEN);
+  for (size_t i = 4; i < keys.size(); ++i)
+    EXPECT_EQ(MapRemove(&map, &keys[i][0]), &keys[i][0]);
+  EXPECT_EQ(map.bucketslen, peak);
+
+  EXPECT_EQ(MapShrink(&map), TRUE);
+  EXPECT_EQ(map.bucketslen, MapComputeBucketsLen(4));
+  EXPECT_EQ(map.entrieslen, 4);
+  for (size_t i = 0; i < 4; ++i)
+    EXPECT_EQ(MapGet(&map, &keys[i][0]), &keys[i][0]);
+  EXPECT_EQ(MapShrink(&map), TRUE);
+}
+
+TEST(HashTest, TestHashMatchesHashNOverTheLengthOfTheKey) {
+  const std::string key(100, 'k');
+  for (size_t len = 0; len <= key.size(); ++len) {
+    const std::string prefix = key.substr(0, len);
+    EXPECT_EQ(Hash(prefix.c_str()), HashN(prefix.data(), len)) << len;
+  }
+  EXPECT_EQ(Hash(nullptr), 0);
+}
+
+TEST(HashTest, TestHashNSeesEveryByte) {
+  // Keys of every length hashing the same bytes but one, NUL bytes included.
+  for (size_t len = 1; len <= 100; ++len) {
+    std::string key(len, '\0');
+    const hash_t zeros = HashN(key.data(), len);
+    for (size_t i = 0; i < len; ++i) {
+      key[i] = 1;
+      EXPECT_NE(HashN(key.data(), len), zeros) << len << " " << i;
+      key[i] = 0;
+    }
+    EXPECT_NE(HashN(key.data(), len), HashN(key.data(), len - 1)) << len;
+  }
+}
+
+TEST(HashTest, TestHashSpreadsCollidingPolynomialKeys) {
+  // "Aa" and "BB" collide under `hash * 31 + c`, and so does any string made
+  // of them, which let crafted keys pile up in one bucket.
+  std::vector<std::string> keys = {""};
+  for (int round = 0; round < 10; ++round) {
+    std::vector<std::string> longer;
+    for (const std::string& key : keys) {
+      longer.push_back(key + "Aa");
+      longer.push_back(key + "BB");
+    }
+    keys.swap(longer);
+  }
+  std::vector<size_t> buckets(1024);
+  for (const std::string& key : keys)
+    ++buckets[Hash(key.c_str()) & (buckets.size() - 1)];
+  size_t fullest = 0;
+  for (size_t count : buckets)
+    fullest = count > fullest ? count : fullest;
+  EXPECT_LT(fullest, 16);
+}
+
 #endif  // CJSON_TESTS_MAP_TESTMAP_HH_
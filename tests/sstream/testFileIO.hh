@@ -112,10 +112,12 @@ TEST_F(StringStreamReadFileTest, WhenTestedIfTheCurrentFileIsReadCorrectly) {
   ASSERT_NE(sstream.capacity, 0);
   ASSERT_NE(sstream.data, nullptr);
   std::fseek(file, 0L, SEEK_SET);
-  char* current_file_content = new char[sstream.length];
+  char* current_file_content = new char[sstream.length + 1];
   std::fread(current_file_content, sizeof(char), sstream.length, file);
+  current_file_content[sstream.length] = '\0';
   std::fclose(file);
-  ASSERT_STREQ(sstream.data, current_file_content);
+  EXPECT_STREQ(sstream.data, current_file_content);
+  delete[] current_file_content;
 }
 
 #endif  // CJSON_TESTS_SSTREAM_TESTFILEIO_HH_
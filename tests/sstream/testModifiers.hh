@@ -33,7 +33,9 @@
 #include <gtest/gtest.h>
 
 #include <cstring>
+#include <string>
 
+#include "../allocator/utils.hh"
 #include "data/sstream/sstream.h"
 #include "utils.hh"
 
@@ -94,6 +96,31 @@ TEST_F(StringStreamConcatTest, WhenUsedAStrAllocatedStringStreamInstance) {
   ASSERT_EQ(sstream.capacity, capacity);
 }
 
+TEST_F(StringStreamConcatTest, WhenTheStringFillsTheBufferExactly) {
+  sstream = StringStreamAlloc();
+  const std::string teststr_(sstream.capacity, 'x');
+
+  StringStreamConcat(&sstream, "%s", teststr_.c_str());
+
+  // The terminator needs a byte of its own.
+  ASSERT_STREQ(sstream.data, teststr_.c_str());
+  ASSERT_EQ(sstream.length, teststr_.size());
+  ASSERT_GT(sstream.capacity, sstream.length);
+}
+
+TEST_F(StringStreamConcatTest, WhenTheStringIsOneByteShortOfTheBuffer) {
+  sstream = StringStreamAlloc();
+  const std::string teststr_(sstream.capacity - 1, 'x');
+
+  StringStreamConcat(&sstream, "%s", teststr_.c_str());
+
+  // `vsnprintf()` keeps the last byte for its terminator and truncates the
+  // string, which then has to be formatted again.
+  ASSERT_STREQ(sstream.data, teststr_.c_str());
+  ASSERT_EQ(sstream.length, teststr_.size());
+  ASSERT_EQ(std::strlen(sstream.data), sstream.length);
+}
+
 class StringStreamReadTest : public StringStreamModifiersTest {};
 
 TEST_F(StringStreamReadTest, WhenADefaultAllocatedStringStreamInstanceIsUsed) {
@@ -163,4 +190,31 @@ TEST_F(StringStreamReadTest, WhenAStrAllocatedStringStreamInstanceIsUsed) {
   ASSERT_EQ(sstream.capacity, capacity);
 }
 
+TEST_F(StringStreamReadTest, WhenTheDataFillsTheBufferExactly) {
+  sstream = StringStreamAlloc();
+  const std::string readstr(sstream.capacity, 'x');
+
+  StringStreamRead(&sstream, readstr.data(), readstr.size());
+
+  // The terminator needs a byte of its own.
+  ASSERT_STREQ(sstream.data, readstr.c_str());
+  ASSERT_EQ(sstream.length, readstr.size());
+  ASSERT_GT(sstream.capacity, sstream.length);
+}
+
+TEST_F(StringStreamReadTest, WhenTheBufferCanNotGrow) {
+  std::size_t limit = 16;
+  const Allocator limited =
+      cjson::testing::allocator::utils::LimitedAllocator(&limit);
+  sstream = StringStreamNAllocWithAllocator(4, &limited);
+  ASSERT_EQ(StringStreamRead(&sstream, "abc", 3), SSTREAM_READ_SUCCESS);
+  const std::string readstr(64, 'x');
+
+  // Nothing is copied past the end of the buffer that could not grow.
+  ASSERT_EQ(StringStreamRead(&sstream, readstr.data(), readstr.size()),
+            SSTREAM_READ_FAILURE);
+  ASSERT_STREQ(sstream.data, "abc");
+  ASSERT_EQ(sstream.length, 3);
+}
+
 #endif  // CJSON_TESTS_SSTREAM_TESTMODIFIERS_HH_
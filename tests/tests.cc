@@ -29,11 +29,18 @@
 
 #include <gtest/gtest.h>
 
+/* Header files including tests for `allocator` API. */
+#include "allocator/testAllocator.hh"
+
+/* Header files including tests for `arena` API. */
+#include "arena/testArena.hh"
+
 /* Header files including tests for `internal` API. */
 #include "internal/testFs.hh"
 #include "internal/testString.hh"
 
 /* Header files including tests for `map` API. */
+#include "map/testIntern.hh"
 #include "map/testMap.hh"
 
 /* Header files including tests for `sstream` API. */
@@ -50,7 +57,20 @@
 
 /* Header files including tests for `cjson` API. */
 #include "cjson/testAccessors.hh"
+#include "cjson/testCbor.hh"
+#include "cjson/testColumns.hh"
+#include "cjson/testCompact.hh"
 #include "cjson/testCjson.hh"
+#include "cjson/testClone.hh"
+#include "cjson/testDocument.hh"
+#include "cjson/testFormat.hh"
+#include "cjson/testMsgpack.hh"
+#include "cjson/testPacked.hh"
+#include "cjson/testReclaim.hh"
+#include "cjson/testRef.hh"
+#include "cjson/testSnapshot.hh"
+#include "cjson/testStats.hh"
+#include "cjson/testWriter.hh"
 
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
@@ -34,6 +34,8 @@
 
 #include <cstdlib>
 
+#include "../allocator/utils.hh"
+#include "data/vector/modifiers.h"
 #include "data/vector/vector.h"
 #include "utils.hh"
 
@@ -127,6 +129,33 @@ TEST_F(VectorResizeTest,
             VECTOR_RESIZE_SUCCESS);
 }
 
+class VectorShrinkTest : public VectorTest {};
+
+TEST_F(VectorShrinkTest, WhenTheVectorHoldsFewerElementsThanItsCapacity) {
+  vector = VectorAlloc(0);
+  int elems[5] = {1, 2, 3, 4, 5};
+  for (int i = 0; i < 5; ++i)
+    VectorPush(&vector, &elems[i]);
+  ASSERT_GT(vector.capacity, vector.size);
+  ASSERT_EQ(VectorShrink(&vector), VECTOR_RESIZE_SUCCESS);
+  EXPECT_EQ(vector.capacity, 5);
+  for (int i = 0; i < 5; ++i)
+    EXPECT_EQ(vector.data[i], &elems[i]);
+  ASSERT_EQ(VectorShrink(&vector), VECTOR_RESIZE_NOT_REQUIRED);
+}
+
+TEST_F(VectorShrinkTest, WhenTheVectorIsEmpty) {
+  vector = VectorAlloc(0);
+  ASSERT_EQ(VectorShrink(&vector), VECTOR_RESIZE_SUCCESS);
+  EXPECT_EQ(vector.data, nullptr);
+  EXPECT_EQ(vector.capacity, 0);
+  // An empty vector grows again on the next insertion.
+  int elem = 1;
+  VectorPush(&vector, &elem);
+  EXPECT_EQ(vector.size, 1);
+  EXPECT_EQ(vector.data[0], &elem);
+}
+
 class VectorCopyTest : public VectorTest {};
 
 TEST_F(VectorCopyTest, WhenZeroIsUsedAsSrcSize) {
@@ -178,6 +207,19 @@ TEST_F(VectorCopyTest, WhenArbitraryNumbersAreUsedAsElementsToSrcVector) {
   VectorFree(&dest);
 }
 
+TEST_F(VectorCopyTest, WhenNullIsUsedAsSrc) {
+  cjson::testing::allocator::utils::Counter counter = {0, 0, 0, 0};
+  const Allocator counting =
+      cjson::testing::allocator::utils::CountingAllocator(&counter);
+  vector = VectorAllocWithAllocator(0, &counting);
+  ASSERT_NE(vector.data, nullptr);
+  ASSERT_EQ(VectorCopy(&vector, NULL), VECTOR_COPY_SUCCESS);
+  EXPECT_EQ(vector.data, nullptr);
+  EXPECT_EQ(vector.size, 0);
+  // The buffer the destination held is released rather than dropped.
+  EXPECT_EQ(counter.live, 0);
+}
+
 class VectorClearTest : public VectorTest {};
 
 TEST_F(VectorClearTest, WhenElementsAreNotStoredInTheFreeStore) {
@@ -271,4 +313,17 @@ TEST_F(VectorFreeDeepTest, WhenVectorIsCopiedFromADynamicallyAllocatedArray) {
   ASSERT_EQ(vector.capacity, 0);
 }
 
+TEST_F(VectorFreeDeepTest, WhenVectorHoldsFewerElementsThanItsCapacity) {
+  vector = VectorDefAlloc();
+  size_t* element = (size_t*)malloc(sizeof(size_t) * 1);
+  *element = 0;
+  VectorPush(&vector, element);
+  ASSERT_LT(vector.size, vector.capacity);
+  // Only the elements pushed are freed, along with the buffer holding them.
+  VectorFreeDeep(&vector);
+  ASSERT_EQ(vector.data, nullptr);
+  ASSERT_EQ(vector.size, 0);
+  ASSERT_EQ(vector.capacity, 0);
+}
+
 #endif  // CJSON_TESTS_VECTOR_TESTVECTOR_HH_